@@ -0,0 +1,97 @@
+#include "AssetLoader.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <iostream>
+
+AssetLoader::AssetLoader(unsigned int workerCount) : jobsEnqueued(0), jobsCompleted(0) {
+    if (workerCount == 0) {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+    for (unsigned int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&AssetLoader::workerLoop, this);
+    }
+}
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        cpuQueue.clear();
+    }
+    jobAvailable.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void AssetLoader::enqueue(const std::string& name, std::function<void()> cpuStage, std::function<bool()> uploadStep) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cpuQueue.push_back({ name, std::move(cpuStage), std::move(uploadStep) });
+    }
+    jobsEnqueued++;
+    jobAvailable.notify_one();
+}
+
+void AssetLoader::workerLoop() {
+    Profiler::setThreadName("Asset worker");
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this] { return stopping || !cpuQueue.empty(); });
+            if (stopping) return;
+            job = std::move(cpuQueue.front());
+            cpuQueue.pop_front();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        {
+            PROFILE_ZONE("Asset CPU stage");
+            job.cpuStage();
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Loaded " << job.name << " in " << ms << " ms" << std::endl;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        uploadQueue.push_back(std::move(job));
+    }
+}
+
+bool AssetLoader::processUploads(double budgetMs) {
+    PROFILE_ZONE("Asset uploads");
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedMs = [&start] {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // always make progress on at least one step, even if a single step is larger than the budget
+    do {
+        Job* job = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (uploadQueue.empty()) break;
+            job = &uploadQueue.front();
+        }
+
+        // only the main thread pops the upload queue, so the front job stays put while unlocked
+        if (job->uploadStep()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            uploadQueue.pop_front();
+            jobsCompleted++;
+        }
+    } while (elapsedMs() < budgetMs);
+
+    return isIdle();
+}
+
+bool AssetLoader::isIdle() const {
+    return jobsCompleted.load() == jobsEnqueued.load();
+}
+
+float AssetLoader::progress() const {
+    unsigned int enqueued = jobsEnqueued.load();
+    return enqueued == 0 ? 1.0f : static_cast<float>(jobsCompleted.load()) / enqueued;
+}
@@ -0,0 +1,56 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads assets in two stages so the render loop keeps running while they stream in.
+// The CPU stage (file reads, Assimp import, mesh optimization, image decoding) runs on a pool of worker
+// threads. Once it finishes, the GL stage is called on the main thread from processUploads, one step at
+// a time and only for as long as the per-frame budget allows.
+class AssetLoader {
+public:
+    // workerCount 0 picks one thread less than the hardware has, at least one
+    AssetLoader(unsigned int workerCount = 0);
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // cpuStage must not touch GL. uploadStep runs on the main thread until it returns true.
+    void enqueue(const std::string& name, std::function<void()> cpuStage, std::function<bool()> uploadStep);
+
+    // Main thread only: runs upload steps until budgetMs has been used, returns true when nothing is left
+    bool processUploads(double budgetMs);
+
+    bool isIdle() const;
+    // 0..1 over every job enqueued so far
+    float progress() const;
+
+private:
+    struct Job {
+        std::string name;
+        std::function<void()> cpuStage;
+        std::function<bool()> uploadStep;
+    };
+
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    mutable std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::deque<Job> cpuQueue;      // waiting for a worker
+    std::deque<Job> uploadQueue;   // CPU stage done, waiting for the main thread
+    bool stopping = false;
+
+    std::atomic<unsigned int> jobsEnqueued;
+    std::atomic<unsigned int> jobsCompleted;
+};
+
+#endif
@@ -0,0 +1,241 @@
+#include "Benchmarks.h"
+#include "Car.h"
+#include "TrackGrid.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+
+// each benchmark is timed in several runs of at least this long, the median run is reported
+const double BENCHMARK_MIN_RUN_MS = 100.0;
+const int BENCHMARK_RUNS = 5;
+const int BENCHMARK_SAMPLE_COUNT = 4096;   // random rays, boxes and triangles cycled through per benchmark
+const float BENCHMARK_DELTA_TIME = 1.0f / 60.0f;
+
+struct BenchmarkResult {
+    std::string name;
+    long long iterations;       // operations in the median run
+    double nsPerOp;             // median run
+    double minNsPerOp;
+    long long checksum;         // hits counted by the benchmark, keeps the work from being optimized away
+};
+
+struct BenchmarkRay {
+    glm::vec3 origin;
+    glm::vec3 direction;
+};
+
+// op(i) runs one operation on sample i and returns something to fold into the checksum
+static BenchmarkResult runBenchmark(const std::string& name, const std::function<long long(size_t)>& op) {
+    typedef std::chrono::steady_clock Clock;
+
+    // warm up the caches and find how many operations fill a run
+    long long checksum = 0;
+    long long iterations = 1;
+    while (true) {
+        Clock::time_point start = Clock::now();
+        for (long long i = 0; i < iterations; ++i) checksum += op(static_cast<size_t>(i));
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (ms >= BENCHMARK_MIN_RUN_MS) break;
+        iterations *= 2;
+    }
+
+    std::vector<double> nsPerOp;
+    for (int run = 0; run < BENCHMARK_RUNS; ++run) {
+        Clock::time_point start = Clock::now();
+        for (long long i = 0; i < iterations; ++i) checksum += op(static_cast<size_t>(i));
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        nsPerOp.push_back(ns / iterations);
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.nsPerOp = nsPerOp[nsPerOp.size() / 2];
+    result.minNsPerOp = nsPerOp.front();
+    result.checksum = checksum;
+    std::cout << name << ": " << result.nsPerOp << " ns/op (min " << result.minNsPerOp << ", " << iterations << " ops per run)" << std::endl;
+    return result;
+}
+
+static void trackBounds(const std::vector<CollisionMesh>& meshes, glm::vec3& minBounds, glm::vec3& maxBounds) {
+    minBounds = glm::vec3(FLT_MAX);
+    maxBounds = glm::vec3(-FLT_MAX);
+    for (const CollisionMesh& mesh : meshes) {
+        for (const glm::vec3& position : mesh.positions) {
+            minBounds = glm::min(minBounds, position);
+            maxBounds = glm::max(maxBounds, position);
+        }
+    }
+}
+
+static std::vector<Triangle> sampleTriangles(const std::vector<CollisionMesh>& meshes, std::mt19937& rng) {
+    std::vector<Triangle> all;
+    for (const CollisionMesh& mesh : meshes) {
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            all.push_back({ mesh.positions[mesh.indices[i]], mesh.positions[mesh.indices[i + 1]], mesh.positions[mesh.indices[i + 2]] });
+        }
+    }
+    std::vector<Triangle> samples;
+    if (all.empty()) return samples;
+    std::uniform_int_distribution<size_t> pick(0, all.size() - 1);
+    for (int i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i) samples.push_back(all[pick(rng)]);
+    return samples;
+}
+
+static void writeResults(const std::string& outputPath, unsigned int seed, const std::vector<BenchmarkResult>& results) {
+    std::ofstream file(outputPath, std::ios::trunc);
+    if (!file) {
+        std::cout << "Failed to write benchmark results " << outputPath << std::endl;
+        return;
+    }
+    file << "{\n  \"seed\": " << seed << ",\n  \"minRunMs\": " << BENCHMARK_MIN_RUN_MS << ",\n  \"runs\": " << BENCHMARK_RUNS
+         << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& result = results[i];
+        file << "    { \"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+             << ", \"nsPerOp\": " << result.nsPerOp << ", \"minNsPerOp\": " << result.minNsPerOp
+             << ", \"checksum\": " << result.checksum << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    std::cout << "Benchmark results written to " << outputPath << std::endl;
+}
+
+int runPhysicsBenchmarks(const std::vector<CollisionMesh>& trackMeshes, const std::vector<CollisionMesh>& trackCollisionMeshes,
+    const CarConfig& carConfig, int gridCount, const std::string& outputPath, unsigned int seed) {
+    if (trackMeshes.empty() || trackCollisionMeshes.empty()) {
+        std::cout << "Benchmark track meshes failed to load" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(seed);
+    std::vector<BenchmarkResult> results;
+
+    glm::vec3 minBounds, maxBounds;
+    trackBounds(trackMeshes, minBounds, maxBounds);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto randomPoint = [&] {
+        return glm::vec3(glm::mix(minBounds.x, maxBounds.x, unit(rng)), glm::mix(minBounds.y, maxBounds.y, unit(rng)) + 2.0f,
+            glm::mix(minBounds.z, maxBounds.z, unit(rng)));
+    };
+
+    // grid construction, the startup cost of the collision data
+    int gridWidth = gridCount;
+    int gridHeight = gridCount;
+    results.push_back(runBenchmark("calculateOptimalGridSize", [&](size_t) {
+        return static_cast<long long>(calculateOptimalGridSize(trackMeshes, gridHeight));
+    }));
+    float gridSize = calculateOptimalGridSize(trackMeshes, gridHeight);
+    results.push_back(runBenchmark("assignTrianglesToGrid", [&](size_t) {
+        std::vector<std::vector<Triangle>> cells;
+        assignTrianglesToGrid(trackMeshes, gridSize, gridWidth, gridHeight, cells);
+        return static_cast<long long>(cells.size());
+    }));
+
+    std::vector<std::vector<Triangle>> gridCells, gridCellsCollision;
+    assignTrianglesToGrid(trackMeshes, gridSize, gridWidth, gridHeight, gridCells);
+    assignTrianglesToGrid(trackCollisionMeshes, gridSize, gridWidth, gridHeight, gridCellsCollision);
+    CollisionChecker checker;
+    checker.setGrid(gridCells, gridCellsCollision, gridSize, gridWidth, gridHeight);
+
+    // single triangle tests, each ray aims at a point inside its triangle from above
+    std::vector<Triangle> triangles = sampleTriangles(trackMeshes, rng);
+    std::vector<BenchmarkRay> triangleRays;
+    std::vector<AABB> triangleBoxes;
+    for (const Triangle& tri : triangles) {
+        float a = unit(rng), b = unit(rng) * (1.0f - a);
+        glm::vec3 target = tri.v0 + a * (tri.v1 - tri.v0) + b * (tri.v2 - tri.v0);
+        glm::vec3 origin = target + glm::vec3(unit(rng) - 0.5f, 1.0f + unit(rng), unit(rng) - 0.5f);
+        triangleRays.push_back({ origin, glm::normalize(target - origin) });
+
+        AABB box(glm::vec3(1.0f, 0.3f, 1.2f));
+        box.update(glm::rotate(glm::translate(glm::mat4(1.0f), target + glm::vec3(0.0f, unit(rng), 0.0f)),
+            unit(rng) * glm::two_pi<float>(), glm::vec3(0.0f, 1.0f, 0.0f)));
+        triangleBoxes.push_back(box);
+    }
+    results.push_back(runBenchmark("intersectRayWithTriangle", [&](size_t i) {
+        size_t s = i % triangles.size();
+        float t;
+        const Triangle& tri = triangles[s];
+        return static_cast<long long>(checker.intersectRayWithTriangle(triangleRays[s].origin, triangleRays[s].direction, tri.v0, tri.v1, tri.v2, t));
+    }));
+    results.push_back(runBenchmark("intersectAABBWithTriangle", [&](size_t i) {
+        size_t s = i % triangles.size();
+        return static_cast<long long>(checker.intersectAABBWithTriangle(triangleBoxes[s], triangles[s]));
+    }));
+
+    // grid queries, downward rays like the wheel rays and car sized boxes anywhere over the track
+    std::vector<BenchmarkRay> gridRays;
+    std::vector<AABB> gridBoxes;
+    for (int i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i) {
+        glm::vec3 origin = randomPoint();
+        gridRays.push_back({ origin, glm::vec3(0.0f, -1.0f, 0.0f) });
+
+        AABB box(glm::vec3(1.0f, 0.3f, 1.2f));
+        box.update(glm::rotate(glm::translate(glm::mat4(1.0f), origin), unit(rng) * glm::two_pi<float>(), glm::vec3(0.0f, 1.0f, 0.0f)));
+        gridBoxes.push_back(box);
+    }
+    results.push_back(runBenchmark("checkTrackIntersectionWithGrid ray", [&](size_t i) {
+        glm::vec3 point;
+        const BenchmarkRay& ray = gridRays[i % gridRays.size()];
+        return static_cast<long long>(checker.checkTrackIntersectionWithGrid(ray.origin, ray.direction, point));
+    }));
+    results.push_back(runBenchmark("checkTrackIntersectionWithGrid AABB", [&](size_t i) {
+        return static_cast<long long>(checker.checkTrackIntersectionWithGrid(gridBoxes[i % gridBoxes.size()]));
+    }));
+
+    // wheel transforms, four per car per frame
+    Wheel wheel(carConfig.frontLeftWheelOffset, true);
+    std::vector<glm::mat4> carMatrices;
+    for (int i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i) {
+        carMatrices.push_back(glm::rotate(glm::translate(glm::mat4(1.0f), randomPoint()), unit(rng) * glm::two_pi<float>(), glm::vec3(0.0f, 1.0f, 0.0f)));
+    }
+    results.push_back(runBenchmark("Wheel::updateModelMatrix", [&](size_t i) {
+        wheel.setSteeringAngle(static_cast<float>(i % 60) - 30.0f);
+        wheel.updateModelMatrix(carMatrices[i % carMatrices.size()], carConfig.wheelScale, (i & 1) != 0);
+        return static_cast<long long>(wheel.getModelMatrix()[3][0]);
+    }));
+
+    // full car steps, one op is a frame of every car, accelerating from the start line and reset
+    // before it can leave the track so each run sees the same mix of driving and collisions
+    const int carCounts[] = { 1, 2, 4, 8, 16 };
+    const size_t STEPS_BEFORE_RESET = 300;
+    for (int carCount : carCounts) {
+        std::vector<CarConfig> configs;
+        std::vector<std::unique_ptr<Car>> cars;
+        for (int c = 0; c < carCount; ++c) {
+            CarConfig config = carConfig;
+            config.startPosition += glm::vec3((c % 4) * 2.5f, 0.0f, (c / 4) * -6.0f);
+            configs.push_back(config);
+            cars.emplace_back(new Car(config));
+            cars.back()->setCollisionGrid(gridCells, gridCellsCollision, gridSize, gridWidth, gridHeight);
+        }
+        results.push_back(runBenchmark("Car::update x" + std::to_string(carCount), [&](size_t i) {
+            long long sum = 0;
+            for (size_t c = 0; c < cars.size(); ++c) {
+                Car* car = cars[c].get();
+                if (i % STEPS_BEFORE_RESET == 0) {
+                    car->applyConfig(configs[c]);
+                    car->moveToStartPosition();
+                    car->activate();
+                }
+                car->accelerate(BENCHMARK_DELTA_TIME);
+                car->updateModelMatrix(BENCHMARK_DELTA_TIME);
+                car->update(BENCHMARK_DELTA_TIME);
+                sum += static_cast<long long>(car->getPosition().z);
+            }
+            return sum;
+        }));
+    }
+
+    writeResults(outputPath, seed, results);
+    return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <string>
+#include <vector>
+
+#include "Carconfig.h"
+#include "CollisionChecker.h"
+
+// Microbenchmarks of the collision and car physics code, run with --benchmark-physics [output.json].
+// Every input is drawn from a std::mt19937 with a fixed seed, so two runs on the same machine time the same
+// rays, boxes and triangles and their results can be compared. Results go to stdout and to a JSON file.
+int runPhysicsBenchmarks(const std::vector<CollisionMesh>& trackMeshes, const std::vector<CollisionMesh>& trackCollisionMeshes,
+    const CarConfig& carConfig, int gridCount, const std::string& outputPath, unsigned int seed);
+
+#endif
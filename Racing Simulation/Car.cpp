@@ -1,21 +1,13 @@
 #include "Car.h"
+#include "Profiler.h"
 
 const float SHARP_TURN_SPEED_THRESHOLD = 50.0f; // speed in km/h
 const float SHARP_TURN_ANGLE_THRESHOLD = 30.0f; // angle in degrees
-float currentPitch;
-float currentRoll;
-// Define additional attributes for pitch control
-float pitchControl = 0.0f;  // Delta change for pitch
-const float PITCH_CONTROL_SPEED = 0.05f;  // Speed at which pitch is adjusted
-const float MAX_PITCH_ANGLE = 10.0f;  // Maximum pitch angle in degre
-
-bool isAirborne = false;
-float verticalVelocity = 0.0f;
-float forwardVelocity = 0.0f;  // Forward velocity for jumping
+
 const float baseGravity = 9.8f;
 const float jumpThresholdSpeed = 5.0f;
 const float pitchJumpThreshold = 0.1f;
-float verticalVelocityFactor = 0.1f;
+const float verticalVelocityFactor = 0.1f;
 
 Car::Car(const CarConfig& config)
     : position(config.position), startPosition(config.startPosition), bodyOffset(config.bodyOffset), bodyScale(config.bodyScale), direction(config.direction), rotation(config.rotation),
@@ -87,7 +79,35 @@ void Car::setCollisionGrid(const std::vector<std::vector<Triangle>>& gridCells,
     collisionChecker.setGrid(gridCells, gridCellsCollision, gridSize, gridWidth, gridHeight);
 }
 
+void Car::drive(const DriveInput& input, float deltaTime) {
+    if (input.accelerate) {
+        accelerate(deltaTime);
+    }
+    if (input.brake) {
+        brake(deltaTime);
+    }
+    if (!input.accelerate && !input.brake) {
+        slowDown(deltaTime);
+    }
+
+    // Steering
+    if (input.steerLeft) {
+        steerLeft(deltaTime);
+    }
+    if (input.steerRight) {
+        steerRight(deltaTime);
+    }
+    if (!input.steerLeft && !input.steerRight) {
+        centerSteering(deltaTime);
+    }
+
+    // Update car position and direction
+    updatePositionAndDirection(deltaTime);
+    updateWheelRotations(deltaTime);
+}
+
 void Car::update(float deltaTime) {
+    PROFILE_ZONE("Car::update");
 
     if (rotatingForSelection) {
         rotateForSelection(deltaTime);
@@ -116,6 +136,7 @@ void Car::initializeModelMatrix() {
 }
 
 void Car::updateModelMatrix(float deltaTime) {
+    PROFILE_ZONE("Car::updateModelMatrix");
     sideCollisionAABB.update(modelMatrix);
 
     bool sideCollision = collisionChecker.checkTrackIntersectionWithGrid(sideCollisionAABB);
@@ -125,6 +146,7 @@ void Car::updateModelMatrix(float deltaTime) {
         glm::vec3 correction = correctionDirection * 0.3f;
         position += correction;
         speed *= 0.5f;
+        sideCorrections++;
     }
     else {
         position = nextPosition;
@@ -148,6 +170,7 @@ void Car::updateModelMatrix(float deltaTime) {
     bool backLeftCollision = collisionChecker.checkTrackIntersectionWithGrid(backLeftWheelRayOrigin, downwardRayDirection, backLeftWheelIntersection);
     bool backRightCollision = collisionChecker.checkTrackIntersectionWithGrid(backRightWheelRayOrigin, downwardRayDirection, backRightWheelIntersection);
 
+    wheelContacts = (frontLeftCollision ? 1 : 0) | (frontRightCollision ? 2 : 0) | (backLeftCollision ? 4 : 0) | (backRightCollision ? 8 : 0);
     bool wheelsTouchingGround = frontLeftCollision || frontRightCollision || backLeftCollision || backRightCollision;
     if (!wheelsTouchingGround && !isAirborne) {
         isAirborne = true;
@@ -339,6 +362,22 @@ float Car::getSteeringAngle() const {
     return (frontLeftWheel.steeringAngle + frontRightWheel.steeringAngle) / 2.0f;
 }
 
+void Car::takeTelemetry(TelemetrySample& sample) {
+    sample.position = position;
+    sample.speed = speed;
+    sample.steeringAngle = getSteeringAngle();
+    sample.pitch = currentPitch;
+    sample.roll = currentRoll;
+    sample.airborne = isAirborne;
+    sample.wheelContacts = wheelContacts;
+    sample.wheelHeights[0] = frontLeftWheelIntersection.y;
+    sample.wheelHeights[1] = frontRightWheelIntersection.y;
+    sample.wheelHeights[2] = backLeftWheelIntersection.y;
+    sample.wheelHeights[3] = backRightWheelIntersection.y;
+    sample.corrections = sideCorrections;
+    sideCorrections = 0;
+}
+
 void Car::updatePositionAndDirection(float deltaTime) {
 
     // Update the car's direction based on the rotation (yaw)
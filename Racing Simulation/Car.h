@@ -6,6 +6,8 @@
 #include "CollisionChecker.h"
 #include <vector>
 #include "Carconfig.h"
+#include "DriveInput.h"
+#include "TelemetryFormat.h"
 #include <iostream>
 
 
@@ -29,6 +31,9 @@ public:
     glm::mat4 getBackRightWheelModelMatrix() const;
     bool isActive() const;
 
+    // one frame of driver input, the same for the keyboard and replayed scripts
+    void drive(const DriveInput& input, float deltaTime);
+
     // Movement and steering methods
     void accelerate(float deltaTime);
     void brake(float deltaTime);
@@ -42,6 +47,8 @@ public:
     void updateWheelRotations(float deltaTime);
     void updatePositionAndDirection(float deltaTime);
     float getSteeringAngle() const;
+    // state of the last tick for the telemetry, also restarts the per tick counters
+    void takeTelemetry(TelemetrySample& sample);
     void setCollisionGrid(const std::vector<std::vector<Triangle>>& gridCells,const std::vector<std::vector<Triangle>>& gridCellsCollision, float gridSize, int gridWidth, int gridHeight);
 
 
@@ -84,8 +91,12 @@ private:
     Wheel backLeftWheel;
     Wheel backRightWheel;
 
-    float currentPitch;
-    float currentRoll;
+    float currentPitch = 0.0f;
+    float currentRoll = 0.0f;
+    bool isAirborne = false;
+    float verticalVelocity = 0.0f;
+    uint8_t wheelContacts = 0;          // wheel rays that hit the track in the last update, bit per wheel
+    uint16_t sideCorrections = 0;       // side collision push backs since the last takeTelemetry()
     // Define additional attributes for pitch control
     float pitchControl = 0.0f;  // Delta change for pitch
     const float PITCH_CONTROL_SPEED = 0.05f;  // Speed at which pitch is adjusted
@@ -0,0 +1,198 @@
+#include "CascadedShadowMap.h"
+#include "MemoryAccounting.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+// far view distance of each cascade, anything beyond the last split is unshadowed
+const float CASCADE_SPLITS[SHADOW_CASCADE_COUNT] = { 15.0f, 45.0f, 120.0f };
+// cascade centres move in steps of this many texels, and the same number of texels is kept as a
+// guard band on every side so the frustum slice stays covered between steps
+const float SNAP_TEXELS = 32.0f;
+// light-space depth range around the origin, large enough to contain the whole track
+const float SCENE_DEPTH = 400.0f;
+
+// Bounding sphere of the frustum slice between sliceNear and sliceFar, returns the radius and writes
+// the distance of the sphere centre along the view direction
+static float sliceBoundingSphere(float sliceNear, float sliceFar, float fovY, float aspect, float& centerDistance) {
+    float tanY = std::tan(fovY * 0.5f);
+    float tanX = tanY * aspect;
+    float k2 = tanX * tanX + tanY * tanY;  // squared corner offset per unit of depth
+
+    // equidistant from the near and far corners, clamped so it never lies beyond the far plane
+    centerDistance = std::min(0.5f * (sliceNear + sliceFar) * (1.0f + k2), sliceFar);
+    float dz = sliceFar - centerDistance;
+    return std::sqrt(dz * dz + sliceFar * sliceFar * k2);
+}
+
+CascadedShadowMap::CascadedShadowMap(unsigned int resolution, const glm::vec3& lightDirection)
+    : resolution(resolution), lightDirection(glm::normalize(lightDirection)) {
+    glm::vec3 up = std::abs(this->lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    lightRotation = glm::lookAt(glm::vec3(0.0f), this->lightDirection, up);
+
+    GLuint* textures[] = { &staticDepth, &dynamicDepth };
+    GLuint* framebuffers[] = { staticFBOs, dynamicFBOs };
+    for (int t = 0; t < 2; ++t) {
+        glGenTextures(1, textures[t]);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, *textures[t]);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, resolution, resolution, SHADOW_CASCADE_COUNT, 0,
+            GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        MemoryAccounting::get().set(textures[t], MemoryCategory::ShadowMaps, t == 0 ? "static shadow cascades" : "dynamic shadow cascades",
+            0, gpuTextureBytes(GL_DEPTH_COMPONENT24, resolution, resolution, 1, SHADOW_CASCADE_COUNT));
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        // hardware depth comparison, the PBR shader samples it through a sampler2DArrayShadow
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+        glGenFramebuffers(SHADOW_CASCADE_COUNT, framebuffers[t]);
+        for (int c = 0; c < SHADOW_CASCADE_COUNT; ++c) {
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[t][c]);
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, *textures[t], 0, c);
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    for (int c = 0; c < SHADOW_CASCADE_COUNT; ++c) {
+        cascades[c].splitDistance = CASCADE_SPLITS[c];
+    }
+}
+
+CascadedShadowMap::~CascadedShadowMap() {
+    glDeleteFramebuffers(SHADOW_CASCADE_COUNT, staticFBOs);
+    glDeleteFramebuffers(SHADOW_CASCADE_COUNT, dynamicFBOs);
+    glDeleteTextures(1, &staticDepth);
+    glDeleteTextures(1, &dynamicDepth);
+    MemoryAccounting::get().remove(&staticDepth, MemoryCategory::ShadowMaps);
+    MemoryAccounting::get().remove(&dynamicDepth, MemoryCategory::ShadowMaps);
+}
+
+void CascadedShadowMap::update(const glm::vec3& cameraPosition, const glm::vec3& cameraFront, float fovY, float aspect, float nearPlane) {
+    float sliceNear = nearPlane;
+    for (int c = 0; c < SHADOW_CASCADE_COUNT; ++c) {
+        Cascade& cascade = cascades[c];
+
+        // the sphere radius only depends on the projection, so the cascade size (and texel size) stays
+        // fixed while the camera rotates and the cached depth stays valid
+        float centerDistance;
+        float radius = sliceBoundingSphere(sliceNear, cascade.splitDistance, fovY, aspect, centerDistance);
+        float halfExtent = radius / (1.0f - 2.0f * SNAP_TEXELS / resolution);
+        float snapStep = SNAP_TEXELS * 2.0f * halfExtent / resolution;
+
+        glm::vec3 center = cameraPosition + cameraFront * centerDistance;
+        glm::vec3 lightSpaceCenter = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+        glm::vec2 snappedCenter = glm::floor(glm::vec2(lightSpaceCenter) / snapStep + 0.5f) * snapStep;
+
+        if (snappedCenter != cascade.snappedCenter || halfExtent != cascade.halfExtent) {
+            cascade.snappedCenter = snappedCenter;
+            cascade.halfExtent = halfExtent;
+            cascade.staticDirty = true;
+
+            glm::mat4 lightProjection = glm::ortho(snappedCenter.x - halfExtent, snappedCenter.x + halfExtent,
+                snappedCenter.y - halfExtent, snappedCenter.y + halfExtent, -SCENE_DEPTH, SCENE_DEPTH);
+            cascade.lightSpaceMatrix = lightProjection * lightRotation;
+        }
+        sliceNear = cascade.splitDistance;
+    }
+}
+
+bool CascadedShadowMap::needsStaticUpdate(int cascade) const {
+    return cascades[cascade].staticDirty;
+}
+
+void CascadedShadowMap::beginPass(GLuint framebuffer) {
+    glGetIntegerv(GL_VIEWPORT, savedViewport);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, resolution, resolution);
+    // slope scaled offset against shadow acne on the track surface
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+}
+
+void CascadedShadowMap::beginStaticPass(int cascade, Shader& depthShader) {
+    beginPass(staticFBOs[cascade]);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    depthShader.use();
+    depthShader.setMat4("lightSpaceMatrix", cascades[cascade].lightSpaceMatrix);
+}
+
+void CascadedShadowMap::endStaticPass(int cascade) {
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    cascades[cascade].staticDirty = false;
+    // the whole layer is fresh, so last frame's caster regions no longer need restoring
+    cascades[cascade].casterRegions.clear();
+    copyStaticRegion(cascade, glm::ivec4(0, 0, resolution, resolution));
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+}
+
+void CascadedShadowMap::copyStaticRegion(int cascade, const glm::ivec4& region) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, staticFBOs[cascade]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dynamicFBOs[cascade]);
+    glBlitFramebuffer(region.x, region.y, region.x + region.z, region.y + region.w,
+        region.x, region.y, region.x + region.z, region.y + region.w, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+}
+
+void CascadedShadowMap::beginCasterPasses() {
+    for (int c = 0; c < SHADOW_CASCADE_COUNT; ++c) {
+        for (const glm::ivec4& region : cascades[c].casterRegions) {
+            copyStaticRegion(c, region);
+        }
+        cascades[c].casterRegions.clear();
+    }
+    beginPass(0);
+    glEnable(GL_SCISSOR_TEST);
+}
+
+bool CascadedShadowMap::beginCaster(int cascade, const glm::vec3& center, float radius, Shader& depthShader) {
+    Cascade& data = cascades[cascade];
+    float texelsPerUnit = resolution / (2.0f * data.halfExtent);
+
+    glm::vec2 lightSpaceCenter = glm::vec2(lightRotation * glm::vec4(center, 1.0f));
+    glm::vec2 texelCenter = (lightSpaceCenter - data.snappedCenter + data.halfExtent) * texelsPerUnit;
+    float texelRadius = radius * texelsPerUnit + 1.0f;
+
+    int x0 = std::max(0, static_cast<int>(std::floor(texelCenter.x - texelRadius)));
+    int y0 = std::max(0, static_cast<int>(std::floor(texelCenter.y - texelRadius)));
+    int x1 = std::min(static_cast<int>(resolution), static_cast<int>(std::ceil(texelCenter.x + texelRadius)));
+    int y1 = std::min(static_cast<int>(resolution), static_cast<int>(std::ceil(texelCenter.y + texelRadius)));
+    if (x0 >= x1 || y0 >= y1) return false;
+
+    glm::ivec4 region(x0, y0, x1 - x0, y1 - y0);
+    data.casterRegions.push_back(region);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, dynamicFBOs[cascade]);
+    glScissor(region.x, region.y, region.z, region.w);
+    depthShader.use();
+    depthShader.setMat4("lightSpaceMatrix", data.lightSpaceMatrix);
+    return true;
+}
+
+void CascadedShadowMap::endCasterPasses() {
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+}
+
+void CascadedShadowMap::bindForSampling(Shader& shader, unsigned int textureUnit) const {
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, dynamicDepth);
+
+    shader.setInt("shadowMap", textureUnit);
+    shader.setVec3("sunDirection", lightDirection);
+    for (int c = 0; c < SHADOW_CASCADE_COUNT; ++c) {
+        std::string index = "[" + std::to_string(c) + "]";
+        shader.setMat4("lightSpaceMatrices" + index, cascades[c].lightSpaceMatrix);
+        shader.setFloat("cascadeSplits" + index, cascades[c].splitDistance);
+        // world size of one texel, used to push the lookup along the normal
+        shader.setFloat("cascadeTexelSizes" + index, 2.0f * cascades[c].halfExtent / resolution);
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef CASCADED_SHADOW_MAP_H
+#define CASCADED_SHADOW_MAP_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "shader_m.h"
+
+const int SHADOW_CASCADE_COUNT = 3;
+
+// Sun shadows split into cascades along the view direction.
+// The static track is rendered into a cached depth layer per cascade that is only re-rendered when the
+// cascade re-centres (the camera has moved a whole snap step of texels). Every frame the cached depth is
+// copied back over the small regions the cars touched last frame, and the cars are drawn again into
+// their own scissored region, so the track never has to be re-rendered just because a car moved.
+class CascadedShadowMap {
+public:
+    struct Cascade {
+        glm::mat4 lightSpaceMatrix = glm::mat4(1.0f);
+        glm::vec2 snappedCenter = glm::vec2(0.0f);  // light-space xy of the cascade centre, multiple of the snap step
+        float halfExtent = 0.0f;                    // half width of the orthographic projection
+        float splitDistance = 0.0f;                 // far view-space distance covered by this cascade
+        bool staticDirty = true;
+        std::vector<glm::ivec4> casterRegions;      // x, y, width, height rendered over the static depth last frame
+    };
+
+    CascadedShadowMap(unsigned int resolution, const glm::vec3& lightDirection);
+    ~CascadedShadowMap();
+
+    // Fits every cascade to the camera frustum, marking cascades whose snapped centre moved as dirty
+    void update(const glm::vec3& cameraPosition, const glm::vec3& cameraFront, float fovY, float aspect, float nearPlane);
+
+    bool needsStaticUpdate(int cascade) const;
+    void beginStaticPass(int cascade, Shader& depthShader);
+    void endStaticPass(int cascade);
+
+    // Restores the static depth under last frame's caster regions, must run once before the caster passes
+    void beginCasterPasses();
+    // Scissors rendering to the region of the bounding sphere, returns false if it lies outside the cascade
+    bool beginCaster(int cascade, const glm::vec3& center, float radius, Shader& depthShader);
+    void endCasterPasses();
+
+    // Binds the depth array to textureUnit and uploads the cascade matrices and splits
+    void bindForSampling(Shader& shader, unsigned int textureUnit) const;
+
+    const glm::vec3& getLightDirection() const { return lightDirection; }
+    const Cascade& getCascade(int cascade) const { return cascades[cascade]; }
+
+private:
+    void copyStaticRegion(int cascade, const glm::ivec4& region);
+    void beginPass(GLuint framebuffer);
+
+    unsigned int resolution;
+    glm::vec3 lightDirection;
+    glm::mat4 lightRotation;
+    Cascade cascades[SHADOW_CASCADE_COUNT];
+
+    GLuint staticDepth = 0;                        // track only, re-rendered when a cascade re-centres
+    GLuint dynamicDepth = 0;                       // static depth plus cars, sampled by the PBR shader
+    GLuint staticFBOs[SHADOW_CASCADE_COUNT] = {};
+    GLuint dynamicFBOs[SHADOW_CASCADE_COUNT] = {};
+
+    GLint savedViewport[4] = {};
+};
+
+#endif
@@ -1,6 +1,10 @@
 
 
 #include "CollisionChecker.h"
+#include "Profiler.h"
+#include "CollisionStats.h"
+
+#include <algorithm>
 
 // Custom Min and Max for float
 float customMin(float a, float b) {
@@ -34,10 +38,12 @@ void CollisionChecker::setGrid(const std::vector<std::vector<Triangle>>& externa
     this->gridSize = gridSize;
     this->gridWidth = gridWidth;
     this->gridHeight = gridHeight;
+    collisionStats.setCellCount(gridWidth * gridHeight);
 }
 
 
 bool CollisionChecker::checkTrackIntersectionWithGrid(glm::vec3 rayOrigin, glm::vec3 rayDirection, glm::vec3& intersectionPoint) {
+    PROFILE_ZONE("Collision ray query");
 
     if (!gridCells) return false;
 
@@ -55,7 +61,8 @@ bool CollisionChecker::checkTrackIntersectionWithGrid(glm::vec3 rayOrigin, glm::
     bool hasIntersection = false;
 
     // Iterate over the triangles in the target grid cell
-    for (const Triangle& tri : (*gridCells)[cellIndex]) {
+    const std::vector<Triangle>& cellTriangles = (*gridCells)[cellIndex];
+    for (const Triangle& tri : cellTriangles) {
         float t;
         if (intersectRayWithTriangle(rayOrigin, rayDirection, tri.v0, tri.v1, tri.v2, t)) {
             if (t < closestT) {
@@ -66,10 +73,16 @@ bool CollisionChecker::checkTrackIntersectionWithGrid(glm::vec3 rayOrigin, glm::
         }
     }
 
+    unsigned int tested = static_cast<unsigned int>(cellTriangles.size());
+    collisionStats.addCellTests(cellIndex, tested);
+    collisionStats.addQuery(CollisionQueryType::Ray, tested, hasIntersection);
     return hasIntersection;
 }
 
 bool CollisionChecker::checkTrackIntersectionWithGrid(const AABB& aabb) {
+    PROFILE_ZONE("Collision AABB query");
+
+    if (!gridCellsCollision || gridCellsCollision->empty()) return false;
 
     int minGridX = static_cast<int>(std::floor(aabb.min.x / gridSize));
     int maxGridX = static_cast<int>(std::floor(aabb.max.x / gridSize));
@@ -82,22 +95,30 @@ bool CollisionChecker::checkTrackIntersectionWithGrid(const AABB& aabb) {
     maxGridZ = clamp(maxGridZ, 0, gridHeight - 1);
 
 
+    unsigned int tested = 0;
     for (int x = minGridX; x <= maxGridX; ++x) {
         for (int z = minGridZ; z <= maxGridZ; ++z) {
 
             int cellIndex = z * gridWidth + x;
+            unsigned int cellTested = 0;
 
             for (const Triangle& tri : (*gridCellsCollision)[cellIndex]) {
 
+                cellTested++;
                 if (intersectAABBWithTriangle(aabb, tri)) {
+                    collisionStats.addCellTests(cellIndex, cellTested);
+                    collisionStats.addQuery(CollisionQueryType::AABB, tested + cellTested, true);
                     return true;
                 }
 
             }
 
+            collisionStats.addCellTests(cellIndex, cellTested);
+            tested += cellTested;
         }
     }
 
+    collisionStats.addQuery(CollisionQueryType::AABB, tested, false);
     return false;  // No collision detected
 }
 
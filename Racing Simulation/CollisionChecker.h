@@ -8,6 +8,12 @@ struct Triangle {
     glm::vec3 v0, v1, v2;
 };
 
+// CPU side triangles of one mesh, for the collision grid
+struct CollisionMesh {
+    std::vector<glm::vec3> positions;
+    std::vector<unsigned int> indices;
+};
+
 
 struct AABB {
     std::vector<glm::vec3> localCorners;  // Predefined corner coordinates
@@ -69,11 +75,13 @@ public:
     bool checkTrackIntersectionWithGrid(glm::vec3 rayOrigin, glm::vec3 rayDirection, glm::vec3& intersectionPoint);
     bool checkTrackIntersectionWithGrid(const AABB& aabb);
 
+    // single triangle tests behind the grid queries, public for the benchmarks
+    bool intersectRayWithTriangle(glm::vec3 rayOrigin, glm::vec3 rayDirection, glm::vec3 v0, glm::vec3 v1, glm::vec3 v2, float& t);
+    bool intersectAABBWithTriangle(const AABB& aabb, const Triangle& tri);
+
 private:
 
     bool overlapOnAxis(const glm::vec3& aabbHalfSize, const glm::vec3& axis, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
-    bool intersectRayWithTriangle(glm::vec3 rayOrigin, glm::vec3 rayDirection, glm::vec3 v0, glm::vec3 v1, glm::vec3 v2, float& t);
-    bool intersectAABBWithTriangle(const AABB& aabb, const Triangle& tri);
 
     const std::vector<std::vector<Triangle>>* gridCells;
     const std::vector<std::vector<Triangle>>* gridCellsCollision;
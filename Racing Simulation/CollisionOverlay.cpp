@@ -0,0 +1,122 @@
+#include "CollisionOverlay.h"
+#include "CollisionStats.h"
+#include "TextRenderer.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+// cold to hot
+static const glm::vec3 HEAT_COLORS[] = {
+    glm::vec3(0.15f, 0.2f, 0.5f),
+    glm::vec3(0.1f, 0.5f, 0.7f),
+    glm::vec3(0.2f, 0.7f, 0.3f),
+    glm::vec3(0.8f, 0.8f, 0.2f),
+    glm::vec3(0.9f, 0.5f, 0.1f),
+    glm::vec3(0.9f, 0.15f, 0.1f)
+};
+static const int HEAT_STEPS = sizeof(HEAT_COLORS) / sizeof(HEAT_COLORS[0]);
+
+void CollisionOverlay::cycleMode() {
+    mode = static_cast<CollisionOverlayMode>((static_cast<int>(mode) + 1) % static_cast<int>(CollisionOverlayMode::Count));
+}
+
+void CollisionOverlay::draw(Shader& textShader, const std::vector<std::vector<Triangle>>& surfaceCells, const std::vector<std::vector<Triangle>>& wallCells,
+    int gridWidth, int gridHeight, float gridSize, glm::vec3 carPosition) {
+    if (!isVisible() || gridWidth <= 0 || gridHeight <= 0) return;
+
+    const float left = 20.0f;
+    const float bottom = 20.0f;
+    const float cellPixels = 36.0f;
+    const float lineHeight = 22.0f;
+    const float scale = 0.45f;
+    const glm::vec3 textColor(0.8f, 1.0f, 0.8f);
+    int cellCount = gridWidth * gridHeight;
+    bool haveGrid = static_cast<int>(surfaceCells.size()) == cellCount && static_cast<int>(wallCells.size()) == cellCount &&
+        static_cast<int>(collisionStats.cellRecentCost.size()) == cellCount;
+
+    std::vector<float> values(cellCount, 0.0f);
+    size_t mostTriangles = 0, totalTriangles = 0;
+    if (haveGrid) {
+        for (int cell = 0; cell < cellCount; ++cell) {
+            size_t triangles = surfaceCells[cell].size() + wallCells[cell].size();
+            mostTriangles = std::max(mostTriangles, triangles);
+            totalTriangles += triangles;
+            values[cell] = mode == CollisionOverlayMode::Triangles ? static_cast<float>(triangles) : collisionStats.cellRecentCost[cell];
+        }
+    }
+    float maxValue = std::max(1.0f, *std::max_element(values.begin(), values.end()));
+
+    // one draw per heat step, z grows up the screen like a map seen from above
+    std::vector<glm::vec4> rects[HEAT_STEPS];
+    for (int z = 0; z < gridHeight; ++z) {
+        for (int x = 0; x < gridWidth; ++x) {
+            float value = values[z * gridWidth + x];
+            int step = std::min(HEAT_STEPS - 1, static_cast<int>(value / maxValue * HEAT_STEPS));
+            rects[step].push_back(glm::vec4(left + x * cellPixels, bottom + z * cellPixels, cellPixels - 2.0f, cellPixels - 2.0f));
+        }
+    }
+    for (int step = 0; step < HEAT_STEPS; ++step) {
+        if (!rects[step].empty()) RenderRects(textShader, rects[step], HEAT_COLORS[step]);
+    }
+    if (haveGrid && gridSize > 0.0f) {
+        float carX = left + carPosition.x / gridSize * cellPixels;
+        float carY = bottom + carPosition.z / gridSize * cellPixels;
+        RenderRects(textShader, { glm::vec4(carX - 3.0f, carY - 3.0f, 6.0f, 6.0f) }, glm::vec3(1.0f));
+    }
+
+    // text column right of the map, top line first
+    float textLeft = left + gridWidth * cellPixels + 20.0f;
+    float y = bottom + gridHeight * cellPixels - lineHeight;
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1);
+
+    line << (mode == CollisionOverlayMode::Triangles ? "Grid: triangles per cell" : "Grid: triangles tested per tick")
+         << "  (max " << maxValue << ")  " << gridWidth << "x" << gridHeight << " cells of " << gridSize;
+    RenderText(textShader, line.str(), textLeft, y, scale, textColor);
+
+    y -= lineHeight;
+    line.str("");
+    float meanTriangles = cellCount ? static_cast<float>(totalTriangles) / cellCount : 0.0f;
+    line << "Triangles per cell mean " << meanTriangles << "  max " << mostTriangles;
+    RenderText(textShader, line.str(), textLeft, y, scale, textColor);
+
+    y -= lineHeight;
+    line.str("");
+    unsigned long long rayQueries = collisionStats.rayHits + collisionStats.rayMisses;
+    unsigned long long aabbQueries = collisionStats.aabbHits + collisionStats.aabbMisses;
+    line << "Queries/tick ray " << collisionStats.rayQueriesLastTick << "  box " << collisionStats.aabbQueriesLastTick
+         << "   hit ray " << (rayQueries ? 100.0 * collisionStats.rayHits / rayQueries : 0.0) << "%  box "
+         << (aabbQueries ? 100.0 * collisionStats.aabbHits / aabbQueries : 0.0) << "%";
+    RenderText(textShader, line.str(), textLeft, y, scale, textColor);
+
+    y -= lineHeight;
+    line.str("");
+    unsigned long long queries = collisionStats.queries();
+    line << "Triangles per query " << (queries ? static_cast<double>(collisionStats.trianglesTested) / queries : 0.0);
+    RenderText(textShader, line.str(), textLeft, y, scale, textColor);
+
+    // histogram, bucket b holds 2^(b-1) to 2^b - 1 triangles
+    const float barWidth = 16.0f;
+    const float histogramHeight = 60.0f;
+    y -= lineHeight + histogramHeight;
+    unsigned long long largest = 1;
+    for (unsigned long long count : collisionStats.histogram) largest = std::max(largest, count);
+    std::vector<glm::vec4> bars;
+    for (int bucket = 0; bucket < CollisionStats::HISTOGRAM_BUCKETS; ++bucket) {
+        float height = static_cast<float>(collisionStats.histogram[bucket]) / largest * histogramHeight;
+        bars.push_back(glm::vec4(textLeft + bucket * barWidth, y, barWidth - 2.0f, std::max(height, 1.0f)));
+    }
+    RenderRects(textShader, bars, glm::vec3(0.3f, 0.8f, 0.9f));
+    RenderText(textShader, "0", textLeft, y - lineHeight, scale, textColor);
+    RenderText(textShader, std::to_string(1 << (CollisionStats::HISTOGRAM_BUCKETS - 2)) + "+",
+        textLeft + (CollisionStats::HISTOGRAM_BUCKETS - 1) * barWidth, y - lineHeight, scale, textColor);
+
+    y -= 2.0f * lineHeight;
+    line.str("");
+    line << "Hottest cells";
+    for (int cell : collisionStats.hottestCells(4)) {
+        line << "  (" << cell % gridWidth << "," << cell / gridWidth << ") " << collisionStats.cellTrianglesTested[cell] / 1000 << "k";
+    }
+    RenderText(textShader, line.str(), textLeft, y, scale, textColor);
+}
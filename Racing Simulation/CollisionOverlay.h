@@ -0,0 +1,33 @@
+#ifndef COLLISION_OVERLAY_H
+#define COLLISION_OVERLAY_H
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "CollisionChecker.h"
+#include "shader_m.h"
+
+enum class CollisionOverlayMode {
+    Off,
+    Triangles,      // cells colored by how many triangles they hold
+    Cost,           // cells colored by the triangles tested in them per tick
+    Count
+};
+
+// Debug view of the collision grid, cycled with [F4]. Draws the grid as a heat map in the bottom left corner
+// with the driven car on it, next to the query counters of CollisionStats: queries per tick, hit ratio, the
+// triangles-per-query histogram and the costliest cells. A few hot cells holding most of the triangles, or
+// queries testing hundreds of triangles each, mean the grid wants a finer resolution or a different structure.
+class CollisionOverlay {
+public:
+    void cycleMode();
+    bool isVisible() const { return mode != CollisionOverlayMode::Off; }
+
+    void draw(Shader& textShader, const std::vector<std::vector<Triangle>>& surfaceCells, const std::vector<std::vector<Triangle>>& wallCells,
+        int gridWidth, int gridHeight, float gridSize, glm::vec3 carPosition);
+
+private:
+    CollisionOverlayMode mode = CollisionOverlayMode::Off;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include "CollisionStats.h"
+
+#include <algorithm>
+
+CollisionStats collisionStats;
+
+// weight of the newest tick in cellRecentCost
+const float COST_SMOOTHING = 0.02f;
+
+void CollisionStats::setCellCount(int cellCount) {
+    if (static_cast<int>(cellThisTick.size()) == cellCount) return;
+    cellTrianglesTested.assign(cellCount, 0);
+    cellRecentCost.assign(cellCount, 0.0f);
+    cellThisTick.assign(cellCount, 0);
+}
+
+int CollisionStats::bucketFor(unsigned int triangles) {
+    int bucket = 0;
+    while (triangles > 0 && bucket < HISTOGRAM_BUCKETS - 1) {
+        triangles >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void CollisionStats::addQuery(CollisionQueryType type, unsigned int triangles, bool hit) {
+    if (type == CollisionQueryType::Ray) {
+        rayQueriesThisTick++;
+        (hit ? rayHits : rayMisses)++;
+    }
+    else {
+        aabbQueriesThisTick++;
+        (hit ? aabbHits : aabbMisses)++;
+    }
+    trianglesTested += triangles;
+    histogram[bucketFor(triangles)]++;
+}
+
+void CollisionStats::endTick() {
+    rayQueriesLastTick = rayQueriesThisTick;
+    aabbQueriesLastTick = aabbQueriesThisTick;
+    rayQueriesThisTick = 0;
+    aabbQueriesThisTick = 0;
+
+    for (size_t cell = 0; cell < cellThisTick.size(); ++cell) {
+        cellRecentCost[cell] += (cellThisTick[cell] - cellRecentCost[cell]) * COST_SMOOTHING;
+        cellThisTick[cell] = 0;
+    }
+}
+
+std::vector<int> CollisionStats::hottestCells(int count) const {
+    std::vector<int> cells;
+    for (size_t cell = 0; cell < cellTrianglesTested.size(); ++cell) {
+        if (cellTrianglesTested[cell] > 0) cells.push_back(static_cast<int>(cell));
+    }
+    std::sort(cells.begin(), cells.end(), [this](int a, int b) { return cellTrianglesTested[a] > cellTrianglesTested[b]; });
+    if (static_cast<int>(cells.size()) > count) cells.resize(count);
+    return cells;
+}
@@ -0,0 +1,56 @@
+#ifndef COLLISION_STATS_H
+#define COLLISION_STATS_H
+
+#include <vector>
+
+enum class CollisionQueryType {
+    Ray,
+    AABB
+};
+
+// Counters of the collision grid queries of every CollisionChecker, read by the collision overlay.
+// Main thread only, like the simulation that issues the queries.
+struct CollisionStats {
+    // triangles tested per query: 0, 1, 2-3, 4-7, ... and the last bucket takes everything above
+    static const int HISTOGRAM_BUCKETS = 12;
+
+    unsigned int rayQueriesThisTick = 0;
+    unsigned int aabbQueriesThisTick = 0;
+    unsigned int rayQueriesLastTick = 0;
+    unsigned int aabbQueriesLastTick = 0;
+
+    unsigned long long rayHits = 0;
+    unsigned long long rayMisses = 0;
+    unsigned long long aabbHits = 0;
+    unsigned long long aabbMisses = 0;
+    unsigned long long trianglesTested = 0;
+    unsigned long long histogram[HISTOGRAM_BUCKETS] = {};
+
+    // per grid cell
+    std::vector<unsigned long long> cellTrianglesTested;    // since the start
+    std::vector<float> cellRecentCost;                      // triangles tested per tick, smoothed over about a second
+    std::vector<unsigned int> cellThisTick;
+
+    // keeps the counters when the size does not change, every car sets the same grid
+    void setCellCount(int cellCount);
+
+    void addCellTests(int cell, unsigned int triangles) {
+        if (cell < 0 || cell >= static_cast<int>(cellThisTick.size())) return;
+        cellThisTick[cell] += triangles;
+        cellTrianglesTested[cell] += triangles;
+    }
+    void addQuery(CollisionQueryType type, unsigned int triangles, bool hit);
+
+    // once per simulation tick
+    void endTick();
+
+    unsigned long long queries() const { return rayHits + rayMisses + aabbHits + aabbMisses; }
+    // cells with the most triangles tested since the start, costliest first
+    std::vector<int> hottestCells(int count) const;
+
+    static int bucketFor(unsigned int triangles);
+};
+
+extern CollisionStats collisionStats;
+
+#endif
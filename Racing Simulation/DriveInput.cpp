@@ -0,0 +1,91 @@
+#include "DriveInput.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static bool sameKeys(const DriveInput& a, const DriveInput& b) {
+    return a.accelerate == b.accelerate && a.brake == b.brake && a.steerLeft == b.steerLeft && a.steerRight == b.steerRight;
+}
+
+static std::string keysToString(const DriveInput& input) {
+    std::string keys;
+    if (input.accelerate) keys += 'W';
+    if (input.brake) keys += 'S';
+    if (input.steerLeft) keys += 'A';
+    if (input.steerRight) keys += 'D';
+    return keys.empty() ? "-" : keys;
+}
+
+bool DriveScript::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cout << "Failed to open drive script " << path << std::endl;
+        return false;
+    }
+
+    segments.clear();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        DriveSegment segment;
+        std::string keys;
+        if (!(fields >> segment.frames >> keys) || segment.frames <= 0) {
+            std::cout << "Bad drive script line " << lineNumber << " in " << path << std::endl;
+            return false;
+        }
+        for (char key : keys) {
+            if (key == 'W' || key == 'w') segment.input.accelerate = true;
+            else if (key == 'S' || key == 's') segment.input.brake = true;
+            else if (key == 'A' || key == 'a') segment.input.steerLeft = true;
+            else if (key == 'D' || key == 'd') segment.input.steerRight = true;
+        }
+        segments.push_back(segment);
+    }
+    return true;
+}
+
+bool DriveScript::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        std::cout << "Failed to write drive script " << path << std::endl;
+        return false;
+    }
+    file << "# frames keys (W accelerate, S brake, A left, D right, - none)\n";
+    for (const DriveSegment& segment : segments) {
+        file << segment.frames << " " << keysToString(segment.input) << "\n";
+    }
+    return true;
+}
+
+void DriveScript::append(const DriveInput& input) {
+    if (!segments.empty() && sameKeys(segments.back().input, input)) {
+        segments.back().frames++;
+        return;
+    }
+    DriveSegment segment;
+    segment.frames = 1;
+    segment.input = input;
+    segments.push_back(segment);
+}
+
+DriveInput DriveScript::inputFor(int frame) const {
+    int total = frameCount();
+    if (total == 0) return DriveInput();
+    frame %= total;
+    for (const DriveSegment& segment : segments) {
+        if (frame < segment.frames) return segment.input;
+        frame -= segment.frames;
+    }
+    return DriveInput();
+}
+
+int DriveScript::frameCount() const {
+    int total = 0;
+    for (const DriveSegment& segment : segments) total += segment.frames;
+    return total;
+}
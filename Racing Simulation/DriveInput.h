@@ -0,0 +1,44 @@
+#ifndef DRIVE_INPUT_H
+#define DRIVE_INPUT_H
+
+#include <string>
+#include <vector>
+
+// driving keys for one frame, from the keyboard or a script
+struct DriveInput {
+    bool accelerate = false;
+    bool brake = false;
+    bool steerLeft = false;
+    bool steerRight = false;
+};
+
+struct DriveSegment {
+    int frames;
+    DriveInput input;
+};
+
+// Run length list of driver input, one entry per frame on a fixed timestep.
+// Stored as text, one "<frames> <keys>" line per segment where keys is any of W, S, A, D or - for none,
+// the same letters as the driving keys. Lines starting with # are comments.
+class DriveScript {
+public:
+    DriveScript() {}
+    explicit DriveScript(const std::vector<DriveSegment>& segments) : segments(segments) {}
+
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    // adds one frame, merged into the last segment when the keys did not change
+    void append(const DriveInput& input);
+    void clear() { segments.clear(); }
+
+    // past the end the script starts over
+    DriveInput inputFor(int frame) const;
+    int frameCount() const;
+    bool empty() const { return segments.empty(); }
+
+private:
+    std::vector<DriveSegment> segments;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "EngineAudio.h"
+
+#include <algorithm>
+
+// emitters already holding a voice count this much louder in the ranking, so two cars at about the same
+// distance do not trade the last voice back and forth every frame
+const float HOLD_BONUS = 1.25f;
+// quieter than this is not worth a voice at all
+const float MIN_AUDIBILITY = 0.01f;
+const float DOPPLER_FACTOR = 1.0f;
+
+EngineAudio::EngineAudio(SoundManager& soundManager, SoundId engineSound, int voiceCount, float minDistance)
+    : soundManager(soundManager), engineSound(engineSound), minDistance(minDistance), channels(voiceCount) {
+    soundManager.setDopplerParameters(DOPPLER_FACTOR, 1.0f);
+}
+
+EngineAudio::~EngineAudio() {
+    for (Channel& channel : channels) {
+        soundManager.stopVoice(channel.voice);
+    }
+}
+
+int EngineAudio::addEmitter() {
+    emitters.push_back(Emitter());
+    return static_cast<int>(emitters.size()) - 1;
+}
+
+void EngineAudio::setEmitter(int emitter, const glm::vec3& position, float loudness, float pitch) {
+    Emitter& target = emitters[emitter];
+    target.position = position;
+    target.loudness = loudness;
+    target.pitch = pitch;
+}
+
+float EngineAudio::audibilityAt(const Emitter& emitter, const glm::vec3& listenerPosition) const {
+    // irrKlang's falloff: full volume inside minDistance, then inversely proportional to the distance
+    float distance = glm::length(emitter.position - listenerPosition);
+    return emitter.loudness * std::min(1.0f, minDistance / std::max(distance, 1e-3f));
+}
+
+int EngineAudio::audibleCount() const {
+    return static_cast<int>(std::count_if(channels.begin(), channels.end(), [](const Channel& channel) { return channel.emitter >= 0; }));
+}
+
+void EngineAudio::update(const glm::vec3& listenerPosition, const glm::vec3& listenerForward, const glm::vec3& listenerUp, float deltaTime) {
+    glm::vec3 listenerVelocity(0.0f);
+    if (hasListenerPosition && deltaTime > 0.0f) listenerVelocity = (listenerPosition - lastListenerPosition) / deltaTime;
+    lastListenerPosition = listenerPosition;
+    hasListenerPosition = true;
+    soundManager.setListener(listenerPosition, listenerForward, listenerUp, listenerVelocity);
+
+    // rank every emitter, the only part of the work that grows with the field
+    ranking.clear();
+    for (int i = 0; i < static_cast<int>(emitters.size()); ++i) {
+        Emitter& emitter = emitters[i];
+        if (emitter.hasLastPosition && deltaTime > 0.0f) emitter.velocity = (emitter.position - emitter.lastPosition) / deltaTime;
+        emitter.lastPosition = emitter.position;
+        emitter.hasLastPosition = true;
+
+        emitter.audibility = audibilityAt(emitter, listenerPosition) * (emitter.channel >= 0 ? HOLD_BONUS : 1.0f);
+        if (emitter.audibility >= MIN_AUDIBILITY) ranking.push_back(i);
+    }
+    size_t audible = std::min(ranking.size(), channels.size());
+    std::nth_element(ranking.begin(), ranking.begin() + audible, ranking.end(), [this](int a, int b) {
+        return emitters[a].audibility > emitters[b].audibility;
+    });
+    ranking.resize(audible);
+
+    // voices of emitters that dropped out fade out, their channel is free again once silent
+    for (Channel& channel : channels) {
+        if (channel.emitter < 0) continue;
+        if (std::find(ranking.begin(), ranking.end(), channel.emitter) != ranking.end()) continue;
+        Emitter& dropped = emitters[channel.emitter];
+        dropped.channel = -1;
+        channel.emitter = -1;
+        soundManager.setVoiceTarget(channel.voice, 0.0f, dropped.pitch);
+    }
+
+    for (int index : ranking) {
+        Emitter& emitter = emitters[index];
+        if (emitter.channel < 0) {
+            auto free = std::find_if(channels.begin(), channels.end(), [this](const Channel& channel) {
+                return channel.emitter < 0 && soundManager.voiceVolume(channel.voice) <= 0.0f;
+            });
+            // every free voice is still fading out, this emitter gets one on a later frame
+            if (free == channels.end()) continue;
+            if (!soundManager.isVoiceValid(free->voice)) {
+                free->voice = soundManager.startVoice3D(engineSound, true, emitter.position, minDistance, 0.0f, emitter.pitch);
+                // the SoundManager is out of slots, stay virtual
+                if (!soundManager.isVoiceValid(free->voice)) continue;
+            }
+            free->emitter = index;
+            emitter.channel = static_cast<int>(free - channels.begin());
+        }
+        Channel& channel = channels[emitter.channel];
+        soundManager.setVoicePosition(channel.voice, emitter.position, emitter.velocity);
+        soundManager.setVoiceTarget(channel.voice, emitter.loudness, emitter.pitch);
+    }
+}
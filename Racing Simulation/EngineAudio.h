@@ -0,0 +1,62 @@
+#ifndef ENGINE_AUDIO_H
+#define ENGINE_AUDIO_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "SoundManager.h"
+
+// Positional engine sound for any number of cars on a fixed number of voices.
+// Every car is an emitter with a loudness and pitch set each frame. update() ranks the emitters by how loud
+// they reach the listener, loudness times the same distance falloff irrKlang applies, and only the
+// voiceCount loudest get a voice. The rest are virtual: they keep their state but cost nothing beyond the
+// ranking, and pick up a voice again as soon as they rank high enough. A voice leaving an emitter fades out
+// before it moves to the next one, so nothing clicks or jumps across the track.
+// Emitter velocities come from the position change between frames and drive the Doppler shift.
+class EngineAudio {
+public:
+    EngineAudio(SoundManager& soundManager, SoundId engineSound, int voiceCount, float minDistance = 5.0f);
+    ~EngineAudio();
+
+    int addEmitter();
+    // loudness 0 silences the emitter, pitch is the playback speed of the engine loop
+    void setEmitter(int emitter, const glm::vec3& position, float loudness, float pitch);
+
+    // once per frame, before SoundManager::update
+    void update(const glm::vec3& listenerPosition, const glm::vec3& listenerForward, const glm::vec3& listenerUp, float deltaTime);
+
+    int audibleCount() const;
+    int emitterCount() const { return static_cast<int>(emitters.size()); }
+
+private:
+    struct Emitter {
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::vec3 lastPosition = glm::vec3(0.0f);
+        glm::vec3 velocity = glm::vec3(0.0f);
+        bool hasLastPosition = false;
+        float loudness = 0.0f;
+        float pitch = 1.0f;
+        float audibility = 0.0f;    // loudness as heard at the listener, the ranking key
+        int channel = -1;           // -1 while virtual
+    };
+
+    struct Channel {
+        VoiceHandle voice;
+        int emitter = -1;           // -1 while free or fading out
+    };
+
+    float audibilityAt(const Emitter& emitter, const glm::vec3& listenerPosition) const;
+
+    SoundManager& soundManager;
+    SoundId engineSound;
+    float minDistance;
+    std::vector<Emitter> emitters;
+    std::vector<Channel> channels;
+    std::vector<int> ranking;       // reused every frame
+
+    glm::vec3 lastListenerPosition = glm::vec3(0.0f);
+    bool hasListenerPosition = false;
+};
+
+#endif
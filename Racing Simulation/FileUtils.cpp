@@ -0,0 +1,90 @@
+#include "FileUtils.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t hashString(const std::string& text, uint64_t seed) {
+    return hashBytes(text.data(), text.size(), seed);
+}
+
+uint64_t hashFile(const std::string& path, uint64_t seed) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return 0;
+
+    // Hash in chunks so large HDRs and OBJs never need a second full copy in memory
+    std::vector<char> buffer(1 << 16);
+    uint64_t hash = seed;
+    while (file) {
+        file.read(buffer.data(), buffer.size());
+        std::streamsize count = file.gcount();
+        if (count <= 0) break;
+        hash = hashBytes(buffer.data(), static_cast<size_t>(count), hash);
+    }
+    return hash;
+}
+
+bool readFileBytes(const std::string& path, std::vector<char>& bytes) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    bytes.resize(static_cast<size_t>(size));
+    return size == 0 || static_cast<bool>(file.read(bytes.data(), size));
+}
+
+bool fileExists(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+bool fileStamp(const std::string& path, uint64_t& size, uint64_t& modifiedTime) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return false;
+    size = static_cast<uint64_t>(info.st_size);
+    modifiedTime = static_cast<uint64_t>(info.st_mtime);
+    return true;
+}
+
+bool ensureDirectory(const std::string& path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0) {
+        return (info.st_mode & S_IFDIR) != 0;
+    }
+#ifdef _WIN32
+    int result = _mkdir(path.c_str());
+#else
+    int result = mkdir(path.c_str(), 0755);
+#endif
+    // another loader thread may have created it in the meantime
+    return result == 0 || (stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR) != 0);
+}
+
+std::string fileNameFromPath(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+std::string flattenPath(const std::string& path) {
+    std::string name = path;
+    std::replace(name.begin(), name.end(), '/', '_');
+    std::replace(name.begin(), name.end(), '\\', '_');
+    return name;
+}
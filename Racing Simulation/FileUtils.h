@@ -0,0 +1,33 @@
+#ifndef FILE_UTILS_H
+#define FILE_UTILS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// FNV-1a 64-bit hash, used as the key for every on-disk cache so a changed source file invalidates its cached data
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS);
+uint64_t hashString(const std::string& text, uint64_t seed = FNV_OFFSET_BASIS);
+
+// Hashes the whole contents of a file, returns 0 if the file cannot be read
+uint64_t hashFile(const std::string& path, uint64_t seed = FNV_OFFSET_BASIS);
+
+bool readFileBytes(const std::string& path, std::vector<char>& bytes);
+bool fileExists(const std::string& path);
+
+// Size and last modification time, cheap enough to check on every launch to detect a changed source file
+bool fileStamp(const std::string& path, uint64_t& size, uint64_t& modifiedTime);
+
+// Creates a single directory level, succeeds if it already exists
+bool ensureDirectory(const std::string& path);
+
+// "Textures/newport_loft.hdr" -> "newport_loft.hdr"
+std::string fileNameFromPath(const std::string& path);
+
+// "Objects/chev-nascar/body.obj" -> "Objects_chev-nascar_body.obj", several assets share file names
+// so the cache files carry the whole relative path
+std::string flattenPath(const std::string& path);
+
+#endif
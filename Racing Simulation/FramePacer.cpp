@@ -0,0 +1,130 @@
+#include "FramePacer.h"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+static const char* const MODE_NAMES[] = { "Unlimited", "VSync", "Adaptive VSync", "Capped" };
+
+// share of the carried time handed back per frame
+const double CARRY_RATE = 0.25;
+// bounds of the spin before a Capped deadline
+const double MIN_SLEEP_MARGIN = 0.0005;
+const double MAX_SLEEP_MARGIN = 0.02;
+
+const char* pacingModeName(PacingMode mode) {
+    return MODE_NAMES[static_cast<int>(mode)];
+}
+
+FramePacer::FramePacer(const FramePacingSettings& settings) : settings(settings) {
+    this->settings.smoothingFrames = std::max(1, std::min(settings.smoothingFrames, MAX_SMOOTHING_FRAMES));
+}
+
+void FramePacer::apply() {
+    GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode* videoMode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+    if (videoMode && videoMode->refreshRate > 0) refreshSeconds = 1.0 / videoMode->refreshRate;
+    adaptiveSupported = glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+
+    int interval = 0;
+    if (settings.mode == PacingMode::VSync) interval = 1;
+    else if (settings.mode == PacingMode::AdaptiveVSync) interval = adaptiveSupported ? -1 : 1;
+    glfwSwapInterval(interval);
+
+    // the smoothing starts over from the new mode's frames, nothing of the old one is averaged or paid back
+    deadline = Clock::now();
+    historyCount = 0;
+    historyHead = 0;
+    carried = 0.0;
+}
+
+void FramePacer::setMode(PacingMode mode) {
+    settings.mode = mode;
+    apply();
+    std::cout << "Frame pacing: " << pacingModeName(mode);
+    if (mode == PacingMode::Capped) std::cout << " " << settings.targetFps << " fps";
+    if (mode == PacingMode::AdaptiveVSync && !adaptiveSupported) std::cout << " (not supported, plain vsync)";
+    std::cout << std::endl;
+}
+
+void FramePacer::cycleMode() {
+    setMode(static_cast<PacingMode>((static_cast<int>(settings.mode) + 1) % static_cast<int>(PacingMode::Count)));
+}
+
+double FramePacer::targetFrameSeconds() const {
+    switch (settings.mode) {
+    // a capped mode without a usable rate paces like Unlimited
+    case PacingMode::Capped: return settings.targetFps > 0.0 ? 1.0 / settings.targetFps : 1.0 / 60.0;
+    case PacingMode::VSync:
+    case PacingMode::AdaptiveVSync: return refreshSeconds;
+    default: return 1.0 / 60.0;
+    }
+}
+
+float FramePacer::beginFrame() {
+    Clock::time_point now = Clock::now();
+    if (!started) {
+        // nothing to measure yet, the first step is one frame budget
+        started = true;
+        lastFrameStart = now;
+        deadline = now;
+        return static_cast<float>(targetFrameSeconds());
+    }
+    rawDelta = std::chrono::duration<double>(now - lastFrameStart).count();
+    lastFrameStart = now;
+
+    frameTimes.record(static_cast<uint64_t>(rawDelta * 1e6));
+    if (rawDelta > 1.5 * targetFrameSeconds()) stutters++;
+
+    // time beyond the clamp is dropped rather than carried, the simulation just runs slow for that frame
+    double delta = std::min(rawDelta, settings.maxDeltaSeconds);
+    if (settings.mode == PacingMode::VSync || settings.mode == PacingMode::AdaptiveVSync) {
+        // timer jitter around a presented refresh is noise, not time the game should simulate
+        double refreshes = std::round(delta / refreshSeconds);
+        if (refreshes >= 1.0 && std::abs(delta - refreshes * refreshSeconds) < settings.snapToleranceMs * 1e-3) {
+            delta = refreshes * refreshSeconds;
+        }
+    }
+
+    history[historyHead] = delta;
+    historyHead = (historyHead + 1) % settings.smoothingFrames;
+    historyCount = std::min(historyCount + 1, settings.smoothingFrames);
+    double mean = 0.0;
+    for (int i = 0; i < historyCount; ++i) mean += history[i];
+    mean /= historyCount;
+
+    // what the mean leaves out of this frame is paid back over the next few
+    carried += delta - mean;
+    double correction = carried * CARRY_RATE;
+    carried -= correction;
+    return static_cast<float>(std::max(0.0, std::min(mean + correction, settings.maxDeltaSeconds)));
+}
+
+void FramePacer::waitForNextFrame() {
+    if (settings.mode != PacingMode::Capped || settings.targetFps <= 0.0) return;
+
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / settings.targetFps));
+    deadline += period;
+    Clock::time_point now = Clock::now();
+    if (now >= deadline) {
+        // more than a frame behind: start counting again from here instead of rushing frames to catch up
+        if (now - deadline > period) deadline = now;
+        return;
+    }
+
+    Clock::time_point wakeUp = deadline - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(sleepMargin));
+    if (now < wakeUp) {
+        std::this_thread::sleep_until(wakeUp);
+        double overslept = std::chrono::duration<double>(Clock::now() - wakeUp).count();
+        // grows at once when a sleep runs long, shrinks slowly while sleeps keep landing early
+        sleepMargin = std::max(sleepMargin * 0.99, overslept * 1.25);
+        sleepMargin = std::max(MIN_SLEEP_MARGIN, std::min(sleepMargin, MAX_SLEEP_MARGIN));
+    }
+    while (Clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <chrono>
+
+#include "FrameTimeHistogram.h"
+
+enum class PacingMode {
+    Unlimited,      // no vsync, no cap
+    VSync,
+    AdaptiveVSync,  // tears instead of waiting a whole refresh when a frame is late, plain vsync without the extension
+    Capped,         // no vsync, waits out the rest of each frame to hold targetFps
+    Count
+};
+
+const char* pacingModeName(PacingMode mode);
+
+struct FramePacingSettings {
+    PacingMode mode = PacingMode::VSync;
+    double targetFps = 60.0;            // Capped only
+    double maxDeltaSeconds = 1.0 / 15.0;   // longer frames (loading, a dragged window) are not simulated in full
+    int smoothingFrames = 4;            // the simulation step is the mean of this many frame times
+    double snapToleranceMs = 0.25;      // with vsync a delta this close to a whole number of refreshes is snapped to it
+};
+
+// Decides when a frame starts and how much time the simulation advances by.
+// beginFrame() measures the wall time since the previous frame and records it in the histogram, then hands
+// the simulation a step that is clamped, snapped to the refresh interval under vsync and averaged over the
+// last few frames, so a single spike does not jolt the car physics. The averaging only shifts time between
+// neighbouring frames: the difference is carried into the next steps, the sum still follows the wall clock.
+// waitForNextFrame() holds the Capped rate by sleeping until shortly before the deadline and spinning the
+// rest, the sleep margin follows the worst oversleep seen so the coarse Windows timer does not overshoot.
+class FramePacer {
+public:
+    explicit FramePacer(const FramePacingSettings& settings = FramePacingSettings());
+
+    // GL thread with the context current, sets the swap interval for the mode
+    void apply();
+    void setMode(PacingMode mode);
+    void cycleMode();
+    // the rate of the Capped mode, takes effect on the next frame. Rates of zero or less are ignored.
+    void setTargetFps(double fps) { if (fps > 0.0) settings.targetFps = fps; }
+    PacingMode mode() const { return settings.mode; }
+    const FramePacingSettings& currentSettings() const { return settings; }
+
+    // start of the frame, returns the simulation step in seconds
+    float beginFrame();
+    // just before the buffer swap
+    void waitForNextFrame();
+
+    const FrameTimeHistogram& histogram() const { return frameTimes; }
+    void resetHistogram() { frameTimes.reset(); stutters = 0; }
+    // the frame budget for the mode: the cap, the refresh interval, or 60 Hz when nothing limits the rate
+    double targetFrameSeconds() const;
+    // frames that took more than one and a half budgets since the last reset
+    unsigned long long stutterCount() const { return stutters; }
+    double lastDeltaSeconds() const { return rawDelta; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static const int MAX_SMOOTHING_FRAMES = 16;
+
+    FramePacingSettings settings;
+    double refreshSeconds = 1.0 / 60.0;
+    bool adaptiveSupported = false;
+
+    Clock::time_point lastFrameStart;
+    Clock::time_point deadline;     // Capped: when the next frame may start
+    bool started = false;
+
+    double rawDelta = 0.0;
+    double history[MAX_SMOOTHING_FRAMES] = {};
+    int historyCount = 0;
+    int historyHead = 0;
+    double carried = 0.0;           // wall time measured but not yet handed to the simulation
+    double sleepMargin = 0.002;     // spun instead of slept before a deadline, seconds
+
+    FrameTimeHistogram frameTimes;
+    unsigned long long stutters = 0;
+};
+
+#endif
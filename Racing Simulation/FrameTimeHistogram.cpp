@@ -0,0 +1,68 @@
+#include "FrameTimeHistogram.h"
+
+#include <algorithm>
+#include <iomanip>
+
+int FrameTimeHistogram::bucketIndex(uint64_t value) {
+    const uint64_t largest = (uint64_t(1) << (MAX_MAGNITUDE + 1)) - 1;
+    value = std::min(value, largest);
+    int magnitude = 0;
+    for (uint64_t v = value; v > 1; v >>= 1) ++magnitude;
+    int shift = std::max(0, magnitude - SUB_BUCKET_BITS);
+    return shift * SUB_BUCKETS + static_cast<int>(value >> shift);
+}
+
+uint64_t FrameTimeHistogram::bucketLowest(int index) {
+    if (index < 2 * SUB_BUCKETS) return static_cast<uint64_t>(index);
+    int shift = index / SUB_BUCKETS - 1;
+    return static_cast<uint64_t>(index - shift * SUB_BUCKETS) << shift;
+}
+
+uint64_t FrameTimeHistogram::bucketWidth(int index) {
+    if (index < 2 * SUB_BUCKETS) return 1;
+    return uint64_t(1) << (index / SUB_BUCKETS - 1);
+}
+
+void FrameTimeHistogram::record(uint64_t microseconds) {
+    buckets[bucketIndex(microseconds)]++;
+    minValue = total ? std::min(minValue, microseconds) : microseconds;
+    maxValue = std::max(maxValue, microseconds);
+    sum += microseconds;
+    total++;
+}
+
+void FrameTimeHistogram::reset() {
+    std::fill(buckets, buckets + BUCKET_COUNT, 0);
+    total = sum = minValue = maxValue = 0;
+}
+
+uint64_t FrameTimeHistogram::percentile(double percent) const {
+    if (total == 0) return 0;
+    // the rank of the value asked for, 1 based so percentile(0) is the smallest one recorded
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(percent / 100.0 * total + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            uint64_t middle = bucketLowest(i) + bucketWidth(i) / 2;
+            return std::min(std::max(middle, minValue), maxValue);
+        }
+    }
+    return maxValue;
+}
+
+uint64_t FrameTimeHistogram::countAbove(uint64_t microseconds) const {
+    // whole buckets only, off by at most the one bucket that straddles the threshold
+    uint64_t above = 0;
+    for (int i = bucketIndex(microseconds) + 1; i < BUCKET_COUNT; ++i) above += buckets[i];
+    return above;
+}
+
+void FrameTimeHistogram::writeJson(std::ostream& out) const {
+    const double ms = 1e-3;
+    out << std::fixed << std::setprecision(3);
+    out << "{ \"count\": " << total << ", \"meanMs\": " << mean() * ms << ", \"minMs\": " << minimum() * ms
+        << ", \"p50Ms\": " << percentile(50.0) * ms << ", \"p90Ms\": " << percentile(90.0) * ms
+        << ", \"p99Ms\": " << percentile(99.0) * ms << ", \"p999Ms\": " << percentile(99.9) * ms
+        << ", \"maxMs\": " << maximum() * ms << " }";
+}
@@ -0,0 +1,46 @@
+#ifndef FRAME_TIME_HISTOGRAM_H
+#define FRAME_TIME_HISTOGRAM_H
+
+#include <cstdint>
+#include <ostream>
+
+// High dynamic range histogram of frame times in microseconds, 1 us up to about 30 s.
+// Values below 128 us get a bucket each, above that every power of two is split into 64 equal buckets, so
+// any recorded value is known to within 1.6% whatever its size. Recording is a few shifts and an increment,
+// and the buckets are fixed, so it can count every frame of a long session without growing.
+class FrameTimeHistogram {
+public:
+    void record(uint64_t microseconds);
+    void reset();
+
+    uint64_t count() const { return total; }
+    uint64_t minimum() const { return total ? minValue : 0; }
+    uint64_t maximum() const { return maxValue; }
+    double mean() const { return total ? static_cast<double>(sum) / total : 0.0; }
+    // percentile in [0, 100], the middle of the bucket holding it
+    uint64_t percentile(double percent) const;
+    // frames that took longer than the given time
+    uint64_t countAbove(uint64_t microseconds) const;
+
+    // count, mean, min, max and the usual percentiles in milliseconds, as one JSON object
+    void writeJson(std::ostream& out) const;
+
+private:
+    static const int SUB_BUCKET_BITS = 6;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_MAGNITUDE = 24;    // values from 2^25 us on land in the last bucket
+    // the first 2 * SUB_BUCKETS values are exact, then SUB_BUCKETS per power of two up to MAX_MAGNITUDE
+    static const int BUCKET_COUNT = (MAX_MAGNITUDE - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketLowest(int index);
+    static uint64_t bucketWidth(int index);
+
+    uint64_t buckets[BUCKET_COUNT] = {};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t minValue = 0;
+    uint64_t maxValue = 0;
+};
+
+#endif
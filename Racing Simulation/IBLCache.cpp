@@ -0,0 +1,188 @@
+#include "IBLCache.h"
+#include "FileUtils.h"
+#include "MemoryAccounting.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+// Bump whenever the file layout or the bake parameters in main() change
+const uint32_t IBL_CACHE_VERSION = 1;
+const char IBL_CACHE_MAGIC[4] = { 'R', 'I', 'B', 'L' };
+
+struct IBLCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t textureCount;
+    uint32_t reserved;
+};
+
+struct IBLTextureRecord {
+    uint32_t target;          // GL_TEXTURE_CUBE_MAP or GL_TEXTURE_2D
+    uint32_t internalFormat;  // GL_RGB16F / GL_RG16F
+    uint32_t format;          // GL_RGB / GL_RG, data is always stored as GL_HALF_FLOAT
+    uint32_t minFilter;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipCount;
+    uint32_t reserved;
+};
+
+static uint32_t componentCount(uint32_t format) {
+    return format == GL_RG ? 2 : 3;
+}
+
+static size_t levelSize(const IBLTextureRecord& record, uint32_t mip) {
+    size_t w = std::max(1u, record.width >> mip);
+    size_t h = std::max(1u, record.height >> mip);
+    return w * h * componentCount(record.format) * sizeof(uint16_t);
+}
+
+void IBLMaps::release() {
+    unsigned int textures[] = { envCubemap, irradianceMap, prefilterMap, brdfLUTTexture };
+    for (unsigned int texture : textures) {
+        if (texture != 0) glDeleteTextures(1, &texture);
+    }
+    envCubemap = irradianceMap = prefilterMap = brdfLUTTexture = 0;
+}
+
+size_t IBLMaps::gpuBytes() const {
+    size_t bytes = 0;
+    if (envCubemap) bytes += gpuTextureBytes(GL_RGB16F, 512, 512, mipLevelCount(512, 512), 6);
+    if (irradianceMap) bytes += gpuTextureBytes(GL_RGB16F, 32, 32, 1, 6);
+    // the levels glGenerateMipmap adds below the 5 roughness levels of a fresh bake are left out, they are tiny
+    if (prefilterMap) bytes += gpuTextureBytes(GL_RGB16F, 128, 128, 5, 6);
+    if (brdfLUTTexture) bytes += gpuTextureBytes(GL_RG16F, 512, 512);
+    return bytes;
+}
+
+IBLCache::IBLCache(const std::string& cacheDirectory) : cacheDirectory(cacheDirectory) {}
+
+std::string IBLCache::cachePathFor(const std::string& hdrPath) const {
+    return cacheDirectory + "/" + fileNameFromPath(hdrPath) + ".ibl";
+}
+
+uint64_t IBLCache::computeKey(const std::string& hdrPath, const std::vector<std::string>& shaderPaths) const {
+    uint64_t key = hashBytes(&IBL_CACHE_VERSION, sizeof(IBL_CACHE_VERSION));
+    key = hashFile(hdrPath, key);
+    for (const std::string& shaderPath : shaderPaths) {
+        key = hashFile(shaderPath, key);
+    }
+    return key;
+}
+
+bool IBLCache::load(const std::string& hdrPath, uint64_t key, IBLMaps& maps) const {
+    std::ifstream file(cachePathFor(hdrPath), std::ios::binary);
+    if (!file) return false;
+
+    IBLCacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (!std::equal(IBL_CACHE_MAGIC, IBL_CACHE_MAGIC + 4, header.magic) || header.version != IBL_CACHE_VERSION ||
+        header.key != key || header.textureCount != 4) {
+        std::cout << "IBL cache stale for " << hdrPath << ", rebaking" << std::endl;
+        return false;
+    }
+
+    unsigned int* targets[] = { &maps.envCubemap, &maps.irradianceMap, &maps.prefilterMap, &maps.brdfLUTTexture };
+    std::vector<char> levelData;
+
+    GLint previousAlignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (unsigned int t = 0; t < header.textureCount; ++t) {
+        IBLTextureRecord record;
+        if (!file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
+            maps.release();
+            return false;
+        }
+
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(record.target, textureID);
+        *targets[t] = textureID;
+
+        unsigned int faceCount = record.target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+        for (uint32_t mip = 0; mip < record.mipCount; ++mip) {
+            size_t size = levelSize(record, mip);
+            levelData.resize(size);
+            GLsizei w = std::max(1u, record.width >> mip);
+            GLsizei h = std::max(1u, record.height >> mip);
+
+            for (unsigned int face = 0; face < faceCount; ++face) {
+                if (!file.read(levelData.data(), size)) {
+                    glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
+                    maps.release();
+                    return false;
+                }
+                GLenum faceTarget = faceCount == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+                glTexImage2D(faceTarget, mip, record.internalFormat, w, h, 0, record.format, GL_HALF_FLOAT, levelData.data());
+            }
+        }
+
+        glTexParameteri(record.target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(record.target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        if (faceCount == 6) glTexParameteri(record.target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(record.target, GL_TEXTURE_MIN_FILTER, record.minFilter);
+        glTexParameteri(record.target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // only the stored levels exist, so clamp sampling to them to keep the texture complete
+        glTexParameteri(record.target, GL_TEXTURE_MAX_LEVEL, record.mipCount - 1);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
+    return true;
+}
+
+bool IBLCache::save(const std::string& hdrPath, uint64_t key, const IBLMaps& maps) const {
+    if (!ensureDirectory(cacheDirectory)) {
+        std::cout << "Failed to create IBL cache directory: " << cacheDirectory << std::endl;
+        return false;
+    }
+
+    std::ofstream file(cachePathFor(hdrPath), std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    IBLCacheHeader header = {};
+    std::copy(IBL_CACHE_MAGIC, IBL_CACHE_MAGIC + 4, header.magic);
+    header.version = IBL_CACHE_VERSION;
+    header.key = key;
+    header.textureCount = 4;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // the prefilter map only has 5 rendered roughness levels even though glGenerateMipmap allocated more
+    IBLTextureRecord records[] = {
+        { GL_TEXTURE_CUBE_MAP, GL_RGB16F, GL_RGB, GL_LINEAR_MIPMAP_LINEAR, 512, 512, 10, 0 },
+        { GL_TEXTURE_CUBE_MAP, GL_RGB16F, GL_RGB, GL_LINEAR, 32, 32, 1, 0 },
+        { GL_TEXTURE_CUBE_MAP, GL_RGB16F, GL_RGB, GL_LINEAR_MIPMAP_LINEAR, 128, 128, 5, 0 },
+        { GL_TEXTURE_2D, GL_RG16F, GL_RG, GL_LINEAR, 512, 512, 1, 0 }
+    };
+    unsigned int textures[] = { maps.envCubemap, maps.irradianceMap, maps.prefilterMap, maps.brdfLUTTexture };
+    std::vector<char> levelData;
+
+    GLint previousAlignment;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &previousAlignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    for (unsigned int t = 0; t < 4; ++t) {
+        const IBLTextureRecord& record = records[t];
+        file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        glBindTexture(record.target, textures[t]);
+
+        unsigned int faceCount = record.target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+        for (uint32_t mip = 0; mip < record.mipCount; ++mip) {
+            levelData.resize(levelSize(record, mip));
+            for (unsigned int face = 0; face < faceCount; ++face) {
+                GLenum faceTarget = faceCount == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+                glGetTexImage(faceTarget, mip, record.format, GL_HALF_FLOAT, levelData.data());
+                file.write(levelData.data(), levelData.size());
+            }
+        }
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, previousAlignment);
+
+    if (!file) {
+        std::cout << "Failed to write IBL cache for " << hdrPath << std::endl;
+        return false;
+    }
+    std::cout << "IBL cache written for " << hdrPath << std::endl;
+    return true;
+}
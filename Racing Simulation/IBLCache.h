@@ -0,0 +1,42 @@
+#ifndef IBL_CACHE_H
+#define IBL_CACHE_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The four textures produced by the IBL precompute for one HDR environment
+struct IBLMaps {
+    unsigned int envCubemap = 0;      // 512x512 cubemap with full mip chain
+    unsigned int irradianceMap = 0;   // 32x32 diffuse irradiance cubemap
+    unsigned int prefilterMap = 0;    // 128x128 specular cubemap, one roughness level per mip
+    unsigned int brdfLUTTexture = 0;  // 512x512 RG split-sum lookup
+
+    void release();
+    // from the sizes and formats above, every map is half float
+    size_t gpuBytes() const;
+};
+
+// Stores the baked IBL maps on disk so later launches (and environment switches) can upload them directly
+// instead of decoding the HDR and re-running the convolution passes.
+// A cache file is only used when its key matches the hash of the HDR file and of the bake shaders.
+class IBLCache {
+public:
+    IBLCache(const std::string& cacheDirectory);
+
+    uint64_t computeKey(const std::string& hdrPath, const std::vector<std::string>& shaderPaths) const;
+
+    // Creates and fills the textures in maps from the cache file, returns false on miss or stale data
+    bool load(const std::string& hdrPath, uint64_t key, IBLMaps& maps) const;
+
+    // Reads the baked textures back from the GPU and writes them to the cache file
+    bool save(const std::string& hdrPath, uint64_t key, const IBLMaps& maps) const;
+
+private:
+    std::string cachePathFor(const std::string& hdrPath) const;
+
+    std::string cacheDirectory;
+};
+
+#endif
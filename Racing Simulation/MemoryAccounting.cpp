@@ -0,0 +1,110 @@
+#include "MemoryAccounting.h"
+
+#include <algorithm>
+
+static const char* const CATEGORY_NAMES[] = {
+    "Meshes", "Collision meshes", "Collision grid", "Textures", "Cubemaps", "IBL", "Glyphs", "Shadow maps", "Staging", "Audio"
+};
+
+const char* memoryCategoryName(MemoryCategory category) {
+    return CATEGORY_NAMES[static_cast<int>(category)];
+}
+
+MemoryAccounting& MemoryAccounting::get() {
+    static MemoryAccounting accounting;
+    return accounting;
+}
+
+void MemoryAccounting::set(const void* owner, MemoryCategory category, const std::string& name, size_t cpuBytes, size_t gpuBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Key key(owner, static_cast<int>(category));
+    if (cpuBytes == 0 && gpuBytes == 0) {
+        entries.erase(key);
+        return;
+    }
+    MemoryEntry& entry = entries[key];
+    entry.name = name;
+    entry.category = category;
+    entry.bytes.cpu = cpuBytes;
+    entry.bytes.gpu = gpuBytes;
+}
+
+void MemoryAccounting::remove(const void* owner, MemoryCategory category) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.erase(Key(owner, static_cast<int>(category)));
+}
+
+MemoryBytes MemoryAccounting::total() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    MemoryBytes sum;
+    for (const auto& entry : entries) {
+        sum.cpu += entry.second.bytes.cpu;
+        sum.gpu += entry.second.bytes.gpu;
+    }
+    return sum;
+}
+
+MemoryBytes MemoryAccounting::categoryTotal(MemoryCategory category) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    MemoryBytes sum;
+    for (const auto& entry : entries) {
+        if (entry.second.category != category) continue;
+        sum.cpu += entry.second.bytes.cpu;
+        sum.gpu += entry.second.bytes.gpu;
+    }
+    return sum;
+}
+
+std::vector<MemoryEntry> MemoryAccounting::largest(size_t count) const {
+    std::vector<MemoryEntry> sorted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sorted.reserve(entries.size());
+        for (const auto& entry : entries) sorted.push_back(entry.second);
+    }
+    count = std::min(count, sorted.size());
+    std::partial_sort(sorted.begin(), sorted.begin() + count, sorted.end(), [](const MemoryEntry& a, const MemoryEntry& b) {
+        return a.bytes.cpu + a.bytes.gpu > b.bytes.cpu + b.bytes.gpu;
+    });
+    sorted.resize(count);
+    return sorted;
+}
+
+static size_t bytesPerTexel(GLenum internalFormat) {
+    switch (internalFormat) {
+    case GL_RED:
+    case GL_R8: return 1;
+    case GL_RG8:
+    case GL_R16F: return 2;
+    // drivers store three channel formats padded to four
+    case GL_RGB:
+    case GL_RGB8:
+    case GL_RGBA:
+    case GL_RGBA8:
+    case GL_RG16F:
+    case GL_R32F:
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH_COMPONENT32F:
+    case GL_DEPTH24_STENCIL8: return 4;
+    case GL_RGB16F:
+    case GL_RGBA16F:
+    case GL_RG32F: return 8;
+    case GL_RGB32F:
+    case GL_RGBA32F: return 16;
+    default: return 4;
+    }
+}
+
+size_t gpuTextureBytes(GLenum internalFormat, int width, int height, int levels, int layers) {
+    size_t texels = 0;
+    for (int level = 0; level < levels; ++level) {
+        texels += static_cast<size_t>(std::max(1, width >> level)) * std::max(1, height >> level);
+    }
+    return texels * layers * bytesPerTexel(internalFormat);
+}
+
+int mipLevelCount(int width, int height) {
+    int levels = 1;
+    for (int size = std::max(width, height); size > 1; size >>= 1) ++levels;
+    return levels;
+}
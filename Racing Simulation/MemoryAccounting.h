@@ -0,0 +1,73 @@
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class MemoryCategory {
+    Meshes,            // vertex and index vectors, VBOs and EBOs
+    CollisionMeshes,   // welded positions and indices kept for the CPU queries
+    CollisionGrid,     // triangles copied into the grid cells
+    Textures,
+    Cubemaps,
+    IBL,
+    Glyphs,
+    ShadowMaps,
+    Staging,           // pixel buffers of the TextureStreamer
+    Audio,             // sound samples held in memory, streamed ones are left out
+    Count
+};
+
+const char* memoryCategoryName(MemoryCategory category);
+
+struct MemoryBytes {
+    size_t cpu = 0;
+    size_t gpu = 0;
+};
+
+struct MemoryEntry {
+    std::string name;
+    MemoryCategory category = MemoryCategory::Meshes;
+    MemoryBytes bytes;
+};
+
+// Bytes each asset holds in RAM and on the GPU, for the memory section of the perf HUD.
+// Owners report what they allocated whenever it changes, keyed by their own address and a category so one
+// object can report several kinds of memory. GPU sizes are computed from the formats and mip chains handed
+// to GL, what the driver actually reserves can be somewhat larger (padding, alignment).
+// Reported from the loader threads as well as the GL thread, so every call takes the lock.
+class MemoryAccounting {
+public:
+    static MemoryAccounting& get();
+
+    // replaces the owner's entry, zero bytes on both sides removes it
+    void set(const void* owner, MemoryCategory category, const std::string& name, size_t cpuBytes, size_t gpuBytes);
+    void remove(const void* owner, MemoryCategory category);
+
+    MemoryBytes total() const;
+    MemoryBytes categoryTotal(MemoryCategory category) const;
+    // the entries with the most bytes on both sides together, largest first
+    std::vector<MemoryEntry> largest(size_t count) const;
+
+private:
+    MemoryAccounting() = default;
+
+    typedef std::pair<const void*, int> Key;
+
+    mutable std::mutex mutex;
+    std::map<Key, MemoryEntry> entries;
+};
+
+// GPU bytes of levels mips of a width x height texture with layers layers (6 for a cubemap).
+// Only covers the uncompressed formats created with glTexImage, BC textures are measured from their payload.
+size_t gpuTextureBytes(GLenum internalFormat, int width, int height, int levels = 1, int layers = 1);
+// levels in a full mip chain down to 1x1
+int mipLevelCount(int width, int height);
+
+#endif
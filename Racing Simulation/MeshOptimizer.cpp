@@ -0,0 +1,316 @@
+#include "MeshOptimizer.h"
+#include "FileUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+// Forsyth scoring parameters, the cache size models a typical post-transform cache
+const int FORSYTH_CACHE_SIZE = 32;
+const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+void MeshOptimizationStats::print(const std::string& name) const {
+    std::cout << "Mesh optimization [" << name << "]: vertices " << verticesBefore << " -> " << verticesAfter
+        << ", draws " << drawsBefore << " -> " << drawsAfter
+        << ", triangles " << triangles
+        << ", ACMR " << acmrBefore << " -> " << acmrAfter
+        << ", 16-bit indices " << shortIndexMeshes << "/" << drawsAfter << std::endl;
+}
+
+// Hashes and compares vertices by their index into a vertex array, lets the weld map store indices only
+struct VertexIndexHash {
+    const std::vector<Vertex>* vertices;
+    size_t operator()(unsigned int index) const {
+        return static_cast<size_t>(hashBytes(&(*vertices)[index], sizeof(Vertex)));
+    }
+};
+
+struct VertexIndexEqual {
+    const std::vector<Vertex>* vertices;
+    bool operator()(unsigned int a, unsigned int b) const {
+        return std::memcmp(&(*vertices)[a], &(*vertices)[b], sizeof(Vertex)) == 0;
+    }
+};
+
+void weldVertices(MeshData& mesh) {
+    std::vector<Vertex>& vertices = mesh.vertices;
+    std::unordered_map<unsigned int, unsigned int, VertexIndexHash, VertexIndexEqual> unique(
+        vertices.size(), VertexIndexHash{ &vertices }, VertexIndexEqual{ &vertices });
+
+    // first pass maps every vertex to the first identical one, the remap is applied in place afterwards
+    std::vector<unsigned int> remap(vertices.size());
+    std::vector<Vertex> welded;
+    welded.reserve(vertices.size());
+    for (unsigned int i = 0; i < vertices.size(); ++i) {
+        auto inserted = unique.insert(std::make_pair(i, static_cast<unsigned int>(welded.size())));
+        if (inserted.second) welded.push_back(vertices[i]);
+        remap[i] = inserted.first->second;
+    }
+
+    for (unsigned int& index : mesh.indices) {
+        index = remap[index];
+    }
+    vertices.swap(welded);
+}
+
+void mergeByMaterial(std::vector<MeshData>& meshes) {
+    std::vector<MeshData> merged;
+    for (MeshData& mesh : meshes) {
+        MeshData* target = nullptr;
+        for (MeshData& candidate : merged) {
+            if (candidate.materialIndex == mesh.materialIndex && candidate.format == mesh.format) {
+                target = &candidate;
+                break;
+            }
+        }
+        if (!target) {
+            merged.push_back(std::move(mesh));
+            continue;
+        }
+
+        unsigned int baseVertex = static_cast<unsigned int>(target->vertices.size());
+        target->vertices.insert(target->vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+        for (unsigned int index : mesh.indices) {
+            target->indices.push_back(index + baseVertex);
+        }
+    }
+    meshes.swap(merged);
+}
+
+static float forsythVertexScore(int cachePosition, unsigned int remainingTriangles) {
+    if (remainingTriangles == 0) return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // the vertices of the triangle just emitted get a fixed score so that strips aren't favoured over fans
+            score = FORSYTH_LAST_TRIANGLE_SCORE;
+        }
+        else {
+            float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+    // boost vertices with few triangles left so they get finished off instead of reloaded later
+    score += FORSYTH_VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -FORSYTH_VALENCE_BOOST_POWER);
+    return score;
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) return;
+
+    // vertex -> triangle adjacency, the first remaining[v] entries of each range are the unemitted triangles
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (unsigned int index : indices) remaining[index]++;
+
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + remaining[v];
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (int k = 0; k < 3; ++k) adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) vertexScore[v] = forsythVertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    int bestTriangle = 0;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        if (triangleScore[t] > triangleScore[bestTriangle]) bestTriangle = static_cast<int>(t);
+    }
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    std::vector<unsigned int> cache, newCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+    size_t scanCursor = 0;
+
+    while (output.size() < indices.size()) {
+        if (bestTriangle < 0) {
+            // nothing in the cache touches an unemitted triangle, continue with the next one in the input
+            while (emitted[scanCursor]) scanCursor++;
+            bestTriangle = static_cast<int>(scanCursor);
+        }
+
+        const unsigned int* triangle = &indices[bestTriangle * 3];
+        emitted[bestTriangle] = true;
+        newCache.assign(triangle, triangle + 3);
+        for (int k = 0; k < 3; ++k) {
+            unsigned int v = triangle[k];
+            output.push_back(v);
+
+            // swap the emitted triangle out of the remaining part of the adjacency range
+            unsigned int* begin = &adjacency[offsets[v]];
+            unsigned int* end = begin + remaining[v];
+            unsigned int* found = std::find(begin, end, static_cast<unsigned int>(bestTriangle));
+            std::swap(*found, *(end - 1));
+            remaining[v]--;
+        }
+
+        for (unsigned int v : cache) {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) newCache.push_back(v);
+        }
+
+        // rescore everything that entered, moved in or fell out of the cache
+        for (size_t i = 0; i < newCache.size(); ++i) {
+            unsigned int v = newCache[i];
+            cachePosition[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+            float score = forsythVertexScore(cachePosition[v], remaining[v]);
+            float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+            for (unsigned int a = offsets[v]; a < offsets[v] + remaining[v]; ++a) {
+                triangleScore[adjacency[a]] += delta;
+            }
+        }
+        if (newCache.size() > FORSYTH_CACHE_SIZE) newCache.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(newCache);
+
+        // only triangles touching the cache can score well
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (unsigned int v : cache) {
+            for (unsigned int a = offsets[v]; a < offsets[v] + remaining[v]; ++a) {
+                unsigned int t = adjacency[a];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    bestTriangle = static_cast<int>(t);
+                }
+            }
+        }
+    }
+    indices.swap(output);
+}
+
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) return;
+
+    // cluster boundaries go where the cache order restarts anyway (a triangle missing on all three
+    // vertices), so moving clusters around costs next to nothing in vertex cache efficiency
+    const unsigned int cacheSize = 16;
+    std::vector<unsigned int> cacheTime(vertices.size(), 0);
+    unsigned int time = cacheSize + 1;
+    std::vector<size_t> clusterStarts;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        int misses = 0;
+        for (int k = 0; k < 3; ++k) {
+            unsigned int v = indices[t * 3 + k];
+            if (time - cacheTime[v] > cacheSize) {
+                cacheTime[v] = time++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3) clusterStarts.push_back(t);
+    }
+    if (clusterStarts.size() < 2) return;
+    clusterStarts.push_back(triangleCount);
+
+    glm::vec3 meshCentroid(0.0f);
+    for (const Vertex& vertex : vertices) meshCentroid += vertex.Position;
+    meshCentroid /= static_cast<float>(vertices.size());
+
+    // sort key: how far the cluster sits out along its own average normal
+    struct Cluster { size_t start, end; float key; };
+    std::vector<Cluster> clusters;
+    for (size_t c = 0; c + 1 < clusterStarts.size(); ++c) {
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t) {
+            const glm::vec3& p0 = vertices[indices[t * 3]].Position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Position;
+            centroid += (p0 + p1 + p2) / 3.0f;
+            normal += glm::cross(p1 - p0, p2 - p0);  // area weighted
+        }
+        centroid /= static_cast<float>(clusterStarts[c + 1] - clusterStarts[c]);
+        float length = glm::length(normal);
+        float key = length > 0.0f ? glm::dot(centroid - meshCentroid, normal / length) : 0.0f;
+        clusters.push_back({ clusterStarts[c], clusterStarts[c + 1], key });
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.key > b.key; });
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    for (const Cluster& cluster : clusters) {
+        output.insert(output.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+    }
+    indices.swap(output);
+}
+
+void optimizeVertexFetch(MeshData& mesh) {
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(mesh.vertices.size(), unused);
+    std::vector<Vertex> ordered;
+    ordered.reserve(mesh.vertices.size());
+
+    for (unsigned int& index : mesh.indices) {
+        if (remap[index] == unused) {
+            remap[index] = static_cast<unsigned int>(ordered.size());
+            ordered.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices.swap(ordered);
+}
+
+float computeACMR(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize) {
+    if (indices.size() < 3) return 0.0f;
+
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    size_t misses = 0;
+    for (unsigned int index : indices) {
+        if (time - cacheTime[index] > cacheSize) {
+            cacheTime[index] = time++;
+            misses++;
+        }
+    }
+    return static_cast<float>(misses) / (indices.size() / 3);
+}
+
+// ACMR over all meshes, weighted by triangle count
+static float combinedACMR(const std::vector<MeshData>& meshes) {
+    float weighted = 0.0f;
+    size_t triangles = 0;
+    for (const MeshData& mesh : meshes) {
+        size_t count = mesh.indices.size() / 3;
+        weighted += computeACMR(mesh.indices, mesh.vertices.size()) * count;
+        triangles += count;
+    }
+    return triangles > 0 ? weighted / triangles : 0.0f;
+}
+
+void optimizeMeshes(std::vector<MeshData>& meshes, MeshOptimizationStats& stats) {
+    stats.drawsBefore = meshes.size();
+    for (const MeshData& mesh : meshes) stats.verticesBefore += mesh.vertices.size();
+    stats.acmrBefore = combinedACMR(meshes);
+
+    // merge first so vertices shared between meshes of one material get welded too
+    mergeByMaterial(meshes);
+    for (MeshData& mesh : meshes) {
+        weldVertices(mesh);
+        optimizeVertexCache(mesh.indices, mesh.vertices.size());
+        optimizeOverdraw(mesh.indices, mesh.vertices);
+        optimizeVertexFetch(mesh);
+    }
+
+    stats.drawsAfter = meshes.size();
+    for (const MeshData& mesh : meshes) {
+        stats.verticesAfter += mesh.vertices.size();
+        stats.triangles += mesh.indices.size() / 3;
+        if (mesh.vertices.size() <= MAX_SHORT_INDEX_VERTICES) stats.shortIndexMeshes++;
+    }
+    stats.acmrAfter = combinedACMR(meshes);
+}
@@ -0,0 +1,46 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include "mesh.h"
+
+#include <string>
+#include <vector>
+
+// Counts gathered over one model's import, printed after loading
+struct MeshOptimizationStats {
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+    size_t drawsBefore = 0;
+    size_t drawsAfter = 0;
+    size_t triangles = 0;
+    size_t shortIndexMeshes = 0;  // meshes that ended up small enough for 16 bit indices
+    float acmrBefore = 0.0f;      // average cache miss ratio, post-transform cache misses per triangle
+    float acmrAfter = 0.0f;
+
+    void print(const std::string& name) const;
+};
+
+// Runs the whole import pipeline on the meshes of one model: weld, merge by material,
+// vertex cache order, overdraw order and vertex fetch order.
+void optimizeMeshes(std::vector<MeshData>& meshes, MeshOptimizationStats& stats);
+
+// Merges bit-identical vertices and rewrites the indices to match
+void weldVertices(MeshData& mesh);
+
+// Concatenates meshes that share a material (and vertex format) into a single draw
+void mergeByMaterial(std::vector<MeshData>& meshes);
+
+// Reorders triangles for the post-transform vertex cache (Forsyth's linear-speed algorithm)
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+
+// Splits the cache-ordered triangles into clusters and draws outward facing clusters first,
+// so the outer shell of a mesh occludes its inner surfaces. Keeps the cache order within clusters.
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices);
+
+// Reorders the vertices into the order they are first referenced by the indices
+void optimizeVertexFetch(MeshData& mesh);
+
+// Simulated FIFO cache misses per triangle, 0.5 is ideal and 3.0 means no reuse at all
+float computeACMR(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = 16);
+
+#endif
@@ -0,0 +1,280 @@
+#include "ModelCache.h"
+#include "FileUtils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Bump whenever the file layout, the packed vertex format or the import optimizations change
+const uint32_t MODEL_CACHE_VERSION = 2;
+const char MODEL_CACHE_MAGIC[4] = { 'R', 'M', 'D', 'L' };
+// blobs start on this boundary so mapped data can be read in place
+const uint64_t MODEL_CACHE_ALIGNMENT = 16;
+// how far into an .obj to look for its mtllib line, exporters write it at the top
+const size_t MATERIAL_SEARCH_BYTES = 64 * 1024;
+
+struct ModelCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceSize;
+    uint64_t sourceTime;
+    uint64_t materialSize;   // stamp of the material file, both 0 when there is none
+    uint64_t materialTime;
+    uint32_t meshCount;
+    uint32_t textureCount;
+    uint64_t stringTableOffset;
+    uint64_t stringTableSize;
+};
+
+// followed by textureCount of these, then meshCount ModelCacheMesh records
+struct ModelCacheTexture {
+    uint32_t typeOffset;  // into the string table
+    uint32_t typeLength;
+    uint32_t pathOffset;
+    uint32_t pathLength;
+};
+
+struct ModelCacheMesh {
+    uint32_t format;         // VertexFormat
+    uint32_t indexType;      // GL_UNSIGNED_SHORT / GL_UNSIGNED_INT
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    float positionScale[3];
+    float positionOffset[3];
+    float uvScale[2];
+    float uvOffset[2];
+    uint32_t firstTexture;   // range in the texture table
+    uint32_t textureCount;
+    uint64_t vertexOffset;
+    uint64_t vertexSize;
+    uint64_t indexOffset;
+    uint64_t indexSize;
+    uint64_t positionsOffset;  // vertexCount * vec3, exact float positions
+};
+
+static uint64_t alignOffset(uint64_t offset) {
+    return (offset + MODEL_CACHE_ALIGNMENT - 1) & ~(MODEL_CACHE_ALIGNMENT - 1);
+}
+
+static bool rangeInFile(uint64_t offset, uint64_t size, size_t fileSize) {
+    return offset <= fileSize && size <= fileSize - offset;
+}
+
+// The .mtl named by the obj's mtllib line, or the model's own name with .mtl when there is none
+static std::string materialPathFor(const std::string& sourcePath) {
+    std::string directory;
+    size_t slash = sourcePath.find_last_of('/');
+    if (slash != std::string::npos) directory = sourcePath.substr(0, slash + 1);
+
+    std::ifstream file(sourcePath);
+    std::string line;
+    size_t read = 0;
+    while (read < MATERIAL_SEARCH_BYTES && std::getline(file, line)) {
+        read += line.size() + 1;
+        if (line.compare(0, 7, "mtllib ") != 0) continue;
+        size_t end = line.find_last_not_of(" \t\r");
+        return directory + line.substr(7, end == std::string::npos ? std::string::npos : end - 6);
+    }
+    return sourcePath.substr(0, sourcePath.find_last_of('.')) + ".mtl";
+}
+
+// the materials decide the texture paths kept in the cache, so an edited .mtl makes it stale too
+static void materialStamp(const std::string& sourcePath, uint64_t& size, uint64_t& modifiedTime) {
+    if (!fileStamp(materialPathFor(sourcePath), size, modifiedTime)) size = modifiedTime = 0;
+}
+
+ModelCache::ModelCache(const std::string& cacheDirectory) : cacheDirectory(cacheDirectory) {}
+
+std::string ModelCache::cachePathFor(const std::string& sourcePath) const {
+    return cacheDirectory + "/" + flattenPath(sourcePath) + ".rmdl";
+}
+
+bool ModelCache::load(const std::string& sourcePath, MappedFile& file, std::vector<CachedMesh>& meshes) const {
+    uint64_t sourceSize, sourceTime;
+    if (!fileStamp(sourcePath, sourceSize, sourceTime)) return false;
+    if (!file.open(cachePathFor(sourcePath))) return false;
+    // every return below that fails leaves the file closed
+    struct CloseOnFailure {
+        MappedFile& file;
+        bool succeeded;
+        ~CloseOnFailure() { if (!succeeded) file.close(); }
+    } guard = { file, false };
+    uint64_t materialSize, materialTime;
+    materialStamp(sourcePath, materialSize, materialTime);
+
+    const char* data = file.data();
+    size_t fileSize = file.size();
+    if (fileSize < sizeof(ModelCacheHeader)) return false;
+
+    ModelCacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (!std::equal(MODEL_CACHE_MAGIC, MODEL_CACHE_MAGIC + 4, header.magic) || header.version != MODEL_CACHE_VERSION ||
+        header.sourceSize != sourceSize || header.sourceTime != sourceTime ||
+        header.materialSize != materialSize || header.materialTime != materialTime) {
+        std::cout << "Model cache stale for " << sourcePath << ", reimporting" << std::endl;
+        return false;
+    }
+
+    uint64_t tablesSize = static_cast<uint64_t>(header.textureCount) * sizeof(ModelCacheTexture) +
+        static_cast<uint64_t>(header.meshCount) * sizeof(ModelCacheMesh);
+    if (!rangeInFile(sizeof(header), tablesSize, fileSize) ||
+        !rangeInFile(header.stringTableOffset, header.stringTableSize, fileSize)) {
+        return false;
+    }
+
+    const char* strings = data + header.stringTableOffset;
+    std::vector<CachedTextureRef> textures(header.textureCount);
+    for (uint32_t t = 0; t < header.textureCount; ++t) {
+        ModelCacheTexture record;
+        std::memcpy(&record, data + sizeof(header) + t * sizeof(ModelCacheTexture), sizeof(record));
+        if (static_cast<uint64_t>(record.typeOffset) + record.typeLength > header.stringTableSize ||
+            static_cast<uint64_t>(record.pathOffset) + record.pathLength > header.stringTableSize) {
+            return false;
+        }
+        textures[t].type.assign(strings + record.typeOffset, record.typeLength);
+        textures[t].path.assign(strings + record.pathOffset, record.pathLength);
+    }
+
+    const char* meshTable = data + sizeof(header) + header.textureCount * sizeof(ModelCacheTexture);
+    meshes.resize(header.meshCount);
+    for (uint32_t m = 0; m < header.meshCount; ++m) {
+        ModelCacheMesh record;
+        std::memcpy(&record, meshTable + m * sizeof(ModelCacheMesh), sizeof(record));
+
+        uint64_t positionsSize = static_cast<uint64_t>(record.vertexCount) * sizeof(glm::vec3);
+        if (!rangeInFile(record.vertexOffset, record.vertexSize, fileSize) ||
+            !rangeInFile(record.indexOffset, record.indexSize, fileSize) ||
+            !rangeInFile(record.positionsOffset, positionsSize, fileSize) ||
+            static_cast<uint64_t>(record.firstTexture) + record.textureCount > header.textureCount) {
+            meshes.clear();
+            return false;
+        }
+
+        CachedMesh& mesh = meshes[m];
+        mesh.layout.format = static_cast<VertexFormat>(record.format);
+        mesh.layout.indexType = record.indexType;
+        mesh.layout.positionScale = glm::vec3(record.positionScale[0], record.positionScale[1], record.positionScale[2]);
+        mesh.layout.positionOffset = glm::vec3(record.positionOffset[0], record.positionOffset[1], record.positionOffset[2]);
+        mesh.layout.uvScale = glm::vec2(record.uvScale[0], record.uvScale[1]);
+        mesh.layout.uvOffset = glm::vec2(record.uvOffset[0], record.uvOffset[1]);
+        mesh.vertexCount = record.vertexCount;
+        mesh.indexCount = record.indexCount;
+        mesh.vertexData = data + record.vertexOffset;
+        mesh.vertexSize = static_cast<size_t>(record.vertexSize);
+        mesh.indexData = data + record.indexOffset;
+        mesh.indexSize = static_cast<size_t>(record.indexSize);
+        mesh.positions = reinterpret_cast<const glm::vec3*>(data + record.positionsOffset);
+        mesh.textures.assign(textures.begin() + record.firstTexture, textures.begin() + record.firstTexture + record.textureCount);
+    }
+    guard.succeeded = true;
+    return true;
+}
+
+bool ModelCache::save(const std::string& sourcePath, const std::vector<MeshData>& meshes) const {
+    uint64_t sourceSize, sourceTime;
+    if (!fileStamp(sourcePath, sourceSize, sourceTime)) return false;
+    if (!ensureDirectory(cacheDirectory)) {
+        std::cout << "Failed to create model cache directory: " << cacheDirectory << std::endl;
+        return false;
+    }
+
+    // build the GPU blobs exactly as Mesh would upload them
+    std::vector<std::vector<char>> vertexBlobs(meshes.size()), indexBlobs(meshes.size());
+    std::vector<ModelCacheMesh> meshRecords(meshes.size());
+    std::vector<ModelCacheTexture> textureRecords;
+    std::string strings;
+
+    uint64_t offset = sizeof(ModelCacheHeader);
+    for (const MeshData& mesh : meshes) offset += mesh.textures.size() * sizeof(ModelCacheTexture);
+    offset += meshes.size() * sizeof(ModelCacheMesh);
+
+    for (size_t m = 0; m < meshes.size(); ++m) {
+        const MeshData& mesh = meshes[m];
+        MeshLayout layout = Mesh::buildBuffers(mesh.vertices, mesh.indices, mesh.format, vertexBlobs[m], indexBlobs[m]);
+
+        ModelCacheMesh& record = meshRecords[m];
+        record = {};
+        record.format = static_cast<uint32_t>(layout.format);
+        record.indexType = layout.indexType;
+        record.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        record.indexCount = static_cast<uint32_t>(mesh.indices.size());
+        for (int c = 0; c < 3; ++c) {
+            record.positionScale[c] = layout.positionScale[c];
+            record.positionOffset[c] = layout.positionOffset[c];
+        }
+        for (int c = 0; c < 2; ++c) {
+            record.uvScale[c] = layout.uvScale[c];
+            record.uvOffset[c] = layout.uvOffset[c];
+        }
+
+        record.firstTexture = static_cast<uint32_t>(textureRecords.size());
+        record.textureCount = static_cast<uint32_t>(mesh.textures.size());
+        for (const Texture& texture : mesh.textures) {
+            ModelCacheTexture textureRecord;
+            textureRecord.typeOffset = static_cast<uint32_t>(strings.size());
+            textureRecord.typeLength = static_cast<uint32_t>(texture.type.size());
+            strings += texture.type;
+            textureRecord.pathOffset = static_cast<uint32_t>(strings.size());
+            textureRecord.pathLength = static_cast<uint32_t>(texture.path.size());
+            strings += texture.path;
+            textureRecords.push_back(textureRecord);
+        }
+
+        record.vertexOffset = offset = alignOffset(offset);
+        record.vertexSize = vertexBlobs[m].size();
+        offset += record.vertexSize;
+        record.indexOffset = offset = alignOffset(offset);
+        record.indexSize = indexBlobs[m].size();
+        offset += record.indexSize;
+        record.positionsOffset = offset = alignOffset(offset);
+        offset += mesh.vertices.size() * sizeof(glm::vec3);
+    }
+
+    ModelCacheHeader header = {};
+    std::copy(MODEL_CACHE_MAGIC, MODEL_CACHE_MAGIC + 4, header.magic);
+    header.version = MODEL_CACHE_VERSION;
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+    materialStamp(sourcePath, header.materialSize, header.materialTime);
+    header.meshCount = static_cast<uint32_t>(meshes.size());
+    header.textureCount = static_cast<uint32_t>(textureRecords.size());
+    header.stringTableOffset = alignOffset(offset);
+    header.stringTableSize = strings.size();
+
+    std::ofstream file(cachePathFor(sourcePath), std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    uint64_t written = 0;
+    auto write = [&](const void* bytes, uint64_t size) {
+        file.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+        written += size;
+    };
+    auto padTo = [&](uint64_t target) {
+        static const char zeros[MODEL_CACHE_ALIGNMENT] = {};
+        if (target > written) write(zeros, target - written);
+    };
+
+    write(&header, sizeof(header));
+    if (!textureRecords.empty()) write(textureRecords.data(), textureRecords.size() * sizeof(ModelCacheTexture));
+    if (!meshRecords.empty()) write(meshRecords.data(), meshRecords.size() * sizeof(ModelCacheMesh));
+
+    for (size_t m = 0; m < meshes.size(); ++m) {
+        const ModelCacheMesh& record = meshRecords[m];
+        padTo(record.vertexOffset);
+        write(vertexBlobs[m].data(), vertexBlobs[m].size());
+        padTo(record.indexOffset);
+        write(indexBlobs[m].data(), indexBlobs[m].size());
+        padTo(record.positionsOffset);
+        for (const Vertex& vertex : meshes[m].vertices) write(&vertex.Position, sizeof(glm::vec3));
+    }
+    padTo(header.stringTableOffset);
+    write(strings.data(), strings.size());
+
+    if (!file) {
+        std::cout << "Failed to write model cache for " << sourcePath << std::endl;
+        return false;
+    }
+    std::cout << "Model cache written for " << sourcePath << std::endl;
+    return true;
+}
@@ -0,0 +1,51 @@
+#ifndef MODEL_CACHE_H
+#define MODEL_CACHE_H
+
+#include "mesh.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Directory the cooked models are written to, next to the IBL cache
+const char* const MODEL_CACHE_DIRECTORY = "Cache";
+
+struct CachedTextureRef {
+    std::string type;  // texture_albedo, texture_normal, ...
+    std::string path;  // relative to the model directory, as in the material
+};
+
+// One submesh of a cooked model. The pointers point into the mapped cache file.
+struct CachedMesh {
+    MeshLayout layout;
+    unsigned int vertexCount = 0;
+    unsigned int indexCount = 0;
+    const char* vertexData = nullptr;   // in GPU layout, ready for glBufferData
+    size_t vertexSize = 0;
+    const char* indexData = nullptr;    // 16 or 32 bit as given by layout.indexType
+    size_t indexSize = 0;
+    const glm::vec3* positions = nullptr;  // exact positions for CPU side use such as collision
+    std::vector<CachedTextureRef> textures;
+};
+
+// Cooked binary form of an imported (and optimized) model, stored in Cache/ so later launches skip Assimp.
+// A cache file is used only while the size and modification time of the source file, and of its .mtl,
+// match its stamp.
+class ModelCache {
+public:
+    ModelCache(const std::string& cacheDirectory);
+
+    // Maps the cooked file for sourcePath, returns false when it is missing, stale or damaged.
+    // The returned meshes point into file and stay valid while it is open.
+    bool load(const std::string& sourcePath, MappedFile& file, std::vector<CachedMesh>& meshes) const;
+
+    bool save(const std::string& sourcePath, const std::vector<MeshData>& meshes) const;
+
+private:
+    std::string cachePathFor(const std::string& sourcePath) const;
+
+    std::string cacheDirectory;
+};
+
+#endif
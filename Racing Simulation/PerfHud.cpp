@@ -0,0 +1,194 @@
+#include "PerfHud.h"
+#include "TextRenderer.h"
+#include "MemoryAccounting.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+RenderStats renderStats;
+
+static const char* const PASS_NAMES[] = { "Shadows", "Track", "Cars", "Sky", "Text", "IBL" };
+
+void PerfHud::init() {
+    glGenQueries(QUERY_FRAMES * PASS_COUNT, &queries[0][0]);
+    initialized = true;
+}
+
+void PerfHud::toggle() {
+    visible = !visible;
+}
+
+double PerfHud::millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PerfHud::beginFrame() {
+    auto now = std::chrono::steady_clock::now();
+    if (hasFrameStart) {
+        frameMs = std::chrono::duration<double, std::milli>(now - frameStart).count();
+        frameHistory[historyHead] = static_cast<float>(frameMs);
+        historyHead = (historyHead + 1) % GRAPH_FRAMES;
+    }
+    frameStart = now;
+    hasFrameStart = true;
+
+    simulationMs = simulationAccumMs;
+    simulationAccumMs = 0.0;
+    lastFrameStats = renderStats;
+    renderStats.reset();
+
+    frameIndex++;
+    if (!initialized) return;
+
+    // this frame reuses the queries of QUERY_FRAMES ago, read whatever of them has landed
+    int slot = static_cast<int>(frameIndex % QUERY_FRAMES);
+    for (int pass = 0; pass < PASS_COUNT; ++pass) {
+        if (!queryIssued[slot][pass]) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(queries[slot][pass], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 elapsedNs = 0;
+            glGetQueryObjectui64v(queries[slot][pass], GL_QUERY_RESULT, &elapsedNs);
+            passMs[pass] = elapsedNs / 1e6;
+        }
+        // a result still missing after a whole ring is dropped rather than waited for
+        queryIssued[slot][pass] = false;
+    }
+}
+
+void PerfHud::endFrame() {
+    cpuMs = millisecondsSince(frameStart);
+}
+
+void PerfHud::beginPass(GpuPass pass) {
+    if ((!visible && !timingEnabled) || !initialized) return;
+    int index = static_cast<int>(pass);
+    int slot = static_cast<int>(frameIndex % QUERY_FRAMES);
+    glBeginQuery(GL_TIME_ELAPSED, queries[slot][index]);
+    passOpen[index] = true;
+}
+
+void PerfHud::endPass(GpuPass pass) {
+    int index = static_cast<int>(pass);
+    if (!passOpen[index]) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    passOpen[index] = false;
+    queryIssued[frameIndex % QUERY_FRAMES][index] = true;
+}
+
+void PerfHud::addSimulationTime(double ms) {
+    simulationAccumMs += ms;
+}
+
+void PerfHud::draw(Shader& textShader, float screenWidth, float screenHeight) {
+    if (!visible) return;
+
+    const float left = screenWidth - 560.0f;
+    const float lineHeight = 26.0f;
+    const float scale = 0.5f;
+    const glm::vec3 color(1.0f, 1.0f, 0.6f);
+    float y = screenHeight - 40.0f;
+
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1);
+    line << "FPS " << (frameMs > 0.0 ? 1000.0 / frameMs : 0.0) << "  Frame " << frameMs << " ms  CPU " << cpuMs
+        << " ms  Sim " << std::setprecision(2) << simulationMs << " ms";
+    RenderText(textShader, line.str(), left, y, scale, color);
+
+    // two rows of three passes
+    for (int row = 0; row < 2; ++row) {
+        y -= lineHeight;
+        line.str("");
+        line << (row == 0 ? "GPU ms  " : "        ");
+        for (int pass = row * 3; pass < row * 3 + 3; ++pass) {
+            line << PASS_NAMES[pass] << " " << passMs[pass] << "  ";
+        }
+        RenderText(textShader, line.str(), left, y, scale, color);
+    }
+
+    y -= lineHeight;
+    line.str("");
+    line << "Draws " << lastFrameStats.drawCalls << "  Triangles " << std::setprecision(2) << lastFrameStats.triangles / 1e6 << "M";
+    RenderText(textShader, line.str(), left, y, scale, color);
+
+    if (framePacer) {
+        // over the whole session, the graph below only shows the last couple of seconds
+        const FrameTimeHistogram& frameTimes = framePacer->histogram();
+        y -= lineHeight;
+        line.str("");
+        line << std::setprecision(1) << pacingModeName(framePacer->mode()) << "  p50 " << frameTimes.percentile(50.0) / 1000.0
+            << "  p99 " << frameTimes.percentile(99.0) / 1000.0 << "  p99.9 " << frameTimes.percentile(99.9) / 1000.0
+            << "  max " << frameTimes.maximum() / 1000.0 << " ms  Stutters " << framePacer->stutterCount();
+        RenderText(textShader, line.str(), left, y, scale, color);
+    }
+
+    // frame time graph, oldest on the left, full height is 50 ms
+    const float graphHeight = 80.0f;
+    const float barWidth = 4.0f;
+    const float maxMs = 50.0f;
+    float graphBottom = y - 20.0f - graphHeight;
+    std::vector<glm::vec4> bars, slowBars;
+    for (int i = 0; i < GRAPH_FRAMES; ++i) {
+        float ms = frameHistory[(historyHead + i) % GRAPH_FRAMES];
+        float height = std::min(ms / maxMs, 1.0f) * graphHeight;
+        glm::vec4 bar(left + i * barWidth, graphBottom, barWidth - 1.0f, std::max(height, 1.0f));
+        // anything slower than 60 Hz shows in red
+        (ms > 1000.0f / 60.0f + 1.0f ? slowBars : bars).push_back(bar);
+    }
+    float targetY = graphBottom + (1000.0f / 60.0f) / maxMs * graphHeight;
+    RenderRects(textShader, { glm::vec4(left, graphBottom, GRAPH_FRAMES * barWidth, 1.0f), glm::vec4(left, targetY, GRAPH_FRAMES * barWidth, 1.0f) },
+        glm::vec3(0.5f));
+    RenderRects(textShader, bars, glm::vec3(0.3f, 0.9f, 0.3f));
+    RenderRects(textShader, slowBars, glm::vec3(0.9f, 0.3f, 0.3f));
+
+    drawMemory(textShader, left, graphBottom - 20.0f - lineHeight, lineHeight, scale);
+}
+
+static double megabytes(size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+void PerfHud::drawMemory(Shader& textShader, float left, float y, float lineHeight, float scale) {
+    const glm::vec3 color(0.7f, 0.9f, 1.0f);
+    const MemoryAccounting& memory = MemoryAccounting::get();
+
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1);
+    MemoryBytes total = memory.total();
+    line << "Memory MB  CPU " << megabytes(total.cpu) << "  GPU " << megabytes(total.gpu);
+    RenderText(textShader, line.str(), left, y, scale, color);
+
+    if (residency) {
+        ResidencyStats stats = residency->stats();
+        y -= lineHeight;
+        line.str("");
+        line << "  Models " << stats.residentAssets << "/" << stats.registeredAssets << " resident, " << stats.referencedAssets
+            << " held  CPU " << megabytes(stats.cpuBytes) << "/" << megabytes(stats.cpuBudget) << "  GPU "
+            << megabytes(stats.gpuBytes) << "/" << megabytes(stats.gpuBudget) << "  Loads " << stats.loads
+            << "  Evicted " << stats.evictions;
+        RenderText(textShader, line.str(), left, y, scale, color);
+    }
+
+    for (int category = 0; category < static_cast<int>(MemoryCategory::Count); ++category) {
+        MemoryBytes bytes = memory.categoryTotal(static_cast<MemoryCategory>(category));
+        if (bytes.cpu == 0 && bytes.gpu == 0) continue;
+        y -= lineHeight;
+        line.str("");
+        line << "  " << memoryCategoryName(static_cast<MemoryCategory>(category)) << "  CPU " << megabytes(bytes.cpu)
+            << "  GPU " << megabytes(bytes.gpu);
+        RenderText(textShader, line.str(), left, y, scale, color);
+    }
+
+    y -= lineHeight;
+    RenderText(textShader, "Largest", left, y, scale, color);
+    for (const MemoryEntry& entry : memory.largest(MEMORY_TOP_ENTRIES)) {
+        y -= lineHeight;
+        line.str("");
+        // the end of a long path says the most
+        std::string name = entry.name.size() > 28 ? "..." + entry.name.substr(entry.name.size() - 25) : entry.name;
+        line << "  " << name << "  " << megabytes(entry.bytes.cpu + entry.bytes.gpu);
+        RenderText(textShader, line.str(), left, y, scale, color);
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef PERF_HUD_H
+#define PERF_HUD_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <string>
+
+#include "shader_m.h"
+#include "RenderStats.h"
+#include "FramePacer.h"
+#include "ResidencyManager.h"
+
+enum class GpuPass {
+    Shadows,
+    Track,
+    Cars,
+    Skybox,
+    Text,
+    IBL,
+    Count
+};
+
+// Frame statistics overlay, toggled with [F3]. Shows CPU frame and simulation times, the GPU time of each
+// pass, draw calls, triangles, the frame pacing percentiles, a graph of recent frame times, the
+// MemoryAccounting totals and the model residency.
+// GPU passes are timed with GL_TIME_ELAPSED queries kept in a ring a few frames deep, a result is only read
+// once the driver reports it available so the overlay never stalls the pipeline. Nothing is queried while
+// the overlay is hidden, unless setTimingEnabled() asks for it.
+class PerfHud {
+public:
+    // GL thread, after the context exists
+    void init();
+
+    void toggle();
+    bool isVisible() const { return visible; }
+
+    // start of the frame: collects finished GPU timings and resets the draw counters
+    void beginFrame();
+    // before the buffer swap, so the CPU time excludes waiting for vsync
+    void endFrame();
+
+    void beginPass(GpuPass pass);
+    void endPass(GpuPass pass);
+
+    // summed over the frame, the simulation runs in a few separate places of the loop
+    void addSimulationTime(double ms);
+
+    void draw(Shader& textShader, float screenWidth, float screenHeight);
+
+    // keeps the GPU queries running while the overlay is hidden, for the render benchmark
+    void setTimingEnabled(bool enabled) { timingEnabled = enabled; }
+    // source of the pacing line, left out while null
+    void setFramePacer(const FramePacer* pacer) { framePacer = pacer; }
+    // source of the residency line, left out while null
+    void setResidencyManager(const ResidencyManager* manager) { residency = manager; }
+
+    // the last finished frame
+    double frameMilliseconds() const { return frameMs; }
+    double cpuMilliseconds() const { return cpuMs; }
+    double simulationMilliseconds() const { return simulationMs; }
+    const RenderStats& frameStats() const { return lastFrameStats; }
+    // the newest result that has landed, a few frames old
+    double passMilliseconds(GpuPass pass) const { return passMs[static_cast<int>(pass)]; }
+
+    static double millisecondsSince(std::chrono::steady_clock::time_point start);
+
+    static const int PASS_COUNT = static_cast<int>(GpuPass::Count);
+
+private:
+    static const int QUERY_FRAMES = 4;      // how many frames a GPU result may lag behind
+    static const int GRAPH_FRAMES = 120;
+    static const int MEMORY_TOP_ENTRIES = 5;
+
+    // per category and the largest owners, top line at y
+    void drawMemory(Shader& textShader, float left, float y, float lineHeight, float scale);
+
+    bool visible = false;
+    bool timingEnabled = false;
+    bool initialized = false;
+
+    unsigned int queries[QUERY_FRAMES][PASS_COUNT] = {};
+    bool queryIssued[QUERY_FRAMES][PASS_COUNT] = {};
+    bool passOpen[PASS_COUNT] = {};
+    double passMs[PASS_COUNT] = {};
+    unsigned long long frameIndex = 0;
+
+    std::chrono::steady_clock::time_point frameStart;
+    bool hasFrameStart = false;
+    double frameMs = 0.0;           // wall time of the last frame, start to start
+    double cpuMs = 0.0;             // start of the frame to the swap
+    double simulationMs = 0.0;
+    double simulationAccumMs = 0.0;
+    RenderStats lastFrameStats;
+    const FramePacer* framePacer = nullptr;
+    const ResidencyManager* residency = nullptr;
+
+    float frameHistory[GRAPH_FRAMES] = {};
+    int historyHead = 0;
+};
+
+#endif
@@ -0,0 +1,210 @@
+#include "PhysicsRegression.h"
+#include "Car.h"
+#include "DriveInput.h"
+#include "FileUtils.h"
+#include "TrackGrid.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+const float REGRESSION_TIMESTEP = 1.0f / 60.0f;
+
+struct TrajectoryFrame {
+    glm::vec3 position;
+    float rotation;
+    float speed;
+};
+
+struct RegressionResult {
+    std::string name;
+    int frames = 0;
+    bool passed = false;
+    std::string error;          // set when the case could not run or compare at all
+    int firstDriftFrame = -1;
+    float maxPositionError = 0.0f;
+    float maxRotationError = 0.0f;
+    float maxSpeedError = 0.0f;
+    double simulationMs = 0.0;
+};
+
+static std::vector<TrajectoryFrame> simulate(const RegressionCase& regressionCase, const DriveScript& script,
+    const std::vector<std::vector<Triangle>>& gridCells, const std::vector<std::vector<Triangle>>& gridCellsCollision,
+    float gridSize, int gridCount, double& simulationMs) {
+    Car car(regressionCase.config);
+    car.setCollisionGrid(gridCells, gridCellsCollision, gridSize, gridCount, gridCount);
+    car.applyConfig(regressionCase.config);
+    car.moveToStartPosition();
+    car.resetRotation();
+    car.activate();
+
+    int frameCount = script.frameCount();
+    std::vector<TrajectoryFrame> trajectory;
+    trajectory.reserve(frameCount);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frameCount; ++frame) {
+        // same calls in the same order as a frame of the race
+        car.drive(script.inputFor(frame), REGRESSION_TIMESTEP);
+        car.updatePositionAndDirection(REGRESSION_TIMESTEP);
+        car.updateModelMatrix(REGRESSION_TIMESTEP);
+        car.update(REGRESSION_TIMESTEP);
+
+        TrajectoryFrame sample;
+        sample.position = car.getPosition();
+        sample.rotation = car.getRotation();
+        sample.speed = car.getSpeed();
+        trajectory.push_back(sample);
+    }
+    simulationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return trajectory;
+}
+
+static bool saveTrajectory(const std::string& path, const std::vector<TrajectoryFrame>& trajectory) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) return false;
+    file << "# x y z rotation speed, one frame per line at " << REGRESSION_TIMESTEP << " s\n";
+    file << std::setprecision(9);
+    for (const TrajectoryFrame& frame : trajectory) {
+        file << frame.position.x << " " << frame.position.y << " " << frame.position.z << " " << frame.rotation << " " << frame.speed << "\n";
+    }
+    return true;
+}
+
+static bool loadTrajectory(const std::string& path, std::vector<TrajectoryFrame>& trajectory) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        TrajectoryFrame frame;
+        if (!(fields >> frame.position.x >> frame.position.y >> frame.position.z >> frame.rotation >> frame.speed)) return false;
+        trajectory.push_back(frame);
+    }
+    return true;
+}
+
+static void compare(const std::vector<TrajectoryFrame>& actual, const std::vector<TrajectoryFrame>& golden,
+    const RegressionTolerance& tolerance, RegressionResult& result) {
+    if (actual.size() != golden.size()) {
+        result.error = "golden has " + std::to_string(golden.size()) + " frames, replay " + std::to_string(actual.size());
+        return;
+    }
+    for (size_t i = 0; i < actual.size(); ++i) {
+        float positionError = glm::length(actual[i].position - golden[i].position);
+        // yaw wraps around, 359.9 and 0.1 degrees are 0.2 apart
+        float rotationError = std::fabs(std::remainder(actual[i].rotation - golden[i].rotation, 360.0f));
+        float speedError = std::fabs(actual[i].speed - golden[i].speed);
+        result.maxPositionError = std::max(result.maxPositionError, positionError);
+        result.maxRotationError = std::max(result.maxRotationError, rotationError);
+        result.maxSpeedError = std::max(result.maxSpeedError, speedError);
+
+        bool drifted = positionError > tolerance.position || rotationError > tolerance.rotation || speedError > tolerance.speed;
+        if (drifted && result.firstDriftFrame < 0) {
+            result.firstDriftFrame = static_cast<int>(i);
+        }
+    }
+    result.passed = result.firstDriftFrame < 0;
+}
+
+static void writeReport(const std::string& path, bool record, const RegressionTolerance& tolerance, const std::vector<RegressionResult>& results) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        std::cout << "Failed to write regression report " << path << std::endl;
+        return;
+    }
+    file << "{\n  \"mode\": \"" << (record ? "record" : "check") << "\",\n";
+    file << "  \"tolerance\": { \"position\": " << tolerance.position << ", \"rotation\": " << tolerance.rotation
+         << ", \"speed\": " << tolerance.speed << " },\n  \"cases\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const RegressionResult& result = results[i];
+        file << "    { \"name\": \"" << result.name << "\", \"frames\": " << result.frames << ", \"passed\": "
+             << (result.passed ? "true" : "false") << ", \"error\": \"" << result.error << "\", \"firstDriftFrame\": "
+             << result.firstDriftFrame << ", \"maxPositionError\": " << result.maxPositionError << ", \"maxRotationError\": "
+             << result.maxRotationError << ", \"maxSpeedError\": " << result.maxSpeedError << ", \"simulationMs\": "
+             << result.simulationMs << ", \"usPerFrame\": " << (result.frames ? result.simulationMs * 1000.0 / result.frames : 0.0)
+             << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+}
+
+int runPhysicsRegression(const std::vector<CollisionMesh>& trackMeshes, const std::vector<CollisionMesh>& trackCollisionMeshes,
+    int gridCount, const std::vector<RegressionCase>& cases, const std::string& directory, bool record,
+    const RegressionTolerance& tolerance) {
+    if (trackMeshes.empty() || trackCollisionMeshes.empty()) {
+        std::cout << "Regression track meshes failed to load" << std::endl;
+        return 1;
+    }
+
+    float gridSize = calculateOptimalGridSize(trackMeshes, gridCount);
+    std::vector<std::vector<Triangle>> gridCells, gridCellsCollision;
+    assignTrianglesToGrid(trackMeshes, gridSize, gridCount, gridCount, gridCells);
+    assignTrianglesToGrid(trackCollisionMeshes, gridSize, gridCount, gridCount, gridCellsCollision);
+
+    std::string goldenDirectory = directory + "/golden";
+    if (record && !ensureDirectory(goldenDirectory)) {
+        std::cout << "Failed to create " << goldenDirectory << std::endl;
+        return 1;
+    }
+
+    std::vector<RegressionResult> results;
+    int failed = 0;
+    int compared = 0;
+    for (const RegressionCase& regressionCase : cases) {
+        RegressionResult result;
+        result.name = regressionCase.name;
+
+        DriveScript script;
+        if (!script.load(regressionCase.scriptPath) || script.empty()) {
+            result.error = "missing drive script " + regressionCase.scriptPath;
+        }
+        else {
+            std::vector<TrajectoryFrame> trajectory = simulate(regressionCase, script, gridCells, gridCellsCollision, gridSize,
+                gridCount, result.simulationMs);
+            result.frames = static_cast<int>(trajectory.size());
+
+            std::string goldenPath = goldenDirectory + "/" + regressionCase.name + ".traj";
+            if (record) {
+                result.passed = saveTrajectory(goldenPath, trajectory);
+                if (!result.passed) result.error = "failed to write " + goldenPath;
+            }
+            else {
+                std::vector<TrajectoryFrame> golden;
+                // a case without a golden fails, a run that compares nothing must not pass
+                if (!fileExists(goldenPath)) {
+                    result.error = "no golden " + goldenPath + ", run with --physics-regression record";
+                }
+                else if (!loadTrajectory(goldenPath, golden)) {
+                    result.error = "unreadable golden " + goldenPath;
+                }
+                else {
+                    compare(trajectory, golden, tolerance, result);
+                    if (result.error.empty()) compared++;
+                }
+            }
+        }
+
+        if (!result.passed) failed++;
+        std::cout << result.name << ": " << (result.passed ? "ok" : "FAILED") << ", " << result.frames << " frames in "
+                  << result.simulationMs << " ms";
+        if (!result.error.empty()) std::cout << ", " << result.error;
+        else if (!record) std::cout << ", max error position " << result.maxPositionError << " rotation " << result.maxRotationError
+                                    << " speed " << result.maxSpeedError;
+        if (result.firstDriftFrame >= 0) std::cout << ", drifts from frame " << result.firstDriftFrame;
+        std::cout << std::endl;
+        results.push_back(result);
+    }
+
+    writeReport(directory + "/report.json", record, tolerance, results);
+    std::cout << "Physics regression " << (record ? "recorded" : "checked") << ", " << failed << " of " << results.size() << " failed" << std::endl;
+    if (!record && compared == 0) {
+        std::cout << "Physics regression compared no case against a golden trajectory" << std::endl;
+        return 1;
+    }
+    return failed == 0 ? 0 : 1;
+}
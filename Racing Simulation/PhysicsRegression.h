@@ -0,0 +1,34 @@
+#ifndef PHYSICS_REGRESSION_H
+#define PHYSICS_REGRESSION_H
+
+#include <string>
+#include <vector>
+
+#include "Carconfig.h"
+#include "CollisionChecker.h"
+
+// how far a replay may drift from its golden trajectory on any frame
+struct RegressionTolerance {
+    float position = 1e-3f;     // world units
+    float rotation = 1e-2f;     // degrees of yaw
+    float speed = 1e-3f;
+};
+
+struct RegressionCase {
+    std::string name;           // golden file name
+    CarConfig config;
+    std::string scriptPath;
+};
+
+// Golden trajectory harness for the car physics, run with --physics-regression [record].
+// Every case replays a drive script through a fresh Car on the real track, on a fixed timestep and in the
+// order the game loop calls the car, and keeps the position, yaw and speed of every frame. Recording writes
+// those to golden files, checking compares against them and reports the first frame that drifts further than
+// the tolerance. A case without a golden fails, and so does a check that compared nothing. Each run is
+// timed too, so a faster physics path shows its gain next to whether it still drives the same. Results go
+// to stdout and report.json in the regression directory.
+int runPhysicsRegression(const std::vector<CollisionMesh>& trackMeshes, const std::vector<CollisionMesh>& trackCollisionMeshes,
+    int gridCount, const std::vector<RegressionCase>& cases, const std::string& directory, bool record,
+    const RegressionTolerance& tolerance);
+
+#endif
@@ -0,0 +1,128 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Profiler {
+
+    std::atomic<bool> enabledFlag(false);
+
+    namespace {
+        const size_t ZONES_PER_THREAD = 1 << 16;   // ~1.5 MB per thread, minutes of frames at a few dozen zones each
+
+        // written only by its thread, read by writeChromeTrace
+        struct ThreadRing {
+            std::string name;
+            unsigned int id = 0;
+            std::vector<Zone> zones;
+            std::atomic<uint64_t> written{ 0 };
+        };
+
+        std::mutex ringsMutex;
+        std::vector<std::shared_ptr<ThreadRing>> rings;   // kept after their thread exits so its zones can still be written
+
+        const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+        // created by the thread's first zone, threads that never record cost nothing
+        thread_local std::shared_ptr<ThreadRing> ring;
+        thread_local std::string threadName;
+
+        ThreadRing& threadRing() {
+            if (!ring) {
+                ring = std::make_shared<ThreadRing>();
+                ring->zones.resize(ZONES_PER_THREAD);
+                std::lock_guard<std::mutex> lock(ringsMutex);
+                ring->id = static_cast<unsigned int>(rings.size()) + 1;
+                ring->name = threadName.empty() ? "Thread " + std::to_string(ring->id) : threadName;
+                rings.push_back(ring);
+            }
+            return *ring;
+        }
+
+        void writeJsonString(std::ostream& out, const std::string& text) {
+            out << '"';
+            for (char c : text) {
+                if (c == '"' || c == '\\') out << '\\';
+                out << c;
+            }
+            out << '"';
+        }
+    }
+
+    void setEnabled(bool enabled) {
+        enabledFlag.store(enabled, std::memory_order_relaxed);
+    }
+
+    int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void record(const char* name, int64_t startNs, int64_t endNs) {
+        ThreadRing& ring = threadRing();
+        uint64_t index = ring.written.load(std::memory_order_relaxed);
+        ring.zones[index % ZONES_PER_THREAD] = { name, startNs, endNs - startNs };
+        ring.written.store(index + 1, std::memory_order_release);
+    }
+
+    void setThreadName(const std::string& name) {
+        threadName = name;
+        if (ring) {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            ring->name = name;
+        }
+    }
+
+    bool writeChromeTrace(const std::string& path) {
+        std::ofstream out(path);
+        if (!out) {
+            std::cout << "Profiler: cannot write " << path << std::endl;
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        out << "{\"traceEvents\":[\n";
+        bool first = true;
+        size_t zoneCount = 0;
+        out << std::fixed << std::setprecision(3);
+        for (const auto& ring : rings) {
+            if (!first) out << ",\n";
+            first = false;
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->id << ",\"args\":{\"name\":";
+            writeJsonString(out, ring->name);
+            out << "}}";
+
+            // copy first, the owning thread keeps recording while we read. Its next zone goes into the slot of
+            // the oldest one, which may be half overwritten already, so a full ring is read from one past it.
+            uint64_t written = ring->written.load(std::memory_order_acquire);
+            uint64_t begin = written >= ZONES_PER_THREAD ? written - ZONES_PER_THREAD + 1 : 0;
+            std::vector<Zone> zones;
+            zones.reserve(static_cast<size_t>(written - begin));
+            for (uint64_t i = begin; i < written; ++i)
+                zones.push_back(ring->zones[i % ZONES_PER_THREAD]);
+
+            // drop the oldest entries if the thread wrapped around onto them during the copy
+            uint64_t writtenAfter = ring->written.load(std::memory_order_acquire);
+            uint64_t validBegin = writtenAfter >= ZONES_PER_THREAD ? writtenAfter - ZONES_PER_THREAD + 1 : 0;
+            size_t skip = validBegin > begin ? static_cast<size_t>(std::min<uint64_t>(validBegin - begin, zones.size())) : 0;
+
+            for (size_t i = skip; i < zones.size(); ++i) {
+                const Zone& zone = zones[i];
+                out << ",\n{\"name\":";
+                writeJsonString(out, zone.name);
+                out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->id
+                    << ",\"ts\":" << zone.startNs / 1000.0 << ",\"dur\":" << zone.durationNs / 1000.0 << "}";
+                ++zoneCount;
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+        std::cout << "Profiler: wrote " << zoneCount << " zones to " << path << std::endl;
+        return static_cast<bool>(out);
+    }
+}
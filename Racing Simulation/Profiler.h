@@ -0,0 +1,67 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Scoped timing zones, written as Chrome trace JSON (chrome://tracing or ui.perfetto.dev).
+//
+//     void renderScene(Shader& shader) {
+//         PROFILE_ZONE("renderScene");
+//         ...
+//     }
+//
+// Each thread records into its own fixed size ring, so a zone costs two clock reads and no locking.
+// Recording is off until Profiler::setEnabled(true); a disabled zone only tests a flag.
+// Define DISABLE_PROFILER to compile the zones out entirely.
+namespace Profiler {
+
+    struct Zone {
+        const char* name;   // must outlive the profiler, string literals only
+        int64_t startNs;
+        int64_t durationNs;
+    };
+
+    extern std::atomic<bool> enabledFlag;
+
+    inline bool isEnabled() {
+        return enabledFlag.load(std::memory_order_relaxed);
+    }
+    void setEnabled(bool enabled);
+
+    int64_t nowNs();
+    void record(const char* name, int64_t startNs, int64_t endNs);
+
+    // shows up as the track name in the trace, call once at the start of each thread
+    void setThreadName(const std::string& name);
+
+    // writes every zone still held in the rings, returns false if the file could not be written
+    bool writeChromeTrace(const std::string& path);
+
+    class ScopedZone {
+    public:
+        explicit ScopedZone(const char* name) : name(name), startNs(isEnabled() ? nowNs() : -1) {}
+        ~ScopedZone() {
+            if (startNs >= 0) record(name, startNs, nowNs());
+        }
+
+        ScopedZone(const ScopedZone&) = delete;
+        ScopedZone& operator=(const ScopedZone&) = delete;
+
+    private:
+        const char* name;
+        int64_t startNs;
+    };
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef DISABLE_PROFILER
+#define PROFILE_ZONE(name)
+#else
+#define PROFILE_ZONE(name) Profiler::ScopedZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#endif
+
+#endif
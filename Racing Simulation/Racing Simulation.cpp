@@ -6,11 +6,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include <ft2build.h>
-#include FT_FREETYPE_H
-
 #include "shader_m.h"
 #include "Skybox.h"
+#include "SkyboxSelector.h"
 #include "camera.h"
 #include "model.h"
 #include "irrKlang/irrKlang.h"
@@ -18,7 +16,34 @@
 #include "Car.h" 
 #include "Carconfig.h"
 #include "SoundManager.h"
+#include "EngineAudio.h"
+#include "TextRenderer.h"
+#include "PerfHud.h"
+#include "FramePacer.h"
+#include "CollisionOverlay.h"
+#include "CollisionStats.h"
 #include "Timer.h"
+#include "IBLCache.h"
+#include "CascadedShadowMap.h"
+#include "TrackGrid.h"
+#include "MemoryAccounting.h"
+#include "AssetLoader.h"
+#include "TextureStreamer.h"
+#include "TextureCooker.h"
+#include "TextureRegistry.h"
+#include "ResidencyManager.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "Benchmarks.h"
+#include "RenderBenchmark.h"
+#include "PhysicsRegression.h"
+#include "TelemetryRecorder.h"
+#include "TelemetryReader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
 
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -28,21 +53,30 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 void cursor_position_callback(GLFWwindow* window, double xpos, double ypos);
 
 void renderScene(Shader& shader);
+void renderTrack(Shader& shader);
+void renderCars(Shader& shader);
+void renderCar(Shader& shader, const Car& car, Model& body, Model& wheel);
+bool isCarVisible(const Car& car);
+void renderShadows(CascadedShadowMap& shadowMap, Shader& shadowShader, float aspect);
 void processInput(GLFWwindow* window);
 
-void handleCarSound(SoundManager& soundManager, const Car& car);
+void handleCarSound(EngineAudio& engineAudio, int emitter, const Car& car);
 
-float calculateOptimalGridSize(const Model& trackModel, int desiredGridCount);
-void assignTrianglesToGrid(const Model& trackModel, float gridSize, int gridWidth, int gridHeight, std::vector<std::vector<Triangle>>& gridCells);
-void checkTrackSize(const Model& trackModel);
 void renderCube();
 void renderQuad();
 
 void renderUIQuad();
-unsigned int loadTexture(const char* path);
+unsigned int loadTexture(const char* path, AssetLoader& assetLoader, TextureStreamer& textureStreamer);
+
+bool bakeIBL(const std::string& hdrPath, IBLMaps& maps, Shader& equirectangularToCubemapShader, Shader& irradianceShader, Shader& prefilterShader, Shader& brdfShader);
+void loadEnvironment(const std::string& hdrPath, IBLMaps& maps, Shader& equirectangularToCubemapShader, Shader& irradianceShader, Shader& prefilterShader, Shader& brdfShader);
+
+int cookTextures();
+int benchmarkPhysics(const std::string& outputPath);
+int physicsRegression(bool record, const RegressionTolerance& tolerance);
+void setupCarConfigs();
+bool parseNumberArgument(const std::string& option, const char* text, double& value);
 
-void initTextRendering(const std::string& fontPath);
-void RenderText(Shader& shader, std::string text, float x, float y, float scale, glm::vec3 color);
 
 
 
@@ -58,8 +92,7 @@ float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 
 // timing
-float deltaTime = 0.0f;	// time between current frame and last frame
-float lastFrame = 0.0f;
+float deltaTime = 0.0f;	// simulation step of this frame, see FramePacer
 
 glm::vec3 rayOrigin;
 glm::vec3 rayDirection = glm::vec3(0.0f, -1.0f, 0.0f);
@@ -85,6 +118,12 @@ Model* car2Model;
 Model* wheel2Model;
 
 SoundManager soundManager;
+SoundId accelerateSound = INVALID_SOUND;
+// positional engine sound heard from the camera, only the loudest cars get one of the voices
+const int ENGINE_AUDIO_VOICES = 8;
+EngineAudio* engineAudio;
+int chevEngineEmitter;
+int cadillacEngineEmitter;
 
 bool gameStarted = false;
 glm::vec3 minBounds(-3.0f, -2.0f, -2.0f);
@@ -92,6 +131,109 @@ glm::vec3 maxBounds(3.0f, 2.0f, 2.0f);
 
 Timer timer(minBounds, maxBounds);
 
+// frame statistics overlay, toggled with [F3]
+PerfHud perfHud;
+// vsync, frame cap and the simulation step, the mode is cycled with [F6]
+FramePacer framePacer;
+// collision grid heat map and query counters, cycled with [F4]
+CollisionOverlay collisionOverlay;
+
+// image based lighting, cycled with [E] on the car selection screen
+const std::vector<std::string> environmentPaths = {
+    "Textures/newport_loft.hdr",
+    "Textures/sky.hdr",
+    "Textures/track_hdr.hdr"
+};
+int currentEnvironment = 0;
+bool environmentChangeRequested = false;
+IBLMaps environmentMaps;
+IBLCache iblCache("Cache");
+
+// sun shadows
+const unsigned int SHADOW_RESOLUTION = 1024;
+const unsigned int SHADOW_TEXTURE_UNIT = 8;    // units 0-2 are IBL, 3-7 the material maps
+const float CAR_SHADOW_RADIUS = 3.5f;          // bounding sphere of a car and its wheels
+glm::vec3 sunDirection = glm::vec3(-0.45f, -1.0f, -0.35f);
+float shadowStrength = 0.6f;
+
+// models loaded at startup, --cook-textures walks the same list
+const char* const TRACK_MODEL_PATH = "Objects/racetrack/track.obj";
+const char* const TRACK_COLLISION_MODEL_PATH = "Objects/racetrack/trackCol.obj";
+const char* const TRACK_VISUAL_MODEL_PATH = "Objects/racetrack/track3.obj";
+const char* const CHEV_BODY_MODEL_PATH = "Objects/chev-nascar/body.obj";
+const char* const CHEV_WHEEL_MODEL_PATH = "Objects/chev-nascar/wheel1.obj";
+const char* const CADILLAC_BODY_MODEL_PATH = "Objects/pbrCar/CarBody2.obj";
+const char* const CADILLAC_WHEEL_MODEL_PATH = "Objects/pbrCar/carwheel.obj";
+
+// skyboxes cycled with [K], the first one is shown at startup
+static std::vector<SkyboxEnvironment> makeSkyboxEnvironments() {
+    std::vector<SkyboxEnvironment> environments = {
+        { "Sunset", {
+            "Textures/skybox/sunset/px.jpg",
+            "Textures/skybox/sunset/nx.jpg",
+            "Textures/skybox/sunset/py.jpg",
+            "Textures/skybox/sunset/ny.jpg",
+            "Textures/skybox/sunset/pz.jpg",
+            "Textures/skybox/sunset/nz.jpg"
+        } }
+    };
+    const char* urbanSkyboxes[] = {
+        "CNTower", "ForbiddenCity", "GamlaStan", "GamlaStan2", "Medborgarplatsen", "Parliament", "Roundabout",
+        "SaintLazarusChurch", "SaintLazarusChurch2", "SaintLazarusChurch3", "Sodermalmsallen", "Sodermalmsallen2", "UnionSquare"
+    };
+    for (const char* name : urbanSkyboxes) {
+        std::string directory = std::string("Textures/skybox/urban-skyboxes/") + name + "/";
+        environments.push_back({ name, {
+            directory + "posx.jpg", directory + "negx.jpg",
+            directory + "posy.jpg", directory + "negy.jpg",
+            directory + "posz.jpg", directory + "negz.jpg"
+        } });
+    }
+    return environments;
+}
+const std::vector<SkyboxEnvironment> skyboxEnvironments = makeSkyboxEnvironments();
+bool skyboxChangeRequested = false;
+
+// asset streaming
+const double ASSET_UPLOAD_BUDGET_MS = 4.0;     // main thread time per frame spent on GL uploads
+bool assetsReady = false;                      // models uploaded and the collision grid built
+const size_t TEXTURE_STREAM_BYTES_PER_FRAME = 8 * 1024 * 1024;  // texels copied into upload buffers per frame
+
+// memory the models may keep loaded, unused ones are evicted past these. About what the track and one car
+// need, so the car left on the selection screen and the track source meshes go once the race is on.
+// --model-budget <cpu MB> <gpu MB> overrides them.
+const size_t MODEL_CPU_BUDGET = 32 * 1024 * 1024;
+const size_t MODEL_GPU_BUDGET = 64 * 1024 * 1024;
+
+// profiling, recorded from startup with --profile or toggled with [F8], [F9] writes the trace
+const char* const PROFILE_TRACE_PATH = "profile_trace.json";
+
+// --benchmark-physics [path], fixed seed so runs on one machine can be compared
+const char* const PHYSICS_BENCHMARK_PATH = "physics_benchmarks.json";
+const unsigned int PHYSICS_BENCHMARK_SEED = 1337;
+
+// --benchmark-render [path], a scripted lap in a hidden window, null when playing
+const char* const RENDER_BENCHMARK_PATH = "render_benchmark.json";
+const int RENDER_BENCHMARK_WARMUP_FRAMES = 120;
+const int RENDER_BENCHMARK_FRAMES = 2000;
+const float RENDER_BENCHMARK_TIMESTEP = 1.0f / 60.0f;
+RenderBenchmark* renderBenchmark = nullptr;
+std::string renderBenchmarkPath;
+
+// --physics-regression [record], every car drives every script and is compared with its golden trajectory
+const char* const REGRESSION_DIRECTORY = "Regression";
+const std::vector<std::string> regressionScripts = { "lap", "launch_and_brake", "slalom" };
+// [F7] starts and stops recording the driving keys into a new script
+const char* const RECORDED_DRIVE_PATH = "Regression/scripts/recorded.txt";
+DriveScript recordedDrive;
+bool driveRecording = false;
+
+// --record-telemetry [path] keeps the state of the driven car every tick of the race,
+// --telemetry-query <path> [--where <column> <min> <max>]... summarises a recording
+const char* const TELEMETRY_PATH = "telemetry.rstl";
+TelemetryRecorder telemetry;
+uint32_t telemetryTick = 0;
+
 
 glm::vec3 lightPositions[4] = {
 glm::vec3(10.0f, 5.0f, 10.0f),
@@ -107,21 +249,84 @@ glm::vec3 lightColors[4] = {
     glm::vec3(500.0f, 500.0f, 500.0f)
 };
 
-// Character struct similar to your existing setup
-struct Character {
-    unsigned int TextureID;
-    glm::ivec2 Size;
-    glm::ivec2 Bearing; 
-    unsigned int Advance;
-};
-
-std::map<GLchar, Character> Characters;
-unsigned int textVAO, textVBO;
 
 
 
-int main()
+int main(int argc, char** argv)
 {
+    PacingMode pacingMode = PacingMode::VSync;
+    size_t modelCpuBudget = MODEL_CPU_BUDGET, modelGpuBudget = MODEL_GPU_BUDGET;
+    // offline steps: cook the textures of every model and the skybox into Cache/, or time the physics, and exit
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--cook-textures") {
+            return cookTextures();
+        }
+        if (std::string(argv[i]) == "--benchmark-physics") {
+            bool hasPath = i + 1 < argc && argv[i + 1][0] != '-';
+            return benchmarkPhysics(hasPath ? argv[i + 1] : PHYSICS_BENCHMARK_PATH);
+        }
+        if (std::string(argv[i]) == "--physics-regression") {
+            bool record = i + 1 < argc && std::string(argv[i + 1]) == "record";
+            // --tolerance-position/-rotation/-speed <value> after the mode override the defaults
+            RegressionTolerance tolerance;
+            for (int j = i + 1; j + 1 < argc; ++j) {
+                std::string option = argv[j];
+                float* target = option == "--tolerance-position" ? &tolerance.position
+                    : option == "--tolerance-rotation" ? &tolerance.rotation
+                    : option == "--tolerance-speed" ? &tolerance.speed : nullptr;
+                if (!target) continue;
+                double value;
+                if (!parseNumberArgument(option, argv[j + 1], value)) return 1;
+                *target = static_cast<float>(value);
+            }
+            return physicsRegression(record, tolerance);
+        }
+        if (std::string(argv[i]) == "--telemetry-query" && i + 1 < argc) {
+            std::vector<TelemetryFilter> filters;
+            for (int j = i + 2; j + 3 < argc && std::string(argv[j]) == "--where"; j += 4) {
+                int column = telemetryColumnFromName(argv[j + 1]);
+                if (column < 0) {
+                    std::cout << "Unknown telemetry column " << argv[j + 1] << std::endl;
+                    return 1;
+                }
+                double minimum, maximum;
+                if (!parseNumberArgument("--where", argv[j + 2], minimum) || !parseNumberArgument("--where", argv[j + 3], maximum)) return 1;
+                filters.push_back({ column, minimum, maximum });
+            }
+            return runTelemetryQuery(argv[i + 1], filters);
+        }
+        if (std::string(argv[i]) == "--record-telemetry") {
+            bool hasPath = i + 1 < argc && argv[i + 1][0] != '-';
+            telemetry.start(hasPath ? argv[++i] : TELEMETRY_PATH);
+        }
+        if (std::string(argv[i]) == "--benchmark-render") {
+            bool hasPath = i + 1 < argc && argv[i + 1][0] != '-';
+            renderBenchmarkPath = hasPath ? argv[++i] : RENDER_BENCHMARK_PATH;
+            renderBenchmark = new RenderBenchmark(RENDER_BENCHMARK_WARMUP_FRAMES, RENDER_BENCHMARK_FRAMES);
+        }
+        if (std::string(argv[i]) == "--profile") {
+            Profiler::setEnabled(true);
+        }
+        if (std::string(argv[i]) == "--model-budget" && i + 2 < argc) {
+            double cpuMegabytes, gpuMegabytes;
+            if (!parseNumberArgument("--model-budget", argv[i + 1], cpuMegabytes) ||
+                !parseNumberArgument("--model-budget", argv[i + 2], gpuMegabytes)) return 1;
+            modelCpuBudget = static_cast<size_t>(std::max(0.0, cpuMegabytes) * 1024.0 * 1024.0);
+            modelGpuBudget = static_cast<size_t>(std::max(0.0, gpuMegabytes) * 1024.0 * 1024.0);
+            i += 2;
+        }
+        if (std::string(argv[i]) == "--target-fps" && i + 1 < argc) {
+            double fps;
+            if (!parseNumberArgument("--target-fps", argv[++i], fps)) return 1;
+            if (fps <= 0.0) {
+                std::cout << "--target-fps needs a rate above 0, got " << argv[i] << std::endl;
+                return 1;
+            }
+            pacingMode = PacingMode::Capped;
+            framePacer.setTargetFps(fps);
+        }
+    }
+    Profiler::setThreadName("Main");
 
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -132,6 +337,10 @@ int main()
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+    // the benchmark renders offscreen, a hidden window still gets a default framebuffer
+    if (renderBenchmark) {
+        glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    }
 
     // glfw window creation
     // --------------------
@@ -144,6 +353,8 @@ int main()
     }
 
     glfwMakeContextCurrent(window);
+    // the benchmark measures how fast frames can go, nothing may hold them back
+    framePacer.setMode(renderBenchmark ? PacingMode::Unlimited : pacingMode);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetCursorPosCallback(window, cursor_position_callback);
@@ -174,27 +385,22 @@ int main()
 
     // build and compile our shader zprogram
     // ------------------------------------
-    Shader ourShader("Shaders/model/model_loading.vs", "Shaders/model/model_loading.fs");
-    Shader pbrShader("Shaders/PBR/pbr.vs", "Shaders/PBR/pbr.fs");
-    Shader equirectangularToCubemapShader("Shaders/PBR/cubemap.vs", "Shaders/PBR/equirectangular_to_cubemap.fs");
-    Shader irradianceShader("Shaders/PBR/cubemap.vs", "Shaders/PBR/irradiance_convolution.fs");
-    Shader prefilterShader("Shaders/PBR/cubemap.vs", "Shaders/PBR/prefilter.fs");
-    Shader brdfShader("Shaders/PBR/brdf.vs", "Shaders/PBR/brdf.fs");
-    Shader backgroundShader("Shaders/PBR/background.vs", "Shaders/PBR/background.fs");
-    Shader uiShader("Shaders/UIShader.vs", "Shaders/UIShader.fs");
-    Shader textShader("Shaders/text.vs", "Shaders/text.fs");
+    // every compile is started before any status is checked, later launches link from the driver binaries
+    ShaderCache shaderCache("Cache");
+    Shader ourShader("Shaders/model/model_loading.vs", "Shaders/model/model_loading.fs", shaderCache);
+    Shader pbrShader("Shaders/PBR/pbr.vs", "Shaders/PBR/pbr.fs", shaderCache);
+    Shader equirectangularToCubemapShader("Shaders/PBR/cubemap.vs", "Shaders/PBR/equirectangular_to_cubemap.fs", shaderCache);
+    Shader irradianceShader("Shaders/PBR/cubemap.vs", "Shaders/PBR/irradiance_convolution.fs", shaderCache);
+    Shader prefilterShader("Shaders/PBR/cubemap.vs", "Shaders/PBR/prefilter.fs", shaderCache);
+    Shader brdfShader("Shaders/PBR/brdf.vs", "Shaders/PBR/brdf.fs", shaderCache);
+    Shader backgroundShader("Shaders/PBR/background.vs", "Shaders/PBR/background.fs", shaderCache);
+    Shader uiShader("Shaders/UIShader.vs", "Shaders/UIShader.fs", shaderCache);
+    Shader textShader("Shaders/text.vs", "Shaders/text.fs", shaderCache);
+    Shader shadowShader("Shaders/shadow/shadow_dept.vs", "Shaders/shadow/shadow_dept.fs", shaderCache);
+    Shader skyboxShader("Shaders/skybox/skybox.vs", "Shaders/skybox/skybox.fs", shaderCache);
 
     // load models
     // -----------
-    Shader skyboxShader("Shaders/skybox/skybox.vs", "Shaders/skybox/skybox.fs");
-    std::vector<std::string> faces = {
-    "Textures/skybox/sunset/px.jpg",
-    "Textures/skybox/sunset/nx.jpg",
-    "Textures/skybox/sunset/py.jpg",
-    "Textures/skybox/sunset/ny.jpg",
-    "Textures/skybox/sunset/pz.jpg",
-    "Textures/skybox/sunset/nz.jpg"
-    };
 
     /*Shader skyboxShader("Shaders/skybox/skybox.vs", "Shaders/skybox/skybox.fs");
     std::vector<std::string> faces = {
@@ -206,24 +412,60 @@ int main()
     "Textures/sunset/nz.png"
     };*/
 
-    Skybox skybox(faces, skyboxShader.getID());
-    Model trackModel("Objects/racetrack/track.obj");
-    Model trackCollisionModel("Objects/racetrack/trackCol.obj");
-
-
-    trackVisual = new Model("Objects/racetrack/track3.obj");
-    carModel = new Model("Objects/chev-nascar/body.obj");
-    wheelModel = new Model("Objects/chev-nascar/wheel1.obj");
-    car2Model = new Model("Objects/pbrCar/CarBody2.obj");
-    wheel2Model = new Model("Objects/pbrCar/carwheel.obj");
+    SkyboxSelector skyboxes(skyboxEnvironments, skyboxShader.getID());
+    // the two collision tracks are never drawn, the drawn models are never queried on the CPU
+    Model trackModel(ModelLoadMode::CollisionOnly);
+    Model trackCollisionModel(ModelLoadMode::CollisionOnly);
+
+
+    trackVisual = new Model(ModelLoadMode::RenderOnly);
+    carModel = new Model(ModelLoadMode::RenderOnly);
+    wheelModel = new Model(ModelLoadMode::RenderOnly);
+    car2Model = new Model(ModelLoadMode::RenderOnly);
+    wheel2Model = new Model(ModelLoadMode::RenderOnly);
+
+    // everything is read and decoded on worker threads, the GL uploads are spread over the first frames
+    AssetLoader assetLoader;
+    TextureStreamer textureStreamer;
+    TextureRegistry::get().setTextureStreamer(&textureStreamer);
+    auto loadModelAsync = [&assetLoader, &textureStreamer](Model& model, const std::string& path) {
+        model.setTextureStreamer(&textureStreamer);
+        assetLoader.enqueue(path, [&model, path] { model.loadModel(path); }, [&model] { return model.uploadStep(); });
+    };
+    skyboxes.start(assetLoader);
+
+    // models are loaded through the residency manager, which unloads the ones nothing holds when over budget
+    ResidencyManager residency(modelCpuBudget, modelGpuBudget);
+    perfHud.setResidencyManager(&residency);
+    auto registerModel = [&residency, &loadModelAsync](Model& model, const std::string& path) {
+        ResidentAssetCallbacks callbacks;
+        callbacks.load = [&loadModelAsync, &model, path] { loadModelAsync(model, path); };
+        callbacks.isLoaded = [&model] { return model.isReady(); };
+        callbacks.unload = [&model] { model.unload(); };
+        callbacks.memoryUsage = [&model](size_t& cpuBytes, size_t& gpuBytes) { model.memoryUsage(cpuBytes, gpuBytes); };
+        residency.registerAsset(path, callbacks);
+        residency.acquire(path);
+    };
+    registerModel(trackModel, TRACK_MODEL_PATH);
+    registerModel(trackCollisionModel, TRACK_COLLISION_MODEL_PATH);
+    registerModel(*trackVisual, TRACK_VISUAL_MODEL_PATH);
+    registerModel(*carModel, CHEV_BODY_MODEL_PATH);
+    registerModel(*wheelModel, CHEV_WHEEL_MODEL_PATH);
+    registerModel(*car2Model, CADILLAC_BODY_MODEL_PATH);
+    registerModel(*wheel2Model, CADILLAC_WHEEL_MODEL_PATH);
+    bool unusedCarReleased = false;
+    bool collisionGridQueued = false;
     //Model carModel("Objects/jeep/car.obj");
     //Model wheelModel("Objects/jeep/wheel.obj");
     //Model carModel("Objects/chev-nascar/body.obj");
     //Model wheelModel("Objects/chev-nascar/wheel1.obj");
 
-    unsigned int uiTexture = loadTexture("Textures/UI/square.png");
+    unsigned int uiTexture = loadTexture("Textures/UI/square.png", assetLoader, textureStreamer);
     glm::mat4 uiProjection = glm::ortho(0.0f, static_cast<float>(SCR_WIDTH), 0.0f, static_cast<float>(SCR_HEIGHT));
 
+    // the asset workers are busy by now, wait for the shaders only before the first program is used
+    shaderCache.finishPending();
+
     uiShader.use();
     uiShader.setMat4("projection", uiProjection);
     uiShader.setInt("uiTexture", 0);
@@ -241,354 +483,210 @@ int main()
     pbrShader.setInt("metallicMap", 5);
     pbrShader.setInt("roughnessMap", 6);
     pbrShader.setInt("aoMap", 7);
+    pbrShader.setFloat("shadowStrength", shadowStrength);
+
+    CascadedShadowMap shadowMap(SHADOW_RESOLUTION, sunDirection);
 
     backgroundShader.use();
     backgroundShader.setInt("environmentMap", 0);
 
     initTextRendering("Textures/Fonts/digital-7.ttf");
+    perfHud.init();
+    perfHud.setFramePacer(&framePacer);
+    perfHud.setTimingEnabled(renderBenchmark != nullptr);
     glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(SCR_WIDTH), 0.0f, static_cast<float>(SCR_HEIGHT));
     textShader.use();
     glUniformMatrix4fv(glGetUniformLocation(textShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
 
-    // pbr: setup framebuffer
-   // ----------------------
-    unsigned int captureFBO;
-    unsigned int captureRBO;
-    glGenFramebuffers(1, &captureFBO);
-    glGenRenderbuffers(1, &captureRBO);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
-
-    // pbr: load the HDR environment map
-    // ---------------------------------
-    stbi_set_flip_vertically_on_load(true);
-    int width, height, nrComponents;
-    float* data = stbi_loadf("Textures/newport_loft.hdr", &width, &height, &nrComponents, 0);
-    unsigned int hdrTexture;
-    if (data)
-    {
-        glGenTextures(1, &hdrTexture);
-        glBindTexture(GL_TEXTURE_2D, hdrTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data); // note how we specify the texture's data value to be float
+    // pbr: load the precomputed IBL maps for the HDR environment (baked on first launch)
+    // -----------------------------------------------------------------------------------
+    loadEnvironment(environmentPaths[currentEnvironment], environmentMaps, equirectangularToCubemapShader, irradianceShader, prefilterShader, brdfShader);
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-        std::cout << "HDR Loaded: Width = " << width << ", Height = " << height << ", Components = " << nrComponents << std::endl;
+    setupCarConfigs();
+    chev.applyConfig(chevConfig);
+    cadillac.applyConfig(cadillacConfig);
+   
+    selectedCar = &chev;
+    camera.LookAtCar(chev.getPosition() - glm::vec3(0, 1.8f, 0));
 
-        stbi_image_free(data);
+    chev.startSelectionRotation();
+    cadillac.startSelectionRotation();
+  
 
-    }
-    else
-    {
-        std::cout << "Failed to load HDR image." << std::endl;
-    }
+    // effects arrive through the asset loader, the music streams from disk instead of sitting in memory
+    accelerateSound = soundManager.preloadSoundAsync("accelerate", "Sounds/accelerate_sound2.wav", assetLoader);
+    engineAudio = new EngineAudio(soundManager, accelerateSound, ENGINE_AUDIO_VOICES);
+    chevEngineEmitter = engineAudio->addEmitter();
+    cadillacEngineEmitter = engineAudio->addEmitter();
+    soundManager.preloadSound("music", "Sounds/Plasma.wav", SoundLoad::Stream);
+    soundManager.playSound("music", true);
+	soundManager.setVolume("music", 0.5f);
 
-    // pbr: setup cubemap to render to and attach to framebuffer
-    // ---------------------------------------------------------
-    unsigned int envCubemap;
-    glGenTextures(1, &envCubemap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-    for (unsigned int i = 0; i < 6; ++i)
-    {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 512, 512, 0, GL_RGB, GL_FLOAT, nullptr);
+    pbrShader.use();
+    for (int i = 0; i < 4; ++i) {
+        pbrShader.setVec3("lightPositions[" + std::to_string(i) + "]", lightPositions[i]);
+        pbrShader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // enable pre-filter mipmap sampling (combatting visible dots artifact)
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // pbr: set up projection and view matrices for capturing data onto the 6 cubemap face directions
-    // ----------------------------------------------------------------------------------------------
-    glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-    glm::mat4 captureViews[] =
-    {
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
 
-    };
 
-    // pbr: convert HDR equirectangular environment map to cubemap equivalent
-    // ----------------------------------------------------------------------
-    equirectangularToCubemapShader.use();
-    equirectangularToCubemapShader.setInt("equirectangularMap", 0);
-    equirectangularToCubemapShader.setMat4("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, hdrTexture);
+    int scrWidth, scrHeight;
+    glfwGetFramebufferSize(window, &scrWidth, &scrHeight);
+    glViewport(0, 0, scrWidth, scrHeight);
 
-    glViewport(0, 0, 512, 512); // don't forget to configure the viewport to the capture dimensions.
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    for (unsigned int i = 0; i < 6; ++i)
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
     {
-        equirectangularToCubemapShader.setMat4("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        renderCube();
+        PROFILE_ZONE("Frame");
+        perfHud.beginFrame();
+        if (renderBenchmark && gameStarted) {
+            renderBenchmark->recordFrame(perfHud);
+            if (renderBenchmark->isFinished()) {
+                renderBenchmark->writeReport(renderBenchmarkPath);
+                glfwSetWindowShouldClose(window, true);
+            }
+        }
 
-    }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // per-frame time logic
+        // --------------------
 
-    // then let OpenGL generate mipmaps from first mip face (combatting visible dots artifact)
-    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+        deltaTime = framePacer.beginFrame();
+        // a fixed step keeps the scripted lap on the same path however long the frames take
+        if (renderBenchmark) {
+            deltaTime = RENDER_BENCHMARK_TIMESTEP;
+        }
 
-    // pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
-    // --------------------------------------------------------------------------------
-    unsigned int irradianceMap;
-    glGenTextures(1, &irradianceMap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
-    for (unsigned int i = 0; i < 6; ++i)
-    {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 32, 32, 0, GL_RGB, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // input
+        // -----
+        auto simulationStart = std::chrono::steady_clock::now();
+        processInput(window);
+        perfHud.addSimulationTime(PerfHud::millisecondsSince(simulationStart));
 
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 32, 32);
+        assetLoader.processUploads(ASSET_UPLOAD_BUDGET_MS);
+        textureStreamer.update(TEXTURE_STREAM_BYTES_PER_FRAME);
+        if (skyboxChangeRequested) {
+            skyboxChangeRequested = false;
+            skyboxes.next();
+        }
+        skyboxes.update(assetLoader);
+        // the collision grid needs the CPU side triangles of both track models, build it once they are in
+        if (!collisionGridQueued && trackModel.isReady() && trackCollisionModel.isReady()) {
+            collisionGridQueued = true;
+            assetLoader.enqueue("collision grid", [&trackModel, &trackCollisionModel] {
+                gridSize = calculateOptimalGridSize(trackModel.collisionMeshes, gridHeight);
+                assignTrianglesToGrid(trackModel.collisionMeshes, gridSize, gridWidth, gridHeight, gridCells);
+                assignTrianglesToGrid(trackCollisionModel.collisionMeshes, gridSize, gridWidth, gridHeight, gridCellsCollision);
+                std::cout << "Collision grid, track: " << describeGridOccupancy(gridCells) << std::endl;
+                std::cout << "Collision grid, walls: " << describeGridOccupancy(gridCellsCollision) << std::endl;
+                MemoryAccounting::get().set(&gridCells, MemoryCategory::CollisionGrid, "track grid", gridMemoryBytes(gridCells), 0);
+                MemoryAccounting::get().set(&gridCellsCollision, MemoryCategory::CollisionGrid, "wall grid", gridMemoryBytes(gridCellsCollision), 0);
+            }, [&residency] {
+                chev.setCollisionGrid(gridCells, gridCellsCollision, gridSize, gridWidth, gridHeight);
+                cadillac.setCollisionGrid(gridCells, gridCellsCollision, gridSize, gridWidth, gridHeight);
+                // the grid holds its own copy of the triangles, the track meshes may go when memory is short
+                residency.release(TRACK_MODEL_PATH);
+                residency.release(TRACK_COLLISION_MODEL_PATH);
+                return true;
+            });
+        }
+        if (!assetsReady && collisionGridQueued && assetLoader.isIdle()) {
+            assetsReady = true;
+        }
 
-    // pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
-    // -----------------------------------------------------------------------------
-    irradianceShader.use();
-    irradianceShader.setInt("environmentMap", 0);
-    irradianceShader.setMat4("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+        // the car left on the selection screen is never drawn again once the race is on
+        if (gameStarted && !unusedCarReleased) {
+            unusedCarReleased = true;
+            bool chevChosen = selectedCar == &chev;
+            residency.release(chevChosen ? CADILLAC_BODY_MODEL_PATH : CHEV_BODY_MODEL_PATH);
+            residency.release(chevChosen ? CADILLAC_WHEEL_MODEL_PATH : CHEV_WHEEL_MODEL_PATH);
+        }
+        // what this frame draws counts as used, eviction goes by the last frame an asset was drawn
+        residency.touch(TRACK_VISUAL_MODEL_PATH);
+        if (isCarVisible(chev)) {
+            residency.touch(CHEV_BODY_MODEL_PATH);
+            residency.touch(CHEV_WHEEL_MODEL_PATH);
+        }
+        if (isCarVisible(cadillac)) {
+            residency.touch(CADILLAC_BODY_MODEL_PATH);
+            residency.touch(CADILLAC_WHEEL_MODEL_PATH);
+        }
+        residency.update();
+
+        if (environmentChangeRequested) {
+            environmentChangeRequested = false;
+            currentEnvironment = (currentEnvironment + 1) % static_cast<int>(environmentPaths.size());
+            perfHud.beginPass(GpuPass::IBL);
+            loadEnvironment(environmentPaths[currentEnvironment], environmentMaps, equirectangularToCubemapShader, irradianceShader, prefilterShader, brdfShader);
+            perfHud.endPass(GpuPass::IBL);
+            glfwGetFramebufferSize(window, &scrWidth, &scrHeight);
+            glViewport(0, 0, scrWidth, scrHeight);
+        }
+       
+        camera.FollowCar(selectedCar->getPosition(), selectedCar->getDirection(), selectedCar->getSpeed(), selectedCar->getMaxSpeed(), selectedCar->getSteeringAngle(), deltaTime);
+        camera.CarPosition = selectedCar->getPosition();
+        camera.Update(deltaTime);
+        // render
+        // ------
+        perfHud.beginPass(GpuPass::Shadows);
+        renderShadows(shadowMap, shadowShader, (float)SCR_WIDTH / (float)SCR_HEIGHT);
+        perfHud.endPass(GpuPass::Shadows);
 
-    glViewport(0, 0, 32, 32); // don't forget to configure the viewport to the capture dimensions.
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    for (unsigned int i = 0; i < 6; ++i)
-    {
-        irradianceShader.setMat4("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        renderCube();
+        
+        pbrShader.use();
 
-    }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // view/projection transformations
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, near_plane, far_plane);
+        glm::mat4 view = camera.GetViewMatrix();
+        pbrShader.setMat4("projection", projection);
+        pbrShader.setMat4("view", view);
+        pbrShader.setVec3("camPos", camera.Position);
 
-    // pbr: create a pre-filter cubemap, and re-scale capture FBO to pre-filter scale.
-    // --------------------------------------------------------------------------------
-    unsigned int prefilterMap;
-    glGenTextures(1, &prefilterMap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
-    for (unsigned int i = 0; i < 6; ++i)
-    {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 128, 128, 0, GL_RGB, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // be sure to set minification filter to mip_linear 
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // generate mipmaps for the cubemap so OpenGL automatically allocates the required memory.
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+        //track
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, environmentMaps.irradianceMap);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, environmentMaps.prefilterMap);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, environmentMaps.brdfLUTTexture);
+        shadowMap.bindForSampling(pbrShader, SHADOW_TEXTURE_UNIT);
 
-    // pbr: run a quasi monte-carlo simulation on the environment lighting to create a prefilter (cube)map.
-    // ----------------------------------------------------------------------------------------------------
-    prefilterShader.use();
-    prefilterShader.setInt("environmentMap", 0);
-    prefilterShader.setMat4("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    unsigned int maxMipLevels = 5;
-    for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
-    {
-        // reisze framebuffer according to mip-level size.
-        unsigned int mipWidth = static_cast<unsigned int>(128 * std::pow(0.5, mip));
-        unsigned int mipHeight = static_cast<unsigned int>(128 * std::pow(0.5, mip));
-        glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
-        glViewport(0, 0, mipWidth, mipHeight);
+        renderScene(pbrShader);
 
-        float roughness = (float)mip / (float)(maxMipLevels - 1);
-        prefilterShader.setFloat("roughness", roughness);
-        for (unsigned int i = 0; i < 6; ++i)
-        {
-            prefilterShader.setMat4("view", captureViews[i]);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilterMap, mip);
+        //Update car position and direction
+        simulationStart = std::chrono::steady_clock::now();
+        // the cars query the collision grid, which is only installed once loading has finished
+        if (assetsReady) {
+            selectedCar->updatePositionAndDirection(deltaTime);
+            selectedCar->updateModelMatrix(deltaTime);  // Update the car and wheel transformations
 
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            renderCube();
-        }
-    }
+            if (!gameStarted) {
+                chev.update(deltaTime);
+                cadillac.update(deltaTime);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            }
+            else {
+                selectedCar->update(deltaTime); // Only update the selected car
 
-    // pbr: generate a 2D LUT from the BRDF equations used.
-    // ----------------------------------------------------
-    unsigned int brdfLUTTexture;
-    glGenTextures(1, &brdfLUTTexture);
+                TelemetrySample sample;
+                selectedCar->takeTelemetry(sample);
+                sample.tick = telemetryTick++;
+                telemetry.record(sample);
+            }
+        }
+        collisionStats.endTick();
+        perfHud.addSimulationTime(PerfHud::millisecondsSince(simulationStart));
 
-    // pre-allocate enough memory for the LUT texture.
-    glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 512, 512, 0, GL_RG, GL_FLOAT, 0);
-    // be sure to set wrapping mode to GL_CLAMP_TO_EDGE
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // then re-configure capture framebuffer object and render screen-space quad with BRDF shader.
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLUTTexture, 0);
-
-    glViewport(0, 0, 512, 512);
-    brdfShader.use();
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    renderQuad();
-
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-
-    chevConfig.position = glm::vec3(-3.0f, 10.0f, -53.0f);
-    chevConfig.startPosition = glm::vec3(-2.5f, 0.0f, -1.5f);
-    chevConfig.bodyOffset = glm::vec3(0.0f, -1.5f, 0.0f);
-    chevConfig.bodyScale = glm::vec3(0.7f, 0.7f, 0.7f);
-    chevConfig.wheelScale = glm::vec3(0.7f, 0.7f, 0.7f);
-    chevConfig.carWeight = 1000.0f;
-    chevConfig.maxSpeed = 30.0f;
-    chevConfig.acceleration = 8.0f;
-    chevConfig.brakingForce = 7.5f;
-	chevConfig.turnSharpnessFactor = 1.0f;
-    chevConfig.maxSteeringAngleAtMaxSpeed= 30.0f;
-	chevConfig.maxSteeringAngleAtZeroSpeed = 45.0f;
-    chevConfig.frontRightWheelOffset = glm::vec3(-0.8f, -1.2f, 1.50f);
-    chevConfig.frontLeftWheelOffset = glm::vec3(0.8f, -1.2f, 1.50f);
-    chevConfig.backRightWheelOffset = glm::vec3(-0.8f, -1.2f, -1.1f);
-    chevConfig.backLeftWheelOffset = glm::vec3(0.8f, -1.2f, -1.1f);
-
-    cadillacConfig.position = glm::vec3(3.0f, 10.0f,-57.0f);
-    cadillacConfig.startPosition = glm::vec3(2.5f, 0.0f, -1.5f);
-    cadillacConfig.bodyOffset = glm::vec3(0.0f, -1.5f, 0.0f);
-    cadillacConfig.bodyScale = glm::vec3(0.5f, 0.5f, 0.5f);
-    cadillacConfig.wheelScale = glm::vec3(0.4f, 0.4f, 0.4f);
-    cadillacConfig.carWeight = 1300.0f;
-    cadillacConfig.maxSpeed = 25.0f;
-    cadillacConfig.acceleration = 4.0f;
-    cadillacConfig.brakingForce = 3.0f;
-	cadillacConfig.turnSharpnessFactor = 0.7f;
-	cadillacConfig.maxSteeringAngleAtMaxSpeed = 10.0f;
-	cadillacConfig.maxSteeringAngleAtZeroSpeed = 45.0f;
-
-    cadillacConfig.frontRightWheelOffset = glm::vec3(-0.65f, -1.2f, 1.20f);
-    cadillacConfig.frontLeftWheelOffset = glm::vec3(0.65f, -1.2f, 1.20f);
-    cadillacConfig.backRightWheelOffset = glm::vec3(-0.65f, -1.2f, -1.20f);
-    cadillacConfig.backLeftWheelOffset = glm::vec3(0.65f, -1.2f, -1.20f);
-
-    gridSize = calculateOptimalGridSize(trackModel, gridHeight);
-
-    chev.applyConfig(chevConfig);
-    cadillac.applyConfig(cadillacConfig);
-   
-    selectedCar = &chev;
-    camera.LookAtCar(chev.getPosition() - glm::vec3(0, 1.8f, 0));
-
-    chev.startSelectionRotation();
-    cadillac.startSelectionRotation();
-  
-
-    assignTrianglesToGrid(trackModel, gridSize, gridWidth, gridHeight, gridCells);
-    assignTrianglesToGrid(trackCollisionModel, gridSize, gridWidth, gridHeight, gridCellsCollision);
-    chev.setCollisionGrid(gridCells,gridCellsCollision, gridSize, gridWidth, gridHeight);
-    cadillac.setCollisionGrid(gridCells, gridCellsCollision, gridSize, gridWidth, gridHeight);
-    soundManager.preloadSound("accelerate", "Sounds/accelerate_sound2.wav");
-    soundManager.preloadSound("music", "Sounds/Plasma.wav");
-    soundManager.playSound("music", true);
-	soundManager.setVolume("music", 0.5f);
-
-    pbrShader.use();
-    for (int i = 0; i < 4; ++i) {
-        pbrShader.setVec3("lightPositions[" + std::to_string(i) + "]", lightPositions[i]);
-        pbrShader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
-    }
-
-
-    int scrWidth, scrHeight;
-    glfwGetFramebufferSize(window, &scrWidth, &scrHeight);
-    glViewport(0, 0, scrWidth, scrHeight);
-
-    // render loop
-    // -----------
-    while (!glfwWindowShouldClose(window))
-    {
-
-        // per-frame time logic
-        // --------------------
-
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        // input
-        // -----
-        processInput(window);
-       
-        camera.FollowCar(selectedCar->getPosition(), selectedCar->getDirection(), selectedCar->getSpeed(), selectedCar->getMaxSpeed(), selectedCar->getSteeringAngle(), deltaTime);
-        camera.CarPosition = selectedCar->getPosition();
-        camera.Update(deltaTime);
-        // render
-        // ------
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        
-        pbrShader.use();
-
-        // view/projection transformations
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, near_plane, far_plane);
-        glm::mat4 view = camera.GetViewMatrix();
-        pbrShader.setMat4("projection", projection);
-        pbrShader.setMat4("view", view);
-        pbrShader.setVec3("camPos", camera.Position);
-
-        //track
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
-
-
-        renderScene(pbrShader);
-
-        //Update car position and direction
-        selectedCar->updatePositionAndDirection(deltaTime);
-        selectedCar->updateModelMatrix(deltaTime);  // Update the car and wheel transformations
-
-        if (!gameStarted) {
-            chev.update(deltaTime);
-            cadillac.update(deltaTime);
-
-        }
-        else {
-            selectedCar->update(deltaTime); // Only update the selected car
-        }
-
-        //render skybox
-        skybox.draw(view, projection);
+        //render skybox
+        perfHud.beginPass(GpuPass::Skybox);
+        skyboxes.draw(view, projection);
+        perfHud.endPass(GpuPass::Skybox);
 
+        perfHud.beginPass(GpuPass::Text);
         if (gameStarted) {
             // Update timer
             timer.update(selectedCar->getPosition());
@@ -601,78 +699,128 @@ int main()
         else
         {
             RenderText(textShader, "Press [1]/[2] to select car.", 10.0f, static_cast<float>(SCR_HEIGHT) - 50.0f, 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-            RenderText(textShader, "Press [Enter] to confirm.", 10.0f, static_cast<float>(SCR_HEIGHT) - 80.0f, 0.8f, glm::vec3(0.0f, 1.0f, 0.0f));
+            if (assetsReady) {
+                RenderText(textShader, "Press [Enter] to confirm.", 10.0f, static_cast<float>(SCR_HEIGHT) - 80.0f, 0.8f, glm::vec3(0.0f, 1.0f, 0.0f));
+            }
+            else {
+                std::string loadingText = "Loading assets... " + std::to_string(static_cast<int>(assetLoader.progress() * 100.0f)) + "%";
+                RenderText(textShader, loadingText, 10.0f, static_cast<float>(SCR_HEIGHT) - 80.0f, 0.8f, glm::vec3(1.0f, 0.8f, 0.0f));
+            }
+            RenderText(textShader, "Press [E] to change environment.", 10.0f, static_cast<float>(SCR_HEIGHT) - 110.0f, 0.8f, glm::vec3(0.0f, 1.0f, 0.0f));
         }
-        handleCarSound(soundManager, chev);
-        handleCarSound(soundManager, cadillac);
+        perfHud.draw(textShader, static_cast<float>(SCR_WIDTH), static_cast<float>(SCR_HEIGHT));
+        // the grid is built on a worker, it may only be read once loading is done
+        if (assetsReady) {
+            collisionOverlay.draw(textShader, gridCells, gridCellsCollision, gridWidth, gridHeight, gridSize, selectedCar->getPosition());
+        }
+        perfHud.endPass(GpuPass::Text);
+
+        handleCarSound(*engineAudio, chevEngineEmitter, chev);
+        handleCarSound(*engineAudio, cadillacEngineEmitter, cadillac);
+        engineAudio->update(camera.Position, camera.Front, camera.Up, deltaTime);
+        soundManager.update(deltaTime);
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
+        perfHud.endFrame();
+        framePacer.waitForNextFrame();
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
+    telemetry.stop();
+    std::cout << "Frame times: ";
+    framePacer.histogram().writeJson(std::cout);
+    std::cout << ", " << framePacer.stutterCount() << " stutters" << std::endl;
+    // the models outlive main's streamer and residency manager
+    TextureRegistry::get().setTextureStreamer(nullptr);
+    perfHud.setResidencyManager(nullptr);
     glfwTerminate();
+    delete renderBenchmark;
+    delete engineAudio;
     return 0;
 }
 
 void renderScene(Shader& shader) {
-    // Track
+    PROFILE_ZONE("renderScene");
+    perfHud.beginPass(GpuPass::Track);
+    renderTrack(shader);
+    perfHud.endPass(GpuPass::Track);
+    perfHud.beginPass(GpuPass::Cars);
+    renderCars(shader);
+    perfHud.endPass(GpuPass::Cars);
+}
+
+void renderTrack(Shader& shader) {
     glm::mat4 model = glm::mat4(1.0f);
     shader.setMat4("model", glm::transpose(glm::inverse(glm::mat3(model))));
     shader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(model))));
     trackVisual->Draw(shader);
+}
 
-    // Render cars based on game state and activation
-    if (!gameStarted || (gameStarted && chev.isActive())) {
-        // Draw the Chevrolet car body
-        shader.setMat4("model", chev.getModelMatrix());
-        shader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(chev.getModelMatrix()))));
-        carModel->Draw(shader);  // Assuming carModel is the model for Chevrolet
-
-        // Draw the Chevrolet wheels
-        shader.setMat4("model", chev.getFrontLeftWheelModelMatrix());
-        shader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(chev.getFrontLeftWheelModelMatrix()))));
-        wheelModel->Draw(shader);  // Assuming wheelModel is shared or change accordingly
-
-        shader.setMat4("model", chev.getFrontRightWheelModelMatrix());
-        shader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(chev.getFrontRightWheelModelMatrix()))));
-        wheelModel->Draw(shader);
-
-        shader.setMat4("model", chev.getBackLeftWheelModelMatrix());
-        shader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(chev.getBackLeftWheelModelMatrix()))));
-        wheelModel->Draw(shader);
-
-        shader.setMat4("model", chev.getBackRightWheelModelMatrix());
-        shader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(chev.getBackRightWheelModelMatrix()))));
-        wheelModel->Draw(shader);
-    }
+bool isCarVisible(const Car& car) {
+    return !gameStarted || car.isActive();
+}
 
-    if (!gameStarted || (gameStarted && cadillac.isActive())) {
-        // Draw the Jeep car body
-        shader.setMat4("model", cadillac.getModelMatrix());
-        shader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(cadillac.getModelMatrix()))));
-        car2Model->Draw(shader);  // Assuming car2Model is the model for Jeep
+void renderCar(Shader& shader, const Car& car, Model& body, Model& wheel) {
+    // Draw the car body
+    shader.setMat4("model", car.getModelMatrix());
+    shader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(car.getModelMatrix()))));
+    body.Draw(shader);
+
+    // Draw the wheels
+    glm::mat4 wheelMatrices[4] = {
+        car.getFrontLeftWheelModelMatrix(),
+        car.getFrontRightWheelModelMatrix(),
+        car.getBackLeftWheelModelMatrix(),
+        car.getBackRightWheelModelMatrix()
+    };
+    for (const glm::mat4& wheelMatrix : wheelMatrices) {
+        shader.setMat4("model", wheelMatrix);
+        shader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(wheelMatrix))));
+        wheel.Draw(shader);
+    }
+}
 
-        // Draw the Jeep wheels
-        shader.setMat4("model", cadillac.getFrontLeftWheelModelMatrix());
-        shader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(cadillac.getFrontLeftWheelModelMatrix()))));
-        wheel2Model->Draw(shader);  // Assuming wheel2Model is shared or change accordingly
+void renderCars(Shader& shader) {
+    // Render cars based on game state and activation
+    if (isCarVisible(chev)) {
+        renderCar(shader, chev, *carModel, *wheelModel);
+    }
+    if (isCarVisible(cadillac)) {
+        renderCar(shader, cadillac, *car2Model, *wheel2Model);
+    }
+}
 
-        shader.setMat4("model", cadillac.getFrontRightWheelModelMatrix());
-        shader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(cadillac.getFrontRightWheelModelMatrix()))));
-        wheel2Model->Draw(shader);
+void renderShadows(CascadedShadowMap& shadowMap, Shader& shadowShader, float aspect) {
+    PROFILE_ZONE("renderShadows");
+    shadowMap.update(camera.Position, camera.Front, glm::radians(camera.Zoom), aspect, near_plane);
 
-        shader.setMat4("model", cadillac.getBackLeftWheelModelMatrix());
-        shader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(cadillac.getBackLeftWheelModelMatrix()))));
-        wheel2Model->Draw(shader);
+    // the track only goes back into a cascade after that cascade has re-centred
+    for (int c = 0; c < SHADOW_CASCADE_COUNT; ++c) {
+        if (shadowMap.needsStaticUpdate(c)) {
+            shadowMap.beginStaticPass(c, shadowShader);
+            renderTrack(shadowShader);
+            shadowMap.endStaticPass(c);
+        }
+    }
 
-        shader.setMat4("model", cadillac.getBackRightWheelModelMatrix());
-        shader.setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(cadillac.getBackRightWheelModelMatrix()))));
-        wheel2Model->Draw(shader);
+    // the cars are redrawn every frame, each only inside its own small region of every cascade
+    shadowMap.beginCasterPasses();
+    Car* cars[] = { &chev, &cadillac };
+    Model* bodies[] = { carModel, car2Model };
+    Model* wheels[] = { wheelModel, wheel2Model };
+    for (int i = 0; i < 2; ++i) {
+        if (!isCarVisible(*cars[i])) continue;
+        for (int c = 0; c < SHADOW_CASCADE_COUNT; ++c) {
+            if (shadowMap.beginCaster(c, cars[i]->getPosition(), CAR_SHADOW_RADIUS, shadowShader)) {
+                renderCar(shadowShader, *cars[i], *bodies[i], *wheels[i]);
+            }
+        }
     }
+    shadowMap.endCasterPasses();
 }
 
 
@@ -691,7 +839,75 @@ void processInput(GLFWwindow* window)
         camera.LookAtCar(cadillac.getPosition() - glm::vec3(0, 1.0f, 0));
     }
 
-    if (glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS) {
+    // only react to the press itself, not every frame the key is held
+    static bool environmentKeyHeld = false;
+    bool environmentKeyDown = glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS;
+    if (environmentKeyDown && !environmentKeyHeld && !gameStarted) {
+        environmentChangeRequested = true;
+    }
+    environmentKeyHeld = environmentKeyDown;
+
+    static bool hudKeyHeld = false;
+    bool hudKeyDown = glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS;
+    if (hudKeyDown && !hudKeyHeld) {
+        perfHud.toggle();
+    }
+    hudKeyHeld = hudKeyDown;
+
+    static bool pacingKeyHeld = false;
+    bool pacingKeyDown = glfwGetKey(window, GLFW_KEY_F6) == GLFW_PRESS;
+    if (pacingKeyDown && !pacingKeyHeld) {
+        framePacer.cycleMode();
+    }
+    pacingKeyHeld = pacingKeyDown;
+
+    static bool collisionKeyHeld = false;
+    bool collisionKeyDown = glfwGetKey(window, GLFW_KEY_F4) == GLFW_PRESS;
+    if (collisionKeyDown && !collisionKeyHeld) {
+        collisionOverlay.cycleMode();
+    }
+    collisionKeyHeld = collisionKeyDown;
+
+    static bool skyboxKeyHeld = false;
+    bool skyboxKeyDown = glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS;
+    if (skyboxKeyDown && !skyboxKeyHeld) {
+        skyboxChangeRequested = true;
+    }
+    skyboxKeyHeld = skyboxKeyDown;
+
+    static bool profileToggleHeld = false;
+    bool profileToggleDown = glfwGetKey(window, GLFW_KEY_F8) == GLFW_PRESS;
+    if (profileToggleDown && !profileToggleHeld) {
+        Profiler::setEnabled(!Profiler::isEnabled());
+        std::cout << "Profiler " << (Profiler::isEnabled() ? "recording" : "paused") << std::endl;
+    }
+    profileToggleHeld = profileToggleDown;
+
+    static bool profileWriteHeld = false;
+    bool profileWriteDown = glfwGetKey(window, GLFW_KEY_F9) == GLFW_PRESS;
+    if (profileWriteDown && !profileWriteHeld) {
+        Profiler::writeChromeTrace(PROFILE_TRACE_PATH);
+    }
+    profileWriteHeld = profileWriteDown;
+
+    // the recording becomes a drive script for the physics regression cases
+    static bool recordKeyHeld = false;
+    bool recordKeyDown = glfwGetKey(window, GLFW_KEY_F7) == GLFW_PRESS;
+    if (recordKeyDown && !recordKeyHeld) {
+        driveRecording = !driveRecording;
+        if (driveRecording) {
+            recordedDrive.clear();
+            std::cout << "Recording drive input" << std::endl;
+        }
+        else if (recordedDrive.save(RECORDED_DRIVE_PATH)) {
+            std::cout << "Drive input saved to " << RECORDED_DRIVE_PATH << std::endl;
+        }
+    }
+    recordKeyHeld = recordKeyDown;
+
+    // the race can only start once the cars have a collision grid to drive on, the benchmark starts it itself
+    bool startPressed = glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS || (renderBenchmark && !gameStarted);
+    if (startPressed && assetsReady) {
         selectedCar->stopSelectionRotation();
         selectedCar->moveToStartPosition();
         selectedCar->resetRotation();
@@ -710,30 +926,22 @@ void processInput(GLFWwindow* window)
 
     // Acceleration and braking
     if (selectedCar && selectedCar->isActive() && gameStarted) {
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
-            selectedCar->accelerate(deltaTime);
-        }
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
-            selectedCar->brake(deltaTime);
+        DriveInput input;
+        if (renderBenchmark) {
+            static int raceFrame = 0;
+            input = renderBenchmark->inputFor(raceFrame++);
         }
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_RELEASE && glfwGetKey(window, GLFW_KEY_S) == GLFW_RELEASE) {
-            selectedCar->slowDown(deltaTime);
+        else {
+            input.accelerate = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+            input.brake = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+            input.steerLeft = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+            input.steerRight = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
         }
 
-        // Steering
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
-            selectedCar->steerLeft(deltaTime);
+        if (driveRecording) {
+            recordedDrive.append(input);
         }
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
-            selectedCar->steerRight(deltaTime);
-        }
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_RELEASE && glfwGetKey(window, GLFW_KEY_D) == GLFW_RELEASE) {
-            selectedCar->centerSteering(deltaTime);
-        }
-
-        // Update car position and direction
-        selectedCar->updatePositionAndDirection(deltaTime);
-        selectedCar->updateWheelRotations(deltaTime);
+        selectedCar->drive(input, deltaTime);
     }
 }
 
@@ -808,164 +1016,278 @@ glm::vec3 calculateTriangleNormal(const glm::vec3& v0, const glm::vec3& v1, cons
     return normal;
 }
 
-void printGridCells() {
 
-    int totalSum = 0;
 
-    for (int i = 0; i < gridCells.size(); ++i) {
 
-        int num = gridCells[i].size();  // Number of triangles in this cell
-        std::cout << "Grid Cell " << i << std::endl;
-        std::cout << "Number of triangles: " << num << std::endl;
 
-        totalSum += num;
-    }
-
-    std::cout << "TOTAL SUM: " << totalSum << std::endl;
-}
 
 
-int getGridIndex(int x, int z, int gridWidth) {
-    return z * gridWidth + x;
+void handleCarSound(EngineAudio& engineAudio, int emitter, const Car& car) {
+    // moving forward: pitch and volume follow the speed, stopped or hidden: the engine fades out
+    float speedRatio = std::max(car.getSpeed() / car.getMaxSpeed(), 0.0f);
+    float loudness = car.getSpeed() > 0.0f && isCarVisible(car) ? glm::clamp(speedRatio, 0.2f, 1.0f) : 0.0f;
+    engineAudio.setEmitter(emitter, car.getPosition(), loudness, 1.0f + speedRatio);
 }
 
 
-void assignTrianglesToGrid(const Model& trackModel, float gridSize, int gridWidth, int gridHeight, std::vector<std::vector<Triangle>>& gridCells) {
 
-    // Resize gridCells
-    gridCells.resize(gridWidth * gridHeight);
 
-    for (const Mesh& mesh : trackModel.meshes) {
-        for (unsigned int i = 0; i < mesh.indices.size(); i += 3) {
+// bakeIBL() renders the environment cubemap, irradiance map, pre-filter map and BRDF LUT for one HDR image
+// ---------------------------------------------------------------------------------------------------------
+bool bakeIBL(const std::string& hdrPath, IBLMaps& maps, Shader& equirectangularToCubemapShader, Shader& irradianceShader, Shader& prefilterShader, Shader& brdfShader)
+{
+    PROFILE_ZONE("IBL precompute");
+    // pbr: setup framebuffer
+   // ----------------------
+    unsigned int captureFBO;
+    unsigned int captureRBO;
+    glGenFramebuffers(1, &captureFBO);
+    glGenRenderbuffers(1, &captureRBO);
 
-            glm::vec3 v0 = mesh.vertices[mesh.indices[i]].Position;
-            glm::vec3 v1 = mesh.vertices[mesh.indices[i + 1]].Position;
-            glm::vec3 v2 = mesh.vertices[mesh.indices[i + 2]].Position;
+    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
 
-            // min and maxx and z coordinates of the triangle
-            float minX = std::min({ v0.x, v1.x, v2.x });
-            float maxX = std::max({ v0.x, v1.x, v2.x });
-            float minZ = std::min({ v0.z, v1.z, v2.z });
-            float maxZ = std::max({ v0.z, v1.z, v2.z });
+    // pbr: load the HDR environment map
+    // ---------------------------------
+    // flipped by hand rather than with stbi_set_flip_vertically_on_load, which is global and would
+    // also flip whatever the asset loader threads are decoding at the same time
+    int width, height, nrComponents;
+    float* data = stbi_loadf(hdrPath.c_str(), &width, &height, &nrComponents, 0);
+    if (data)
+    {
+        size_t rowFloats = static_cast<size_t>(width) * nrComponents;
+        for (int y = 0; y < height / 2; ++y)
+            std::swap_ranges(data + y * rowFloats, data + (y + 1) * rowFloats, data + (height - 1 - y) * rowFloats);
+    }
+    unsigned int hdrTexture = 0;
+    bool hdrLoaded = data != nullptr;
+    if (data)
+    {
+        glGenTextures(1, &hdrTexture);
+        glBindTexture(GL_TEXTURE_2D, hdrTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data); // note how we specify the texture's data value to be float
 
-            //grid cells that the triangle overlaps (how far way the point is from the origin in terms of grid cells)
-            int minGridX = static_cast<int>(floor(minX / gridSize));
-            int maxGridX = static_cast<int>(floor(maxX / gridSize));
-            int minGridZ = static_cast<int>(floor(minZ / gridSize));
-            int maxGridZ = static_cast<int>(floor(maxZ / gridSize));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-            // Clamp grid coordinates to ensure they stay within the grid boundaries
-            minGridX = std::max(0, std::min(gridWidth - 1, minGridX));
-            maxGridX = std::max(0, std::min(gridWidth - 1, maxGridX));
-            minGridZ = std::max(0, std::min(gridHeight - 1, minGridZ));
-            maxGridZ = std::max(0, std::min(gridHeight - 1, maxGridZ));
+        std::cout << "HDR Loaded: Width = " << width << ", Height = " << height << ", Components = " << nrComponents << std::endl;
 
-            Triangle tri = { v0, v1, v2 };
+        stbi_image_free(data);
 
-            // Assign the triangle to the relevant grid cells
-            for (int x = minGridX; x <= maxGridX; ++x) {
-                for (int z = minGridZ; z <= maxGridZ; ++z) {
-                    int index = getGridIndex(x, z, gridWidth);
-                    gridCells[index].push_back(tri);
-                }
-            }
-        }
+    }
+    else
+    {
+        std::cout << "Failed to load HDR image." << std::endl;
     }
 
-    //printGridCells();
-
-}
-
-void checkTrackSize(const Model& trackModel) {
+    // pbr: setup cubemap to render to and attach to framebuffer
+    // ---------------------------------------------------------
+    unsigned int& envCubemap = maps.envCubemap;
+    glGenTextures(1, &envCubemap);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 512, 512, 0, GL_RGB, GL_FLOAT, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // enable pre-filter mipmap sampling (combatting visible dots artifact)
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    int minX = 0;
-    int maxX = 0;
+    // pbr: set up projection and view matrices for capturing data onto the 6 cubemap face directions
+    // ----------------------------------------------------------------------------------------------
+    glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+    glm::mat4 captureViews[] =
+    {
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
 
-    for (const Mesh& mesh : trackModel.meshes) {
-        for (unsigned int i = 0; i < mesh.indices.size(); i += 3) {
+    };
 
-            glm::vec3 v0 = mesh.vertices[mesh.indices[i]].Position;
-            glm::vec3 v1 = mesh.vertices[mesh.indices[i + 1]].Position;
-            glm::vec3 v2 = mesh.vertices[mesh.indices[i + 2]].Position;
+    // pbr: convert HDR equirectangular environment map to cubemap equivalent
+    // ----------------------------------------------------------------------
+    equirectangularToCubemapShader.use();
+    equirectangularToCubemapShader.setInt("equirectangularMap", 0);
+    equirectangularToCubemapShader.setMat4("projection", captureProjection);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, hdrTexture);
 
-            if (v0.x < minX) minX = v0.x;
-            if (v1.x < minX) minX = v1.x;
-            if (v2.x < minX) minX = v2.x;
+    glViewport(0, 0, 512, 512); // don't forget to configure the viewport to the capture dimensions.
+    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        equirectangularToCubemapShader.setMat4("view", captureViews[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-            if (v0.x > maxX) maxX = v0.x;
-            if (v1.x > maxX) maxX = v1.x;
-            if (v2.x > maxX) maxX = v2.x;
+        renderCube();
 
-        }
     }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    std::cout << "Minimum X: " << minX << "Maximum Y" << maxX << std::endl;
+    // then let OpenGL generate mipmaps from first mip face (combatting visible dots artifact)
+    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
-}
+    // pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
+    // --------------------------------------------------------------------------------
+    unsigned int& irradianceMap = maps.irradianceMap;
+    glGenTextures(1, &irradianceMap);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 32, 32, 0, GL_RGB, GL_FLOAT, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-void handleCarSound(SoundManager& soundManager, const Car& car) {
-    static float fadeOutVolume = 1.0f;
+    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 32, 32);
 
-    // Check if the car is moving forward
-    if (car.getSpeed() > 0.0f) {
-        // If the sound is not playing, play it from the beginning
-        if (!soundManager.isPlaying("accelerate")) {
-            soundManager.stopSound("accelerate");  // Ensure the sound is reset
-            soundManager.playSound("accelerate", true);  // Play looped
-            soundManager.setVolume("accelerate", 0.2f);  // Start with a low volume
-        }
+    // pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
+    // -----------------------------------------------------------------------------
+    irradianceShader.use();
+    irradianceShader.setInt("environmentMap", 0);
+    irradianceShader.setMat4("projection", captureProjection);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
 
-        // Adjust pitch and volume based on speed
-        float pitch = 1.0f + (car.getSpeed() / car.getMaxSpeed());
-        soundManager.setPlaybackSpeed("accelerate", pitch);
+    glViewport(0, 0, 32, 32); // don't forget to configure the viewport to the capture dimensions.
+    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        irradianceShader.setMat4("view", captureViews[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        float volume = glm::clamp(car.getSpeed() / car.getMaxSpeed(), 0.2f, 1.0f);
-        soundManager.setVolume("accelerate", volume);
+        renderCube();
 
-        fadeOutVolume = volume;
     }
-    else {  // If the car is stopped
-        if (fadeOutVolume > 0.0f) {
-            fadeOutVolume -= deltaTime * 0.5f;
-            fadeOutVolume = glm::clamp(fadeOutVolume, 0.0f, 1.0f);
-            soundManager.setVolume("accelerate", fadeOutVolume);
-        }
-        else {
-            soundManager.stopSound("accelerate");  // Stop the sound when fully faded out
-        }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // pbr: create a pre-filter cubemap, and re-scale capture FBO to pre-filter scale.
+    // --------------------------------------------------------------------------------
+    unsigned int& prefilterMap = maps.prefilterMap;
+    glGenTextures(1, &prefilterMap);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 128, 128, 0, GL_RGB, GL_FLOAT, nullptr);
     }
-}
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // be sure to set minification filter to mip_linear 
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // generate mipmaps for the cubemap so OpenGL automatically allocates the required memory.
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
+    // pbr: run a quasi monte-carlo simulation on the environment lighting to create a prefilter (cube)map.
+    // ----------------------------------------------------------------------------------------------------
+    prefilterShader.use();
+    prefilterShader.setInt("environmentMap", 0);
+    prefilterShader.setMat4("projection", captureProjection);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
 
-float calculateOptimalGridSize(const Model& trackModel, int desiredGridCount) {
+    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    unsigned int maxMipLevels = 5;
+    for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
+    {
+        // reisze framebuffer according to mip-level size.
+        unsigned int mipWidth = static_cast<unsigned int>(128 * std::pow(0.5, mip));
+        unsigned int mipHeight = static_cast<unsigned int>(128 * std::pow(0.5, mip));
+        glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
+        glViewport(0, 0, mipWidth, mipHeight);
 
-    // Initialize min and max bounds
-    glm::vec3 minBounds(FLT_MAX, FLT_MAX, FLT_MAX);
-    glm::vec3 maxBounds(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        float roughness = (float)mip / (float)(maxMipLevels - 1);
+        prefilterShader.setFloat("roughness", roughness);
+        for (unsigned int i = 0; i < 6; ++i)
+        {
+            prefilterShader.setMat4("view", captureViews[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilterMap, mip);
 
-    for (const Mesh& mesh : trackModel.meshes) {
-        for (unsigned int i = 0; i < mesh.indices.size(); i++) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            renderCube();
+        }
+    }
 
-            glm::vec3 vertex = mesh.vertices[mesh.indices[i]].Position;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-            minBounds = glm::min(minBounds, vertex);
-            maxBounds = glm::max(maxBounds, vertex);
+    // pbr: generate a 2D LUT from the BRDF equations used.
+    // ----------------------------------------------------
+    unsigned int& brdfLUTTexture = maps.brdfLUTTexture;
+    glGenTextures(1, &brdfLUTTexture);
 
-        }
-    }
+    // pre-allocate enough memory for the LUT texture.
+    glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 512, 512, 0, GL_RG, GL_FLOAT, 0);
+    // be sure to set wrapping mode to GL_CLAMP_TO_EDGE
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // Calculate the dimensions of the bounding box for the entire track
-    glm::vec3 trackSize = maxBounds - minBounds;
+    // then re-configure capture framebuffer object and render screen-space quad with BRDF shader.
+    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLUTTexture, 0);
 
-    // Find the maximum extent along the X and Z axes (for 2D grid division)
-    float maxDimension = glm::max(trackSize.x, trackSize.z);
+    glViewport(0, 0, 512, 512);
+    brdfShader.use();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    renderQuad();
 
-    // Calculate the optimal grid size based on the desired number of grids
-    float gridSize = maxDimension / desiredGridCount;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    return gridSize;
+    // the equirectangular source and the capture targets are only needed while baking
+    glDeleteTextures(1, &hdrTexture);
+    glDeleteRenderbuffers(1, &captureRBO);
+    glDeleteFramebuffers(1, &captureFBO);
+    return hdrLoaded;
 }
 
+// loadEnvironment() uploads the IBL maps for hdrPath from the disk cache, baking and caching them on a miss
+// ---------------------------------------------------------------------------------------------------------
+void loadEnvironment(const std::string& hdrPath, IBLMaps& maps, Shader& equirectangularToCubemapShader, Shader& irradianceShader, Shader& prefilterShader, Shader& brdfShader)
+{
+    PROFILE_ZONE("Load environment");
+    // the key covers the HDR contents and every shader that takes part in the bake
+    uint64_t key = iblCache.computeKey(hdrPath, {
+        "Shaders/PBR/cubemap.vs", "Shaders/PBR/equirectangular_to_cubemap.fs", "Shaders/PBR/irradiance_convolution.fs",
+        "Shaders/PBR/prefilter.fs", "Shaders/PBR/brdf.vs", "Shaders/PBR/brdf.fs" });
+
+    IBLMaps loaded;
+    if (iblCache.load(hdrPath, key, loaded))
+    {
+        std::cout << "IBL maps loaded from cache: " << hdrPath << std::endl;
+    }
+    else
+    {
+        // never cache the black maps produced from a missing HDR
+        if (bakeIBL(hdrPath, loaded, equirectangularToCubemapShader, irradianceShader, prefilterShader, brdfShader))
+            iblCache.save(hdrPath, key, loaded);
+    }
+
+    maps.release();
+    maps = loaded;
+    MemoryAccounting::get().set(&maps, MemoryCategory::IBL, hdrPath, 0, maps.gpuBytes());
+}
 
 // renderCube() renders a 1x1 3D cube in NDC.
 // -------------------------------------------------
@@ -1115,151 +1437,136 @@ void renderUIQuad() {
 
 }
 
-unsigned int loadTexture(const char* path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else {
-        std::cout << "Failed to load texture: " << path << std::endl;
-        stbi_image_free(data);
-    }
+// returns the texture name right away, it is decoded on a worker and streamed in once ready.
+// Shared through the TextureRegistry, a file that is already loaded is not loaded again.
+unsigned int loadTexture(const char* path, AssetLoader& assetLoader, TextureStreamer& textureStreamer) {
+    std::string filename = path;
+    TextureKey key = TextureRegistry::get().makeKey(filename, TextureUsage::Color, GL_TEXTURE_2D, GL_CLAMP_TO_EDGE);
+    bool owner = TextureRegistry::get().claim(key);
+    unsigned int textureID = TextureRegistry::get().acquire(key);
+    if (!owner) return textureID;
+
+    std::shared_ptr<TextureImage> image = std::make_shared<TextureImage>();
+    assetLoader.enqueue(filename, [image, filename] {
+        *image = loadTextureImage(filename, TextureUsage::Color);
+    }, [image, filename, key, textureID, &textureStreamer] {
+        if (image->empty()) {
+            std::cout << "Failed to load texture: " << filename << std::endl;
+        }
+        TextureRegistry::get().finishUpload(key, filename, textureGpuBytes(*image));
+        textureStreamer.stream(textureID, *image, GL_CLAMP_TO_EDGE);
+        return true;
+    });
 
     return textureID;
 }
 
-void initTextRendering(const std::string& fontPath) {
-    // Initialize FreeType library
-    FT_Library ft;
-    if (FT_Init_FreeType(&ft)) {
-        std::cerr << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
-        return;
-    }
-
-    if (fontPath.empty())
-    {
-        std::cout << "ERROR::FREETYPE: Failed to load fontPath" << std::endl;
-        return;
-    }
+// --cook-textures: every texture the game loads, compressed for how the materials use it
+int cookTextures() {
+    const char* modelPaths[] = {
+        TRACK_MODEL_PATH, TRACK_VISUAL_MODEL_PATH, CHEV_BODY_MODEL_PATH, CHEV_WHEEL_MODEL_PATH,
+        CADILLAC_BODY_MODEL_PATH, CADILLAC_WHEEL_MODEL_PATH
+    };
 
-    FT_Face face;
-    if (FT_New_Face(ft, fontPath.c_str(), 0, &face)) {
-        std::cerr << "ERROR::FREETYPE: Failed to load font" << std::endl;
-        FT_Done_FreeType(ft);
-        return;
+    TextureCooker cooker(TEXTURE_CACHE_DIRECTORY);
+    int failed = 0;
+    for (const char* path : modelPaths) {
+        Model model;
+        model.loadModel(path, false);
+        for (const CachedTextureRef& texture : model.textureReferences()) {
+            if (!cooker.cook(model.directory + "/" + texture.path, textureUsageForType(texture.type))) failed++;
+        }
     }
-
-    FT_Set_Pixel_Sizes(face, 0, 48);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Disable byte-alignment restriction
-
-    // Load first 128 characters of ASCII
-    for (unsigned char c = 0; c < 128; c++) {
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-            std::cerr << "ERROR::FREETYPE: Failed to load Glyph" << std::endl;
-            continue;
+    for (const SkyboxEnvironment& environment : skyboxEnvironments) {
+        for (const std::string& face : environment.faces) {
+            if (!cooker.cook(face, TextureUsage::Sky)) failed++;
         }
-        unsigned int texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-        );
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        Character character = {
-            texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            static_cast<unsigned int>(face->glyph->advance.x)
-        };
-        Characters.insert(std::pair<char, Character>(c, character));
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    // Clean up FreeType
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
-
-    // Set up text VAO/VBO
-    glGenVertexArrays(1, &textVAO);
-    glGenBuffers(1, &textVBO);
-    glBindVertexArray(textVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+
+    std::cout << "Texture cooking done, " << failed << " failed" << std::endl;
+    return failed == 0 ? 0 : 1;
 }
 
-void RenderText(Shader& shader, std::string text, float x, float y, float scale, glm::vec3 color) {
+void setupCarConfigs() {
+    chevConfig.position = glm::vec3(-3.0f, 10.0f, -53.0f);
+    chevConfig.startPosition = glm::vec3(-2.5f, 0.0f, -1.5f);
+    chevConfig.bodyOffset = glm::vec3(0.0f, -1.5f, 0.0f);
+    chevConfig.bodyScale = glm::vec3(0.7f, 0.7f, 0.7f);
+    chevConfig.wheelScale = glm::vec3(0.7f, 0.7f, 0.7f);
+    chevConfig.carWeight = 1000.0f;
+    chevConfig.maxSpeed = 30.0f;
+    chevConfig.acceleration = 8.0f;
+    chevConfig.brakingForce = 7.5f;
+	chevConfig.turnSharpnessFactor = 1.0f;
+    chevConfig.maxSteeringAngleAtMaxSpeed= 30.0f;
+	chevConfig.maxSteeringAngleAtZeroSpeed = 45.0f;
+    chevConfig.frontRightWheelOffset = glm::vec3(-0.8f, -1.2f, 1.50f);
+    chevConfig.frontLeftWheelOffset = glm::vec3(0.8f, -1.2f, 1.50f);
+    chevConfig.backRightWheelOffset = glm::vec3(-0.8f, -1.2f, -1.1f);
+    chevConfig.backLeftWheelOffset = glm::vec3(0.8f, -1.2f, -1.1f);
 
-    glUseProgram(shader.ID); // Use text shader
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Ensure proper blending for text
-    glUniform3f(glGetUniformLocation(shader.ID, "textColor"), color.x, color.y, color.z);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(textVAO);
+    cadillacConfig.position = glm::vec3(3.0f, 10.0f,-57.0f);
+    cadillacConfig.startPosition = glm::vec3(2.5f, 0.0f, -1.5f);
+    cadillacConfig.bodyOffset = glm::vec3(0.0f, -1.5f, 0.0f);
+    cadillacConfig.bodyScale = glm::vec3(0.5f, 0.5f, 0.5f);
+    cadillacConfig.wheelScale = glm::vec3(0.4f, 0.4f, 0.4f);
+    cadillacConfig.carWeight = 1300.0f;
+    cadillacConfig.maxSpeed = 25.0f;
+    cadillacConfig.acceleration = 4.0f;
+    cadillacConfig.brakingForce = 3.0f;
+	cadillacConfig.turnSharpnessFactor = 0.7f;
+	cadillacConfig.maxSteeringAngleAtMaxSpeed = 10.0f;
+	cadillacConfig.maxSteeringAngleAtZeroSpeed = 45.0f;
 
-    std::string::const_iterator c;
-    for (c = text.begin(); c != text.end(); c++) {
-        Character ch = Characters[*c];
+    cadillacConfig.frontRightWheelOffset = glm::vec3(-0.65f, -1.2f, 1.20f);
+    cadillacConfig.frontLeftWheelOffset = glm::vec3(0.65f, -1.2f, 1.20f);
+    cadillacConfig.backRightWheelOffset = glm::vec3(-0.65f, -1.2f, -1.20f);
+    cadillacConfig.backLeftWheelOffset = glm::vec3(0.65f, -1.2f, -1.20f);
+}
 
-        float xpos = x + ch.Bearing.x * scale;
-        float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
+// --benchmark-physics: times the collision queries and the car update on the real track, no window needed
+int benchmarkPhysics(const std::string& outputPath) {
+    Model trackModel(ModelLoadMode::CollisionOnly);
+    Model trackCollisionModel(ModelLoadMode::CollisionOnly);
+    trackModel.loadModel(TRACK_MODEL_PATH, false);
+    trackCollisionModel.loadModel(TRACK_COLLISION_MODEL_PATH, false);
 
-        float w = ch.Size.x * scale;
-        float h = ch.Size.y * scale;
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos,     ypos,       0.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
+    setupCarConfigs();
+    return runPhysicsBenchmarks(trackModel.collisionMeshes, trackCollisionModel.collisionMeshes, chevConfig, gridHeight,
+        outputPath, PHYSICS_BENCHMARK_SEED);
+}
 
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
-            { xpos + w, ypos + h,   1.0f, 0.0f }
-        };
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+// --physics-regression: replays the drive scripts with both cars, see PhysicsRegression.h
+int physicsRegression(bool record, const RegressionTolerance& tolerance) {
+    Model trackModel(ModelLoadMode::CollisionOnly);
+    Model trackCollisionModel(ModelLoadMode::CollisionOnly);
+    trackModel.loadModel(TRACK_MODEL_PATH, false);
+    trackCollisionModel.loadModel(TRACK_COLLISION_MODEL_PATH, false);
+
+    setupCarConfigs();
+    const std::pair<std::string, CarConfig> cars[] = { { "chev", chevConfig }, { "cadillac", cadillacConfig } };
+    std::vector<RegressionCase> cases;
+    for (const auto& car : cars) {
+        for (const std::string& script : regressionScripts) {
+            RegressionCase regressionCase;
+            regressionCase.name = car.first + "_" + script;
+            regressionCase.config = car.second;
+            regressionCase.scriptPath = std::string(REGRESSION_DIRECTORY) + "/scripts/" + script + ".txt";
+            cases.push_back(regressionCase);
+        }
+    }
+    return runPhysicsRegression(trackModel.collisionMeshes, trackCollisionModel.collisionMeshes, gridHeight, cases,
+        REGRESSION_DIRECTORY, record, tolerance);
+}
 
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        x += (ch.Advance >> 6) * scale;
+// std::stod throws on text that is not a number, report it like any other bad argument instead
+bool parseNumberArgument(const std::string& option, const char* text, double& value) {
+    try {
+        value = std::stod(text);
+        return true;
+    }
+    catch (const std::logic_error&) {   // invalid_argument or out_of_range
+        std::cout << "Invalid value " << text << " for " << option << std::endl;
+        return false;
     }
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
 }
\ No newline at end of file
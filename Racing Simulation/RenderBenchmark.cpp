@@ -0,0 +1,121 @@
+#include "RenderBenchmark.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+// the lap, every segment holds its keys for a number of frames and the script repeats once done
+static std::vector<DriveSegment> lapScript() {
+    const struct { int frames; bool accelerate; bool brake; int steer; } segments[] = {
+        { 180, true,  false,  0 },      // off the line
+        { 60,  true,  false, -1 },
+        { 120, true,  false,  0 },
+        { 40,  false, true,   0 },      // brake into the hairpin
+        { 90,  true,  false,  1 },
+        { 150, true,  false,  0 },
+        { 60,  true,  false, -1 },
+        { 200, true,  false,  0 },
+        { 30,  false, true,  -1 },
+        { 80,  true,  false,  1 },
+        { 160, true,  false,  0 },
+    };
+    std::vector<DriveSegment> lap;
+    for (const auto& segment : segments) {
+        DriveSegment entry;
+        entry.frames = segment.frames;
+        entry.input.accelerate = segment.accelerate;
+        entry.input.brake = segment.brake;
+        entry.input.steerLeft = segment.steer < 0;
+        entry.input.steerRight = segment.steer > 0;
+        lap.push_back(entry);
+    }
+    return lap;
+}
+
+static const char* const PASS_KEYS[] = { "shadows", "track", "cars", "skybox", "text", "ibl" };
+
+RenderBenchmark::RenderBenchmark(int warmupFrames, int measuredFrames)
+    : script(lapScript()), warmupFrames(warmupFrames), measuredFrames(measuredFrames) {
+    samples.reserve(measuredFrames);
+}
+
+DriveInput RenderBenchmark::inputFor(int frame) const {
+    return script.inputFor(frame);
+}
+
+void RenderBenchmark::recordFrame(const PerfHud& hud) {
+    if (isFinished()) return;
+    if (framesSeen++ < warmupFrames) return;
+
+    FrameSample sample;
+    sample.frameMs = hud.frameMilliseconds();
+    sample.cpuMs = hud.cpuMilliseconds();
+    sample.simulationMs = hud.simulationMilliseconds();
+    sample.drawCalls = hud.frameStats().drawCalls;
+    sample.triangles = hud.frameStats().triangles;
+    for (int pass = 0; pass < PerfHud::PASS_COUNT; ++pass) {
+        sample.passMs[pass] = hud.passMilliseconds(static_cast<GpuPass>(pass));
+    }
+    samples.push_back(sample);
+}
+
+bool RenderBenchmark::isFinished() const {
+    return static_cast<int>(samples.size()) >= measuredFrames;
+}
+
+// nearest rank on an already sorted list
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(p / 100.0 * sorted.size() + 0.5);
+    rank = std::max<size_t>(rank, 1);
+    return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+static const char* glString(GLenum name) {
+    const GLubyte* text = glGetString(name);
+    return text ? reinterpret_cast<const char*>(text) : "unknown";
+}
+
+bool RenderBenchmark::writeReport(const std::string& outputPath) const {
+    if (samples.empty()) return false;
+
+    std::vector<double> frameTimes;
+    double frameSum = 0.0, cpuSum = 0.0, simulationSum = 0.0, drawCallSum = 0.0, triangleSum = 0.0;
+    double passSum[PerfHud::PASS_COUNT] = {};
+    for (const FrameSample& sample : samples) {
+        frameTimes.push_back(sample.frameMs);
+        frameSum += sample.frameMs;
+        cpuSum += sample.cpuMs;
+        simulationSum += sample.simulationMs;
+        drawCallSum += sample.drawCalls;
+        triangleSum += static_cast<double>(sample.triangles);
+        for (int pass = 0; pass < PerfHud::PASS_COUNT; ++pass) passSum[pass] += sample.passMs[pass];
+    }
+    std::sort(frameTimes.begin(), frameTimes.end());
+    double count = static_cast<double>(samples.size());
+
+    std::ofstream file(outputPath, std::ios::trunc);
+    if (!file) {
+        std::cout << "Failed to write benchmark report " << outputPath << std::endl;
+        return false;
+    }
+    // the strings tell a software renderer run apart from a hardware one
+    file << "{\n  \"renderer\": \"" << glString(GL_RENDERER) << "\",\n  \"version\": \"" << glString(GL_VERSION) << "\",\n";
+    file << "  \"warmupFrames\": " << warmupFrames << ",\n  \"frames\": " << samples.size() << ",\n";
+    file << "  \"frameMs\": { \"mean\": " << frameSum / count << ", \"median\": " << percentile(frameTimes, 50.0)
+         << ", \"p95\": " << percentile(frameTimes, 95.0) << ", \"p99\": " << percentile(frameTimes, 99.0)
+         << ", \"min\": " << frameTimes.front() << ", \"max\": " << frameTimes.back() << " },\n";
+    file << "  \"cpuMs\": " << cpuSum / count << ",\n  \"simulationMs\": " << simulationSum / count << ",\n";
+    file << "  \"drawCalls\": " << drawCallSum / count << ",\n  \"triangles\": " << triangleSum / count << ",\n";
+    file << "  \"gpuPassMs\": {";
+    for (int pass = 0; pass < PerfHud::PASS_COUNT; ++pass) {
+        file << (pass ? ", " : " ") << "\"" << PASS_KEYS[pass] << "\": " << passSum[pass] / count;
+    }
+    file << " }\n}\n";
+
+    std::cout << "Render benchmark: " << samples.size() << " frames, mean " << frameSum / count << " ms, p99 "
+              << percentile(frameTimes, 99.0) << " ms, written to " << outputPath << std::endl;
+    return true;
+}
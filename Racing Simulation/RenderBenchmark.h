@@ -0,0 +1,46 @@
+#ifndef RENDER_BENCHMARK_H
+#define RENDER_BENCHMARK_H
+
+#include <string>
+#include <vector>
+
+#include "DriveInput.h"
+#include "PerfHud.h"
+
+// End to end render benchmark, run with --benchmark-render [output.json].
+// The game loads as usual in a hidden window with vsync off, starts the race with the first car and drives a
+// fixed input script on a fixed timestep, so the car and the following camera take the same path on every
+// machine and only the time a frame takes differs. After the warm-up frames every frame is recorded and the
+// report holds the mean, median, p95 and p99 frame times, draw calls and the GPU time of each pass.
+// Runs under a software GL as well, e.g. Mesa llvmpipe with LIBGL_ALWAYS_SOFTWARE=1 on a machine without a GPU.
+class RenderBenchmark {
+public:
+    RenderBenchmark(int warmupFrames, int measuredFrames);
+
+    // frame counts from the start of the race
+    DriveInput inputFor(int frame) const;
+
+    // right after PerfHud::beginFrame(), which has just closed the previous frame
+    void recordFrame(const PerfHud& hud);
+    bool isFinished() const;
+
+    bool writeReport(const std::string& outputPath) const;
+
+private:
+    struct FrameSample {
+        double frameMs;
+        double cpuMs;
+        double simulationMs;
+        unsigned int drawCalls;
+        unsigned long long triangles;
+        double passMs[PerfHud::PASS_COUNT];
+    };
+
+    DriveScript script;
+    int warmupFrames;
+    int measuredFrames;
+    int framesSeen = 0;
+    std::vector<FrameSample> samples;
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+// Draw calls and triangles submitted since the last reset, PerfHud resets it at the start of every frame
+struct RenderStats {
+    unsigned int drawCalls = 0;
+    unsigned long long triangles = 0;
+
+    void addDraw(unsigned int triangleCount) {
+        drawCalls++;
+        triangles += triangleCount;
+    }
+    void reset() {
+        drawCalls = 0;
+        triangles = 0;
+    }
+};
+
+extern RenderStats renderStats;
+
+#endif
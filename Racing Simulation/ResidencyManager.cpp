@@ -0,0 +1,101 @@
+#include "ResidencyManager.h"
+#include "Profiler.h"
+
+#include <iostream>
+
+ResidencyManager::ResidencyManager(size_t cpuBudget, size_t gpuBudget) : cpuBudget(cpuBudget), gpuBudget(gpuBudget) {}
+
+void ResidencyManager::registerAsset(const std::string& name, const ResidentAssetCallbacks& callbacks) {
+    assets[name].callbacks = callbacks;
+}
+
+ResidencyManager::Asset* ResidencyManager::find(const std::string& name) {
+    auto found = assets.find(name);
+    if (found == assets.end()) {
+        std::cout << "ResidencyManager: unknown asset " << name << std::endl;
+        return nullptr;
+    }
+    return &found->second;
+}
+
+void ResidencyManager::acquire(const std::string& name) {
+    Asset* asset = find(name);
+    if (!asset) return;
+    asset->references++;
+    asset->lastUsedFrame = frame;
+    if (!asset->resident) {
+        asset->resident = true;
+        loads++;
+        asset->callbacks.load();
+    }
+}
+
+void ResidencyManager::release(const std::string& name) {
+    Asset* asset = find(name);
+    if (!asset || asset->references == 0) return;
+    asset->references--;
+    asset->lastUsedFrame = frame;
+}
+
+void ResidencyManager::touch(const std::string& name) {
+    Asset* asset = find(name);
+    if (asset) asset->lastUsedFrame = frame;
+}
+
+bool ResidencyManager::overBudget() const {
+    return cpuBytes > cpuBudget || gpuBytes > gpuBudget;
+}
+
+void ResidencyManager::update() {
+    PROFILE_ZONE("Residency update");
+    cpuBytes = gpuBytes = 0;
+    for (auto& entry : assets) {
+        Asset& asset = entry.second;
+        if (asset.resident && asset.callbacks.isLoaded()) {
+            asset.callbacks.memoryUsage(asset.cpuBytes, asset.gpuBytes);
+        }
+        cpuBytes += asset.cpuBytes;
+        gpuBytes += asset.gpuBytes;
+    }
+
+    while (overBudget()) {
+        // only assets that finished loading can be unloaded, a half loaded one is still owned by the AssetLoader
+        Asset* victim = nullptr;
+        const std::string* victimName = nullptr;
+        for (auto& entry : assets) {
+            Asset& asset = entry.second;
+            if (!asset.resident || asset.references > 0 || !asset.callbacks.isLoaded()) continue;
+            if (!victim || asset.lastUsedFrame < victim->lastUsedFrame) {
+                victim = &asset;
+                victimName = &entry.first;
+            }
+        }
+        if (!victim) break;
+
+        std::cout << "Evicting " << *victimName << " (" << victim->cpuBytes / 1024 << " KB CPU, "
+            << victim->gpuBytes / 1024 << " KB GPU)" << std::endl;
+        victim->callbacks.unload();
+        victim->resident = false;
+        cpuBytes -= victim->cpuBytes;
+        gpuBytes -= victim->gpuBytes;
+        victim->cpuBytes = victim->gpuBytes = 0;
+        evictions++;
+    }
+    frame++;
+}
+
+ResidencyStats ResidencyManager::stats() const {
+    ResidencyStats stats;
+    stats.cpuBytes = cpuBytes;
+    stats.gpuBytes = gpuBytes;
+    stats.cpuBudget = cpuBudget;
+    stats.gpuBudget = gpuBudget;
+    stats.loads = loads;
+    stats.evictions = evictions;
+    for (const auto& entry : assets) {
+        stats.registeredAssets++;
+        if (entry.second.resident) stats.residentAssets++;
+        if (entry.second.references > 0) stats.referencedAssets++;
+    }
+    return stats;
+}
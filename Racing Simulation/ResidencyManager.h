@@ -0,0 +1,73 @@
+#ifndef RESIDENCY_MANAGER_H
+#define RESIDENCY_MANAGER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+// How the manager drives one asset. Every callback runs on the GL thread.
+struct ResidentAssetCallbacks {
+    std::function<void()> load;     // starts loading, usually by enqueueing on the AssetLoader
+    std::function<bool()> isLoaded;
+    std::function<void()> unload;   // frees the CPU and GPU memory, the asset may be loaded again later
+    std::function<void(size_t& cpuBytes, size_t& gpuBytes)> memoryUsage;
+};
+
+struct ResidencyStats {
+    size_t cpuBytes = 0;
+    size_t gpuBytes = 0;
+    size_t cpuBudget = 0;
+    size_t gpuBudget = 0;
+    unsigned int registeredAssets = 0;
+    unsigned int residentAssets = 0;
+    unsigned int referencedAssets = 0;
+    unsigned int loads = 0;       // since startup, reloads included
+    unsigned int evictions = 0;
+};
+
+// Keeps the loaded assets within a CPU and a GPU memory budget. Assets are reference counted:
+// acquire() loads an asset that is not resident, release() makes it evictable once nothing holds it.
+// When update() finds a budget exceeded it unloads unreferenced assets, least recently used first.
+// Referenced assets are never evicted, so the budgets can be overrun while everything is in use.
+class ResidencyManager {
+public:
+    ResidencyManager(size_t cpuBudget, size_t gpuBudget);
+
+    void registerAsset(const std::string& name, const ResidentAssetCallbacks& callbacks);
+
+    void acquire(const std::string& name);
+    void release(const std::string& name);
+    // marks the asset as used this frame without holding a reference
+    void touch(const std::string& name);
+
+    // Once per frame: refreshes the sizes of resident assets and evicts while over budget
+    void update();
+
+    ResidencyStats stats() const;
+
+private:
+    struct Asset {
+        ResidentAssetCallbacks callbacks;
+        unsigned int references = 0;
+        bool resident = false;      // load() was called and unload() was not
+        uint64_t lastUsedFrame = 0;
+        size_t cpuBytes = 0;
+        size_t gpuBytes = 0;
+    };
+
+    Asset* find(const std::string& name);
+    bool overBudget() const;
+
+    std::map<std::string, Asset> assets;
+    size_t cpuBudget;
+    size_t gpuBudget;
+    size_t cpuBytes = 0;
+    size_t gpuBytes = 0;
+    uint64_t frame = 0;
+    unsigned int loads = 0;
+    unsigned int evictions = 0;
+};
+
+#endif
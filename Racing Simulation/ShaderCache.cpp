@@ -0,0 +1,175 @@
+#include "ShaderCache.h"
+#include "FileUtils.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+// Bump whenever the file layout changes
+const uint32_t SHADER_CACHE_VERSION = 1;
+const char SHADER_CACHE_MAGIC[4] = { 'R', 'S', 'H', 'B' };
+
+struct ShaderCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t binaryFormat;  // driver specific, handed back to glProgramBinary
+    uint32_t binarySize;
+};
+
+static uint64_t hashGLString(GLenum name, uint64_t seed) {
+    const GLubyte* text = glGetString(name);
+    return text ? hashString(reinterpret_cast<const char*>(text), seed) : seed;
+}
+
+static void printShaderLog(unsigned int shader, const char* type) {
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        GLchar infoLog[1024];
+        glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+        std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+    }
+}
+
+static bool linkSucceeded(unsigned int program, bool printLog) {
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success && printLog) {
+        GLchar infoLog[1024];
+        glGetProgramInfoLog(program, 1024, NULL, infoLog);
+        std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: PROGRAM\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+    }
+    return success != 0;
+}
+
+static unsigned int startCompile(GLenum type, const std::vector<char>& source) {
+    unsigned int shader = glCreateShader(type);
+    const char* code = source.data();
+    GLint length = static_cast<GLint>(source.size());
+    glShaderSource(shader, 1, &code, &length);
+    glCompileShader(shader);
+    return shader;
+}
+
+ShaderCache::ShaderCache(const std::string& cacheDirectory) : cacheDirectory(cacheDirectory) {
+    // program binaries are core from 4.1, the context asks for 3.3 but drivers usually hand out more
+    GLint formatCount = 0;
+    if (glGetProgramBinary && glProgramBinary && glProgramParameteri) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    }
+    binariesSupported = formatCount > 0;
+    if (!binariesSupported) {
+        std::cout << "Program binaries not supported, shaders are compiled on every launch" << std::endl;
+    }
+
+    driverHash = hashBytes(&SHADER_CACHE_VERSION, sizeof(SHADER_CACHE_VERSION));
+    driverHash = hashGLString(GL_VENDOR, driverHash);
+    driverHash = hashGLString(GL_RENDERER, driverHash);
+    driverHash = hashGLString(GL_VERSION, driverHash);
+}
+
+std::string ShaderCache::cachePathFor(const std::string& vertexPath, const std::string& fragmentPath) const {
+    // several programs share a vertex shader, the fragment shader tells them apart
+    return cacheDirectory + "/" + flattenPath(vertexPath) + "+" + fileNameFromPath(fragmentPath) + ".prog";
+}
+
+unsigned int ShaderCache::createProgram(const char* vertexPath, const char* fragmentPath) {
+    std::vector<char> vertexSource, fragmentSource;
+    if (!readFileBytes(vertexPath, vertexSource) || !readFileBytes(fragmentPath, fragmentSource)) {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << vertexPath << ", " << fragmentPath << std::endl;
+    }
+
+    uint64_t key = hashBytes(vertexSource.data(), vertexSource.size(), driverHash);
+    key = hashBytes(fragmentSource.data(), fragmentSource.size(), key);
+
+    unsigned int program = glCreateProgram();
+    std::string cachePath = cachePathFor(vertexPath, fragmentPath);
+    if (binariesSupported && loadBinary(program, cachePath, key)) {
+        return program;
+    }
+
+    PROFILE_ZONE("Shader compile start");
+    PendingProgram entry;
+    entry.program = program;
+    entry.vertex = startCompile(GL_VERTEX_SHADER, vertexSource);
+    entry.fragment = startCompile(GL_FRAGMENT_SHADER, fragmentSource);
+    entry.vertexPath = vertexPath;
+    entry.fragmentPath = fragmentPath;
+    entry.key = key;
+    glAttachShader(program, entry.vertex);
+    glAttachShader(program, entry.fragment);
+    if (binariesSupported) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+    pending.push_back(entry);
+    return program;
+}
+
+void ShaderCache::finishPending() {
+    PROFILE_ZONE("Shader compile finish");
+    for (const PendingProgram& entry : pending) {
+        // the first status query is where the driver makes us wait for its compile
+        printShaderLog(entry.vertex, "VERTEX");
+        printShaderLog(entry.fragment, "FRAGMENT");
+        bool linked = linkSucceeded(entry.program, true);
+        glDetachShader(entry.program, entry.vertex);
+        glDetachShader(entry.program, entry.fragment);
+        glDeleteShader(entry.vertex);
+        glDeleteShader(entry.fragment);
+
+        if (linked && binariesSupported) {
+            saveBinary(entry.program, cachePathFor(entry.vertexPath, entry.fragmentPath), entry.key);
+        }
+    }
+    pending.clear();
+}
+
+bool ShaderCache::loadBinary(unsigned int program, const std::string& cachePath, uint64_t key) const {
+    PROFILE_ZONE("Shader binary load");
+    std::ifstream file(cachePath, std::ios::binary);
+    if (!file) return false;
+
+    ShaderCacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (!std::equal(SHADER_CACHE_MAGIC, SHADER_CACHE_MAGIC + 4, header.magic) || header.version != SHADER_CACHE_VERSION ||
+        header.key != key) {
+        return false;
+    }
+
+    std::vector<char> binary(header.binarySize);
+    if (!file.read(binary.data(), binary.size())) return false;
+
+    glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+    // a driver update can reject a binary even with matching strings, the caller then compiles from source
+    return linkSucceeded(program, false);
+}
+
+void ShaderCache::saveBinary(unsigned int program, const std::string& cachePath, uint64_t key) const {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(program, length, nullptr, &binaryFormat, binary.data());
+
+    if (!ensureDirectory(cacheDirectory)) {
+        std::cout << "Failed to create shader cache directory " << cacheDirectory << std::endl;
+        return;
+    }
+    std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "Failed to write shader cache " << cachePath << std::endl;
+        return;
+    }
+
+    ShaderCacheHeader header;
+    std::copy(SHADER_CACHE_MAGIC, SHADER_CACHE_MAGIC + 4, header.magic);
+    header.version = SHADER_CACHE_VERSION;
+    header.key = key;
+    header.binaryFormat = binaryFormat;
+    header.binarySize = static_cast<uint32_t>(length);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), binary.size());
+}
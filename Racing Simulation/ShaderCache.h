@@ -0,0 +1,44 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Builds shader programs through a driver program-binary cache.
+// A program is linked from its stored binary when the key matches: the hash of both source files and of the
+// GL vendor, renderer and version strings, since a binary is only valid for the driver that produced it.
+// Otherwise createProgram() only issues the compile and link calls and finishPending() checks them later,
+// so drivers that compile on their own threads can work on every program at once.
+class ShaderCache {
+public:
+    ShaderCache(const std::string& cacheDirectory);
+
+    // returns the program name straight away, it may still be compiling until finishPending()
+    unsigned int createProgram(const char* vertexPath, const char* fragmentPath);
+
+    // waits for the programs started since the last call, reports errors and stores the new binaries
+    void finishPending();
+
+private:
+    struct PendingProgram {
+        unsigned int program;
+        unsigned int vertex;
+        unsigned int fragment;
+        std::string vertexPath;
+        std::string fragmentPath;
+        uint64_t key;
+    };
+
+    std::string cachePathFor(const std::string& vertexPath, const std::string& fragmentPath) const;
+    bool loadBinary(unsigned int program, const std::string& cachePath, uint64_t key) const;
+    void saveBinary(unsigned int program, const std::string& cachePath, uint64_t key) const;
+
+    std::string cacheDirectory;
+    uint64_t driverHash = 0;
+    bool binariesSupported = false;
+    std::vector<PendingProgram> pending;
+};
+
+#endif
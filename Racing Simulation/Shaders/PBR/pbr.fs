@@ -3,6 +3,7 @@ out vec4 FragColor;
 in vec2 TexCoords;
 in vec3 WorldPos;
 in vec3 Normal;
+in float ViewDepth;
 
 // material parameters
 uniform sampler2D albedoMap;
@@ -10,6 +11,8 @@ uniform sampler2D normalMap;
 uniform sampler2D metallicMap;
 uniform sampler2D roughnessMap;
 uniform sampler2D aoMap;
+// cooked normal maps are BC5 and only carry x and y, uncooked ones are plain RGB
+uniform bool normalMapTwoChannel;
 
 // IBL
 uniform samplerCube irradianceMap;
@@ -22,6 +25,15 @@ uniform vec3 lightColors[4];
 
 uniform vec3 camPos;
 
+// sun shadow cascades
+const int CASCADE_COUNT = 3;
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 lightSpaceMatrices[CASCADE_COUNT];
+uniform float cascadeSplits[CASCADE_COUNT];
+uniform float cascadeTexelSizes[CASCADE_COUNT];
+uniform vec3 sunDirection;
+uniform float shadowStrength;
+
 const float PI = 3.14159265359;
 // ----------------------------------------------------------------------------
 // Easy trick to get tangent-normals to world-space to keep PBR code simplified.
@@ -30,7 +42,15 @@ const float PI = 3.14159265359;
 // technique somewhere later in the normal mapping tutorial.
 vec3 getNormalFromMap()
 {
-    vec3 tangentNormal = texture(normalMap, TexCoords).xyz * 2.0 - 1.0;
+    vec3 tangentNormal;
+    if (normalMapTwoChannel) {
+        // rebuild z from the unit length
+        tangentNormal.xy = texture(normalMap, TexCoords).rg * 2.0 - 1.0;
+        tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
+    }
+    else {
+        tangentNormal = texture(normalMap, TexCoords).rgb * 2.0 - 1.0;
+    }
 
     vec3 Q1  = dFdx(WorldPos);
     vec3 Q2  = dFdy(WorldPos);
@@ -90,6 +110,40 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }   
 // ----------------------------------------------------------------------------
+// Returns 1.0 when fully lit by the sun and 0.0 when fully in shadow.
+float sunVisibility(vec3 N)
+{
+    int cascade = -1;
+    for(int i = CASCADE_COUNT - 1; i >= 0; --i)
+    {
+        if(ViewDepth < cascadeSplits[i])
+            cascade = i;
+    }
+    if(cascade < 0)
+        return 1.0;
+
+    // push the lookup along the normal by a couple of texels to avoid acne at grazing angles
+    float NdotL = max(dot(N, -sunDirection), 0.0);
+    vec3 offsetPos = WorldPos + N * cascadeTexelSizes[cascade] * (1.5 - NdotL);
+    vec4 lightSpacePos = lightSpaceMatrices[cascade] * vec4(offsetPos, 1.0);
+    vec3 projCoords = lightSpacePos.xyz / lightSpacePos.w * 0.5 + 0.5;
+    if(projCoords.z > 1.0)
+        return 1.0;
+
+    // 3x3 PCF on top of the hardware 2x2 depth comparison
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float visibility = 0.0;
+    for(int x = -1; x <= 1; ++x)
+    {
+        for(int y = -1; y <= 1; ++y)
+        {
+            vec2 offset = vec2(x, y) * texelSize;
+            visibility += texture(shadowMap, vec4(projCoords.xy + offset, float(cascade), projCoords.z));
+        }
+    }
+    return visibility / 9.0;
+}
+// ----------------------------------------------------------------------------
 void main()
 {		
     // material properties
@@ -189,6 +243,8 @@ void main()
     vec3 specular = prefilteredColor * (F * brdf.x + brdf.y);
 
     vec3 ambient = (kD * diffuse + specular) * ao;
+    // the environment has no separate sun light, so sun shadows darken the IBL term
+    ambient *= mix(1.0 - shadowStrength, 1.0, sunVisibility(normalize(N)));
     
     vec3 color = ambient + Lo;
 
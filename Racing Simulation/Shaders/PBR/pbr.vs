@@ -6,17 +6,38 @@ layout (location = 2) in vec2 aTexCoords;
 out vec2 TexCoords;
 out vec3 WorldPos;
 out vec3 Normal;
+out float ViewDepth;
 
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
 uniform mat3 normalMatrix;
 
+// static meshes upload quantized positions/UVs and octahedral normals (see PackedVertex in mesh.h)
+uniform bool packedVertex;
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform vec2 uvScale;
+uniform vec2 uvOffset;
+
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if(n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
 void main()
 {
-    TexCoords = aTexCoords;
-    WorldPos = vec3(model * vec4(aPos, 1.0));
-    Normal = normalMatrix * aNormal;   
+    vec3 position = aPos * positionScale + positionOffset;
+    vec3 normal = packedVertex ? octDecode(aNormal.xy) : aNormal;
+
+    TexCoords = aTexCoords * uvScale + uvOffset;
+    WorldPos = vec3(model * vec4(position, 1.0));
+    Normal = normalMatrix * normal;   
+    // distance along the view direction, selects the shadow cascade
+    ViewDepth = -(view * vec4(WorldPos, 1.0)).z;
 
     gl_Position =  projection * view * vec4(WorldPos, 1.0);
 }
\ No newline at end of file
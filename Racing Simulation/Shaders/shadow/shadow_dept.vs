@@ -4,7 +4,11 @@ layout (location = 0) in vec3 aPos;
 uniform mat4 lightSpaceMatrix;
 uniform mat4 model;
 
+// static meshes upload quantized positions (see PackedVertex in mesh.h)
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
 void main()
 {
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+    gl_Position = lightSpaceMatrix * model * vec4(aPos * positionScale + positionOffset, 1.0);
 }
\ No newline at end of file
@@ -1,20 +1,99 @@
 // Skybox.cpp
 #include "Skybox.h"
 #include "Skybox.h"
-#include <stb_image.h>
+#include "TextureCooker.h"
+#include "TextureStreamer.h"
+#include "FileUtils.h"
+#include "RenderStats.h"
+#include <future>
 #include <iostream>
 #include <glm/gtc/type_ptr.hpp>
 
-Skybox::Skybox(const std::vector<std::string>& faces, unsigned int shaderProg)
+Skybox::Skybox(const std::vector<std::string>& faces, unsigned int shaderProg, bool loadNow)
     : faces(faces), shaderProgram(shaderProg) {
-    load();
+    if (loadNow) load();
 }
 
 Skybox::~Skybox() {
+    if (textureClaimed) {
+        // leaving before the faces went up hands the upload to another skybox of the same faces
+        if (textureOwner && !loaded) TextureRegistry::get().abandon(textureKey);
+        else TextureRegistry::get().release(textureKey);
+    }
+    // nothing was created before the first upload step
+    if (!skyboxVAO) return;
     glDeleteVertexArrays(1, &skyboxVAO);
     glDeleteBuffers(1, &skyboxVBO);
 }
+
 void Skybox::load() {
+    decodeFaces();
+    while (!upload()) {}
+}
+
+// cooked BC7 faces when there are some, otherwise stb_image, safe to call from a worker thread
+void Skybox::decodeFaces() {
+    // the cubemap is identified by the contents of all six faces together
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (const std::string& face : faces) {
+        uint64_t faceHash = TextureRegistry::get().contentHash(face);
+        hash = hashBytes(&faceHash, sizeof(faceHash), hash);
+    }
+    textureKey = TextureRegistry::get().makeKey(hash, TextureUsage::Sky, GL_TEXTURE_CUBE_MAP, GL_CLAMP_TO_EDGE);
+    textureOwner = TextureRegistry::get().claim(textureKey);
+    textureClaimed = true;
+    if (textureOwner) decodeFaceImages();
+}
+
+void Skybox::decodeFaceImages() {
+    // the faces are independent, decoding them side by side takes about as long as the largest one
+    faceImages.resize(faces.size());
+    std::vector<std::future<void>> decodes;
+    for (unsigned int i = 0; i < faces.size(); i++) {
+        decodes.push_back(std::async(std::launch::async, [this, i] {
+            faceImages[i] = loadTextureImage(faces[i], TextureUsage::Sky);
+        }));
+    }
+    for (std::future<void>& decode : decodes) {
+        decode.get();
+    }
+}
+
+bool Skybox::upload() {
+    if (!skyboxVAO) {
+        createVertexArray();
+        if (!textureOwner && TextureRegistry::get().adopt(textureKey)) {
+            // the skybox that claimed these faces went away before uploading them, decode them here instead
+            textureOwner = true;
+            decodeFaceImages();
+        }
+        cubemapTexture = TextureRegistry::get().acquire(textureKey);
+        if (!textureOwner) {
+            loaded = true;
+            return true;
+        }
+        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        return false;
+    }
+
+    if (uploadedFaces < faceImages.size()) {
+        uploadFace(uploadedFaces++);
+        if (uploadedFaces < faceImages.size()) return false;
+    }
+
+    std::string name = faces.empty() ? std::string() : faces[0].substr(0, faces[0].find_last_of('/'));
+    TextureRegistry::get().finishUpload(textureKey, name, uploadedBytes);
+    faceImages.clear();
+    loaded = true;
+    return true;
+}
+
+void Skybox::createVertexArray() {
     float skyboxVertices[] = {
         // positions          
         -1.0f,  1.0f, -1.0f,
@@ -66,38 +145,24 @@ void Skybox::load() {
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-
-    cubemapTexture = loadCubemap(faces);
-
 }
 
-unsigned int Skybox::loadCubemap(const std::vector<std::string>& faces) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    int width, height, nrChannels;
-    for (unsigned int i = 0; i < faces.size(); i++) {
-        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        if (data) {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        }
-        else {
-            std::cerr << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-            stbi_image_free(data);
-        }
+// only level 0 is sampled, the skybox is drawn without mipmapping
+void Skybox::uploadFace(unsigned int face) {
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+    if (!faceImages[face].empty()) {
+        uploadTextureLevel(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, faceImages[face], 0);
+        // the sky is decoded without mips, level 0 is the whole face
+        uploadedBytes += textureGpuBytes(faceImages[face], 1);
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    return textureID;
+    else {
+        std::cerr << "Cubemap texture failed to load at path: " << faces[face] << std::endl;
+    }
+    faceImages[face] = TextureImage();
 }
 
 void Skybox::draw(glm::mat4 view, glm::mat4 projection) {
+    if (!loaded) return;
     glDepthFunc(GL_LEQUAL);
     glUseProgram(shaderProgram);
     glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(glm::mat4(glm::mat3(view))));
@@ -107,6 +172,7 @@ void Skybox::draw(glm::mat4 view, glm::mat4 projection) {
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
     glDrawArrays(GL_TRIANGLES, 0, 36);
+    renderStats.addDraw(12);
     glBindVertexArray(0);
     glDepthFunc(GL_LESS); // Restore depth function
 }
@@ -4,20 +4,37 @@
 #include <string>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include "TextureRegistry.h"
 
 class Skybox {
 public:
-    Skybox(const std::vector<std::string>& faces, unsigned int shaderProg);
+    // loadNow = false leaves loading to decodeFaces (any thread) and upload (GL thread), see AssetLoader
+    Skybox(const std::vector<std::string>& faces, unsigned int shaderProg, bool loadNow = true);
     ~Skybox();
 
     void load();
+    // decodes the six faces on threads of their own and returns once all are done
+    void decodeFaces();
+    // one face per call so a large cubemap is spread over frames, true once the skybox can be drawn
+    bool upload();
     void draw(glm::mat4 view, glm::mat4 projection);
 
+    bool isLoaded() const { return loaded; }
+
 private:
-    unsigned int cubemapTexture;
-    unsigned int skyboxVAO, skyboxVBO;
+    unsigned int cubemapTexture = 0;
+    unsigned int skyboxVAO = 0, skyboxVBO = 0;
     unsigned int shaderProgram;  // Ensure this is declared
     std::vector<std::string> faces;
+    std::vector<TextureImage> faceImages;  // decoded faces waiting for upload
+    TextureKey textureKey;                 // the cubemap is shared through the TextureRegistry
+    bool textureClaimed = false;           // holds a registry reference from decodeFaces on
+    bool textureOwner = false;             // this skybox claimed the key first and uploads the faces
+    unsigned int uploadedFaces = 0;
+    size_t uploadedBytes = 0;              // GPU bytes of the faces uploaded so far
+    bool loaded = false;
 
-    unsigned int loadCubemap(const std::vector<std::string>& faces); // Updated to match implementation
+    void decodeFaceImages();
+    void createVertexArray();
+    void uploadFace(unsigned int face);
 };
\ No newline at end of file
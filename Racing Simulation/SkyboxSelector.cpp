@@ -0,0 +1,44 @@
+#include "SkyboxSelector.h"
+
+#include <iostream>
+
+SkyboxSelector::SkyboxSelector(const std::vector<SkyboxEnvironment>& environments, unsigned int shaderProgram)
+    : environments(environments), shaderProgram(shaderProgram) {}
+
+std::unique_ptr<Skybox> SkyboxSelector::load(int index, AssetLoader& assetLoader) {
+    std::unique_ptr<Skybox> skybox(new Skybox(environments[index].faces, shaderProgram, false));
+    Skybox* target = skybox.get();
+    assetLoader.enqueue("skybox " + environments[index].name, [target] { target->decodeFaces(); }, [target] { return target->upload(); });
+    return skybox;
+}
+
+void SkyboxSelector::start(AssetLoader& assetLoader) {
+    if (environments.empty()) return;
+    current = load(currentIndex, assetLoader);
+    if (environments.size() > 1) {
+        prefetched = load((currentIndex + 1) % environments.size(), assetLoader);
+    }
+}
+
+void SkyboxSelector::next() {
+    if (prefetched) switchRequested = true;
+}
+
+void SkyboxSelector::update(AssetLoader& assetLoader) {
+    // neither skybox may be destroyed while the AssetLoader still holds jobs pointing at it
+    if (!switchRequested || !prefetched->isLoaded() || !current->isLoaded()) return;
+    switchRequested = false;
+
+    currentIndex = (currentIndex + 1) % environments.size();
+    current = std::move(prefetched);
+    std::cout << "Skybox: " << environments[currentIndex].name << std::endl;
+    prefetched = load((currentIndex + 1) % environments.size(), assetLoader);
+}
+
+void SkyboxSelector::draw(const glm::mat4& view, const glm::mat4& projection) {
+    if (current) current->draw(view, projection);
+}
+
+const std::string& SkyboxSelector::currentName() const {
+    return environments[currentIndex].name;
+}
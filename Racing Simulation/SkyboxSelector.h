@@ -0,0 +1,45 @@
+#ifndef SKYBOX_SELECTOR_H
+#define SKYBOX_SELECTOR_H
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AssetLoader.h"
+#include "Skybox.h"
+
+struct SkyboxEnvironment {
+    std::string name;
+    std::vector<std::string> faces;   // +X, -X, +Y, -Y, +Z, -Z
+};
+
+// Cycles through a list of skyboxes at runtime. The one after the current skybox is always being loaded
+// in the background, so next() swaps to it without decoding or uploading anything on that frame.
+// If it is not ready yet the swap waits in update() and the current skybox stays on screen meanwhile.
+class SkyboxSelector {
+public:
+    SkyboxSelector(const std::vector<SkyboxEnvironment>& environments, unsigned int shaderProgram);
+
+    // enqueues the first skybox and the prefetch of the second
+    void start(AssetLoader& assetLoader);
+    void next();
+    // once per frame, swaps when a switch was asked for and the prefetched skybox is uploaded
+    void update(AssetLoader& assetLoader);
+    void draw(const glm::mat4& view, const glm::mat4& projection);
+
+    const std::string& currentName() const;
+
+private:
+    std::unique_ptr<Skybox> load(int index, AssetLoader& assetLoader);
+
+    std::vector<SkyboxEnvironment> environments;
+    unsigned int shaderProgram;
+    int currentIndex = 0;
+    std::unique_ptr<Skybox> current;
+    std::unique_ptr<Skybox> prefetched;   // environments[currentIndex + 1], possibly still loading
+    bool switchRequested = false;
+};
+
+#endif
@@ -1,6 +1,16 @@
 #include "SoundManager.h"
+#include "FileUtils.h"
+#include "MemoryAccounting.h"
 
-SoundManager::SoundManager() {
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+// changes smaller than this are not worth a call into irrKlang
+const float VOICE_EPSILON = 0.002f;
+
+SoundManager::SoundManager() : voices(MAX_VOICES) {
     engine = createIrrKlangDevice();
     /*if (!engine) {
         throw std::runtime_error("Failed to initialize sound engine.");
@@ -14,19 +24,70 @@ SoundManager::~SoundManager() {
             sound->drop(); 
         }
     }
+    for (Voice& voice : voices) {
+        if (voice.sound) releaseVoice(voice);
+    }
     engine->drop();  
 }
 
-void SoundManager::preloadSound(const std::string& name, const std::string& filepath) {
-    ISoundSource* source = engine->addSoundSourceFromFile(filepath.c_str());
-    if (source) {
-        soundSources[name] = source;
-    }
+SoundId SoundManager::preloadSound(const std::string& name, const std::string& filepath, SoundLoad load) {
+    // a streamed source only opens the file here, the decoding happens as it plays
+    ISoundSource* source = load == SoundLoad::Stream ? engine->addSoundSourceFromFile(filepath.c_str(), ESM_STREAMING, false)
+        : engine->addSoundSourceFromFile(filepath.c_str(), ESM_NO_STREAMING, true);
+    if (!source) return INVALID_SOUND;
+    SoundId id = static_cast<SoundId>(sources.size());
+    sources.push_back(source);
+    soundIds[name] = id;
+    reportMemory(id);
+    return id;
+}
+
+SoundId SoundManager::preloadSoundAsync(const std::string& name, const std::string& filepath, AssetLoader& assetLoader) {
+    SoundId id = static_cast<SoundId>(sources.size());
+    sources.push_back(nullptr);
+    soundIds[name] = id;
+
+    std::shared_ptr<std::vector<char>> bytes = std::make_shared<std::vector<char>>();
+    assetLoader.enqueue("sound " + name, [bytes, filepath] {
+        readFileBytes(filepath, *bytes);
+    }, [this, id, bytes, name, filepath] {
+        // irrKlang keeps its own copy, the file bytes go away with the job. It picks the decoder from the
+        // extension of the source name, so the source is named after the file rather than the sound.
+        ISoundSource* source = bytes->empty() ? nullptr
+            : engine->addSoundSourceFromMemory(bytes->data(), static_cast<ik_s32>(bytes->size()), filepath.c_str(), true);
+        // a source of that name exists already when the same file was preloaded before
+        if (!source && !bytes->empty()) source = engine->getSoundSource(filepath.c_str(), false);
+        if (!source) {
+            std::cout << "Failed to load sound: " << filepath << std::endl;
+            return true;
+        }
+        source->setStreamMode(ESM_NO_STREAMING);
+        sources[id] = source;
+        reportMemory(id);
+        return true;
+    });
+    return id;
+}
+
+bool SoundManager::isLoaded(SoundId sound) const {
+    return sound != INVALID_SOUND && sources[sound] != nullptr;
+}
+
+void SoundManager::reportMemory(SoundId sound) const {
+    ISoundSource* source = sources[sound];
+    if (source->getStreamMode() == ESM_STREAMING) return;
+    MemoryAccounting::get().set(source, MemoryCategory::Audio, source->getName(), source->getAudioFormat().getSampleDataSize(), 0);
+}
+
+SoundId SoundManager::findSound(const std::string& name) const {
+    auto found = soundIds.find(name);
+    return found != soundIds.end() ? found->second : INVALID_SOUND;
 }
 
 void SoundManager::playSound(const std::string& name, bool loop) {
-    if (soundSources.find(name) != soundSources.end()) {
-        ISound* sound = engine->play2D(soundSources[name], loop, false, true);
+    SoundId id = findSound(name);
+    if (isLoaded(id)) {
+        ISound* sound = engine->play2D(sources[id], loop, false, true);
         if (sound) {
             activeSounds[name] = sound;  // Keep track of active sounds
         }
@@ -65,3 +126,145 @@ void SoundManager::setPlaybackSpeed(const std::string& name, float speed) {
         activeSounds[name]->setPlaybackSpeed(speed);
     }
 }
+
+static vec3df toIrrKlang(const glm::vec3& v) {
+    return vec3df(v.x, v.y, v.z);
+}
+
+VoiceHandle SoundManager::startVoice(SoundId sound, bool loop, float volume, float speed, float smoothingSeconds) {
+    if (!isLoaded(sound) || activeVoiceCount() == MAX_VOICES) return VoiceHandle();
+    // started paused so the first volume and speed are in place before anything is heard
+    return claimVoice(engine->play2D(sources[sound], loop, true, true), loop, volume, speed, smoothingSeconds);
+}
+
+VoiceHandle SoundManager::startVoice3D(SoundId sound, bool loop, const glm::vec3& position, float minDistance, float volume,
+    float speed, float smoothingSeconds) {
+    if (!isLoaded(sound) || activeVoiceCount() == MAX_VOICES) return VoiceHandle();
+    ISound* playing = engine->play3D(sources[sound], toIrrKlang(position), loop, true, true);
+    if (playing) playing->setMinDistance(minDistance);
+    VoiceHandle handle = claimVoice(playing, loop, volume, speed, smoothingSeconds);
+    if (Voice* voice = voiceFor(handle)) {
+        voice->positional = true;
+        voice->position = position;
+    }
+    return handle;
+}
+
+VoiceHandle SoundManager::claimVoice(ISound* sound, bool loop, float volume, float speed, float smoothingSeconds) {
+    VoiceHandle handle;
+    if (!sound) return handle;
+    auto free = std::find_if(voices.begin(), voices.end(), [](const Voice& voice) { return voice.sound == nullptr; });
+    sound->setVolume(volume);
+    sound->setPlaybackSpeed(speed);
+    // a silent voice stays paused until update() finds it a volume
+    sound->setIsPaused(volume <= 0.0f);
+
+    free->sound = sound;
+    free->loop = loop;
+    free->paused = volume <= 0.0f;
+    free->positional = false;
+    free->moved = false;
+    free->position = free->velocity = glm::vec3(0.0f);
+    free->volume = free->targetVolume = free->appliedVolume = volume;
+    free->speed = free->targetSpeed = free->appliedSpeed = speed;
+    free->smoothingSeconds = smoothingSeconds;
+    handle.slot = static_cast<uint32_t>(free - voices.begin());
+    handle.generation = free->generation;
+    return handle;
+}
+
+bool SoundManager::isVoiceValid(VoiceHandle handle) const {
+    if (handle.slot >= voices.size()) return false;
+    const Voice& voice = voices[handle.slot];
+    return voice.sound && voice.generation == handle.generation;
+}
+
+SoundManager::Voice* SoundManager::voiceFor(VoiceHandle handle) {
+    return isVoiceValid(handle) ? &voices[handle.slot] : nullptr;
+}
+
+void SoundManager::setVoiceTarget(VoiceHandle handle, float volume, float speed) {
+    if (Voice* voice = voiceFor(handle)) {
+        voice->targetVolume = volume;
+        voice->targetSpeed = speed;
+    }
+}
+
+void SoundManager::setVoicePosition(VoiceHandle handle, const glm::vec3& position, const glm::vec3& velocity) {
+    if (Voice* voice = voiceFor(handle)) {
+        voice->position = position;
+        voice->velocity = velocity;
+        voice->moved = true;
+    }
+}
+
+float SoundManager::voiceVolume(VoiceHandle handle) const {
+    return isVoiceValid(handle) ? voices[handle.slot].volume : 0.0f;
+}
+
+void SoundManager::setListener(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up, const glm::vec3& velocity) {
+    engine->setListenerPosition(toIrrKlang(position), toIrrKlang(forward), toIrrKlang(velocity), toIrrKlang(up));
+}
+
+void SoundManager::setDopplerParameters(float dopplerFactor, float distanceFactor) {
+    engine->setDopplerEffectParameters(dopplerFactor, distanceFactor);
+}
+
+void SoundManager::stopVoice(VoiceHandle handle) {
+    if (Voice* voice = voiceFor(handle)) releaseVoice(*voice);
+}
+
+void SoundManager::releaseVoice(Voice& voice) {
+    voice.sound->stop();
+    voice.sound->drop();
+    voice.sound = nullptr;
+    voice.generation++;
+}
+
+int SoundManager::activeVoiceCount() const {
+    return static_cast<int>(std::count_if(voices.begin(), voices.end(), [](const Voice& voice) { return voice.sound != nullptr; }));
+}
+
+// pushes a smoothed value once it moved far enough from the one irrKlang has, or settled on its target
+static bool needsApply(float value, float target, float applied) {
+    return std::abs(value - applied) >= VOICE_EPSILON || (value == target && applied != target);
+}
+
+void SoundManager::update(float deltaTime) {
+    for (Voice& voice : voices) {
+        if (!voice.sound) continue;
+        if (!voice.loop && voice.sound->isFinished()) {
+            releaseVoice(voice);
+            continue;
+        }
+
+        // exponential approach, the same feel at any frame rate
+        float blend = voice.smoothingSeconds > 0.0f ? 1.0f - std::exp(-deltaTime / voice.smoothingSeconds) : 1.0f;
+        voice.volume += (voice.targetVolume - voice.volume) * blend;
+        voice.speed += (voice.targetSpeed - voice.speed) * blend;
+        if (std::abs(voice.volume - voice.targetVolume) < VOICE_EPSILON) voice.volume = voice.targetVolume;
+        if (std::abs(voice.speed - voice.targetSpeed) < VOICE_EPSILON) voice.speed = voice.targetSpeed;
+
+        if (voice.positional && voice.moved) {
+            voice.sound->setPosition(toIrrKlang(voice.position));
+            voice.sound->setVelocity(toIrrKlang(voice.velocity));
+            voice.moved = false;
+        }
+
+        bool silent = voice.volume <= 0.0f;
+        if (silent != voice.paused) {
+            voice.sound->setIsPaused(silent);
+            voice.paused = silent;
+        }
+        if (silent) continue;
+
+        if (needsApply(voice.volume, voice.targetVolume, voice.appliedVolume)) {
+            voice.sound->setVolume(voice.volume);
+            voice.appliedVolume = voice.volume;
+        }
+        if (needsApply(voice.speed, voice.targetSpeed, voice.appliedSpeed)) {
+            voice.sound->setPlaybackSpeed(voice.speed);
+            voice.appliedSpeed = voice.speed;
+        }
+    }
+}
@@ -1,16 +1,48 @@
 #pragma once
 #include <irrKlang/irrKlang.h>
+#include <glm/glm.hpp>
+#include <cstdint>
 #include <unordered_map>
 #include <string>
+#include <vector>
+
+#include "AssetLoader.h"
 
 using namespace irrklang;
 
+// index of a preloaded sound, looked up once by name when the game starts
+typedef int SoundId;
+const SoundId INVALID_SOUND = -1;
+
+enum class SoundLoad {
+    Memory,   // decoded into memory up front, for short effects that must start without delay
+    Stream    // decoded from the file while it plays through a small buffer, for music and other long tracks
+};
+
+// Refers to one voice slot. The generation tells a handle to a voice that has since been stopped and
+// reused apart from the current one, calls through a stale handle do nothing.
+struct VoiceHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
 class SoundManager {
 public:
+    // voice slots reserved up front, startVoice() never allocates
+    static const int MAX_VOICES = 32;
+
     SoundManager();
     ~SoundManager();
 
-    void preloadSound(const std::string& name, const std::string& filepath);
+    SoundId preloadSound(const std::string& name, const std::string& filepath, SoundLoad load = SoundLoad::Memory);
+    // Reads the file on a loader worker and hands the bytes to irrKlang in the main thread stage, so startup
+    // does not wait for the disk. The id is valid straight away, the sound plays once it has arrived and
+    // anything started before that is silently skipped.
+    SoundId preloadSoundAsync(const std::string& name, const std::string& filepath, AssetLoader& assetLoader);
+    SoundId findSound(const std::string& name) const;
+    bool isLoaded(SoundId sound) const;
+
+    // by name, for the few sounds started and changed outside the frame loop (music)
     void playSound(const std::string& name, bool loop = false);
     void pauseSound(const std::string& name);
     void stopSound(const std::string& name);
@@ -18,8 +50,58 @@ public:
     void setVolume(const std::string& name, float volume);
     void setPlaybackSpeed(const std::string& name, float speed);
 
+    // Per frame sounds go through voices. Setting a target only stores it, update() moves every voice
+    // towards its targets, smoothed over smoothingSeconds, and talks to irrKlang once for all of them.
+    // A looping voice whose volume reaches zero is paused and resumes where it was, it is never restarted.
+    // Returns an invalid handle when every slot is taken.
+    VoiceHandle startVoice(SoundId sound, bool loop, float volume, float speed = 1.0f, float smoothingSeconds = 0.15f);
+    // positional voice, full volume up to minDistance and falling off with the distance beyond it
+    VoiceHandle startVoice3D(SoundId sound, bool loop, const glm::vec3& position, float minDistance, float volume,
+        float speed = 1.0f, float smoothingSeconds = 0.15f);
+    void setVoiceTarget(VoiceHandle voice, float volume, float speed);
+    // positions are not smoothed, velocity (units per second) only feeds the Doppler shift
+    void setVoicePosition(VoiceHandle voice, const glm::vec3& position, const glm::vec3& velocity);
+    // the smoothed volume the voice plays at, 0 for a stale handle
+    float voiceVolume(VoiceHandle voice) const;
+    void stopVoice(VoiceHandle voice);
+    bool isVoiceValid(VoiceHandle voice) const;
+    int activeVoiceCount() const;
+
+    // the ears the 3D voices are heard from, usually the camera
+    void setListener(const glm::vec3& position, const glm::vec3& forward, const glm::vec3& up, const glm::vec3& velocity);
+    void setDopplerParameters(float dopplerFactor, float distanceFactor);
+
+    // once per frame, after the targets were set
+    void update(float deltaTime);
+
 private:
+    struct Voice {
+        ISound* sound = nullptr;    // null while the slot is free
+        uint32_t generation = 0;
+        bool loop = false;
+        bool paused = false;
+        bool positional = false;
+        bool moved = false;         // position or velocity changed since the last update
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::vec3 velocity = glm::vec3(0.0f);
+        float volume = 0.0f;        // smoothed towards the targets every update
+        float speed = 1.0f;
+        float appliedVolume = 0.0f; // last values handed to irrKlang
+        float appliedSpeed = 1.0f;
+        float targetVolume = 0.0f;
+        float targetSpeed = 1.0f;
+        float smoothingSeconds = 0.0f;
+    };
+
+    Voice* voiceFor(VoiceHandle handle);
+    // takes a free slot for a sound irrKlang started paused
+    VoiceHandle claimVoice(ISound* sound, bool loop, float volume, float speed, float smoothingSeconds);
+    void releaseVoice(Voice& voice);
+    void reportMemory(SoundId sound) const;
+
     ISoundEngine* engine;
-    std::unordered_map<std::string, ISoundSource*> soundSources; 
-    std::unordered_map<std::string, ISound*> activeSounds; 
+    std::vector<ISoundSource*> sources;     // null while an async load is in flight
+    std::unordered_map<std::string, SoundId> soundIds;
+    std::unordered_map<std::string, ISound*> activeSounds;
+    std::vector<Voice> voices;
 };
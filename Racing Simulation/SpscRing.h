@@ -0,0 +1,55 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded single producer, single consumer queue without locks. One thread may only push and one other
+// thread may only pop; each side owns one index and reads the other's with acquire ordering.
+// The capacity is rounded up to a power of two so the indices wrap with a mask.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) rounded <<= 1;
+        slots.resize(rounded);
+        mask = rounded - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // producer thread, returns false instead of waiting when the ring is full
+    bool push(const T& value) {
+        size_t writeIndex = head.load(std::memory_order_relaxed);
+        if (writeIndex - tail.load(std::memory_order_acquire) == slots.size()) return false;
+        slots[writeIndex & mask] = value;
+        head.store(writeIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer thread, returns false when there is nothing to take
+    bool pop(T& value) {
+        size_t readIndex = tail.load(std::memory_order_relaxed);
+        if (readIndex == head.load(std::memory_order_acquire)) return false;
+        value = slots[readIndex & mask];
+        tail.store(readIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return slots.size(); }
+
+private:
+    std::vector<T> slots;
+    size_t mask = 0;
+    // the two indices sit on separate cache lines so the threads do not fight over one
+    char padBefore[64];
+    std::atomic<size_t> head{ 0 };     // next slot to write, only the producer stores
+    char padBetween[64];
+    std::atomic<size_t> tail{ 0 };     // next slot to read, only the consumer stores
+    char padAfter[64];
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "TelemetryFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const char* const COLUMN_NAMES[TELEMETRY_COLUMN_COUNT] = {
+    "tick", "x", "y", "z", "speed", "steering", "pitch", "roll", "airborne", "contacts",
+    "heightFL", "heightFR", "heightBL", "heightBR", "corrections"
+};
+
+// millimetres for positions and heights, thousandths for speed and angles in degrees, finer for radians
+static const double COLUMN_STEPS[TELEMETRY_COLUMN_COUNT] = {
+    1.0, 0.001, 0.001, 0.001, 0.001, 0.001, 0.0001, 0.0001, 1.0, 1.0,
+    0.001, 0.001, 0.001, 0.001, 1.0
+};
+
+const char* telemetryColumnName(int column) {
+    return COLUMN_NAMES[column];
+}
+
+int telemetryColumnFromName(const std::string& name) {
+    for (int column = 0; column < TELEMETRY_COLUMN_COUNT; ++column) {
+        if (name == COLUMN_NAMES[column]) return column;
+    }
+    return -1;
+}
+
+double telemetryColumnStep(int column) {
+    return COLUMN_STEPS[column];
+}
+
+static int64_t quantize(double value, int column) {
+    return static_cast<int64_t>(std::llround(value / COLUMN_STEPS[column]));
+}
+
+int64_t quantizeTelemetry(const TelemetrySample& sample, int column) {
+    switch (column) {
+    case TELEMETRY_TICK: return sample.tick;
+    case TELEMETRY_POSITION_X: return quantize(sample.position.x, column);
+    case TELEMETRY_POSITION_Y: return quantize(sample.position.y, column);
+    case TELEMETRY_POSITION_Z: return quantize(sample.position.z, column);
+    case TELEMETRY_SPEED: return quantize(sample.speed, column);
+    case TELEMETRY_STEERING: return quantize(sample.steeringAngle, column);
+    case TELEMETRY_PITCH: return quantize(sample.pitch, column);
+    case TELEMETRY_ROLL: return quantize(sample.roll, column);
+    case TELEMETRY_AIRBORNE: return sample.airborne ? 1 : 0;
+    case TELEMETRY_WHEEL_CONTACTS: return sample.wheelContacts;
+    case TELEMETRY_WHEEL_HEIGHT_FL: return quantize(sample.wheelHeights[0], column);
+    case TELEMETRY_WHEEL_HEIGHT_FR: return quantize(sample.wheelHeights[1], column);
+    case TELEMETRY_WHEEL_HEIGHT_BL: return quantize(sample.wheelHeights[2], column);
+    case TELEMETRY_WHEEL_HEIGHT_BR: return quantize(sample.wheelHeights[3], column);
+    case TELEMETRY_CORRECTIONS: return sample.corrections;
+    }
+    return 0;
+}
+
+static void writeVarint(uint64_t value, std::vector<char>& out) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+// small negative deltas become small unsigned values
+static uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void encodeTelemetryBlock(const std::vector<TelemetrySample>& samples, std::vector<char>& out) {
+    TelemetryBlockHeader header;
+    header.sampleCount = static_cast<uint32_t>(samples.size());
+
+    size_t headerOffset = out.size();
+    out.resize(out.size() + sizeof(header));
+
+    for (int column = 0; column < TELEMETRY_COLUMN_COUNT; ++column) {
+        size_t columnStart = out.size();
+        int64_t previous = 0;
+        int64_t minValue = INT64_MAX, maxValue = INT64_MIN;
+        for (const TelemetrySample& sample : samples) {
+            int64_t value = quantizeTelemetry(sample, column);
+            writeVarint(zigzag(value - previous), out);
+            previous = value;
+            minValue = std::min(minValue, value);
+            maxValue = std::max(maxValue, value);
+        }
+        header.columnBytes[column] = static_cast<uint32_t>(out.size() - columnStart);
+        header.minValue[column] = samples.empty() ? 0 : minValue;
+        header.maxValue[column] = samples.empty() ? 0 : maxValue;
+    }
+    std::memcpy(out.data() + headerOffset, &header, sizeof(header));
+}
+
+bool decodeTelemetryColumn(const char* data, size_t size, uint32_t sampleCount, std::vector<int64_t>& values) {
+    values.resize(sampleCount);
+    const unsigned char* cursor = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = cursor + size;
+    int64_t previous = 0;
+    for (uint32_t i = 0; i < sampleCount; ++i) {
+        uint64_t encoded = 0;
+        int shift = 0;
+        while (true) {
+            if (cursor == end || shift > 63) return false;
+            unsigned char byte = *cursor++;
+            encoded |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+            shift += 7;
+        }
+        previous += unzigzag(encoded);
+        values[i] = previous;
+    }
+    return true;
+}
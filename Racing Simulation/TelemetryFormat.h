@@ -0,0 +1,78 @@
+#ifndef TELEMETRY_FORMAT_H
+#define TELEMETRY_FORMAT_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// car state of one simulation tick
+struct TelemetrySample {
+    uint32_t tick = 0;
+    glm::vec3 position = glm::vec3(0.0f);
+    float speed = 0.0f;
+    float steeringAngle = 0.0f;     // degrees
+    float pitch = 0.0f;             // radians
+    float roll = 0.0f;
+    bool airborne = false;
+    uint8_t wheelContacts = 0;      // bit per wheel, front left, front right, back left, back right
+    float wheelHeights[4] = {};     // ground height under each wheel ray, same order
+    uint16_t corrections = 0;       // side collision push backs during the tick
+};
+
+enum TelemetryColumn {
+    TELEMETRY_TICK,
+    TELEMETRY_POSITION_X,
+    TELEMETRY_POSITION_Y,
+    TELEMETRY_POSITION_Z,
+    TELEMETRY_SPEED,
+    TELEMETRY_STEERING,
+    TELEMETRY_PITCH,
+    TELEMETRY_ROLL,
+    TELEMETRY_AIRBORNE,
+    TELEMETRY_WHEEL_CONTACTS,
+    TELEMETRY_WHEEL_HEIGHT_FL,
+    TELEMETRY_WHEEL_HEIGHT_FR,
+    TELEMETRY_WHEEL_HEIGHT_BL,
+    TELEMETRY_WHEEL_HEIGHT_BR,
+    TELEMETRY_CORRECTIONS,
+    TELEMETRY_COLUMN_COUNT
+};
+
+// Telemetry files are a header followed by blocks of up to TELEMETRY_BLOCK_SAMPLES samples.
+// Inside a block every column is stored on its own: each value is quantized to an integer with the column's
+// step, then written as the zigzag varint of its difference to the previous value. Car state changes little
+// from one tick to the next so most values take one or two bytes. A block header keeps the byte size and the
+// min and max of every column, so a reader decodes only the columns it needs and skips blocks a filter rules out.
+const uint32_t TELEMETRY_VERSION = 1;
+const char TELEMETRY_MAGIC[4] = { 'R', 'S', 'T', 'L' };
+const uint32_t TELEMETRY_BLOCK_SAMPLES = 4096;
+
+struct TelemetryFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t columnCount;
+};
+
+struct TelemetryBlockHeader {
+    uint32_t sampleCount;
+    uint32_t columnBytes[TELEMETRY_COLUMN_COUNT];
+    int64_t minValue[TELEMETRY_COLUMN_COUNT];       // quantized
+    int64_t maxValue[TELEMETRY_COLUMN_COUNT];
+};
+
+const char* telemetryColumnName(int column);
+// -1 for an unknown name
+int telemetryColumnFromName(const std::string& name);
+// size of one quantization step, value = quantized * step
+double telemetryColumnStep(int column);
+
+int64_t quantizeTelemetry(const TelemetrySample& sample, int column);
+
+// appends the header and columns of one block
+void encodeTelemetryBlock(const std::vector<TelemetrySample>& samples, std::vector<char>& out);
+// decodes one column of a block back to quantized values, false if the data runs out
+bool decodeTelemetryColumn(const char* data, size_t size, uint32_t sampleCount, std::vector<int64_t>& values);
+
+#endif
@@ -0,0 +1,127 @@
+#include "TelemetryReader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+bool TelemetryReader::open(const std::string& path) {
+    blocks.clear();
+    if (!file.open(path)) {
+        std::cout << "Failed to open telemetry file " << path << std::endl;
+        return false;
+    }
+
+    TelemetryFileHeader header;
+    if (file.size() < sizeof(header)) return false;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (!std::equal(TELEMETRY_MAGIC, TELEMETRY_MAGIC + 4, header.magic) || header.version != TELEMETRY_VERSION ||
+        header.columnCount != TELEMETRY_COLUMN_COUNT) {
+        std::cout << "Not a telemetry file of this version: " << path << std::endl;
+        return false;
+    }
+
+    size_t offset = sizeof(header);
+    while (offset + sizeof(TelemetryBlockHeader) <= file.size()) {
+        Block block;
+        std::memcpy(&block.header, file.data() + offset, sizeof(block.header));
+        offset += sizeof(block.header);
+        for (int column = 0; column < TELEMETRY_COLUMN_COUNT; ++column) {
+            block.columnOffsets[column] = offset;
+            offset += block.header.columnBytes[column];
+        }
+        // a session that did not stop cleanly can end in a partial block
+        if (offset > file.size()) break;
+        blocks.push_back(block);
+    }
+    return true;
+}
+
+bool TelemetryReader::readColumn(size_t block, int column, std::vector<int64_t>& values) const {
+    const Block& entry = blocks[block];
+    return decodeTelemetryColumn(file.data() + entry.columnOffsets[column], entry.header.columnBytes[column],
+        entry.header.sampleCount, values);
+}
+
+bool TelemetryReader::query(const std::vector<TelemetryFilter>& filters, TelemetryColumnStats (&stats)[TELEMETRY_COLUMN_COUNT],
+    uint64_t& blocksSkipped) const {
+    blocksSkipped = 0;
+    std::vector<int64_t> columns[TELEMETRY_COLUMN_COUNT];
+    std::vector<bool> keep;
+
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const TelemetryBlockHeader& header = blocks[b].header;
+
+        // compare in quantized units, a block whose range misses a filter has no sample to offer
+        bool skip = false;
+        for (const TelemetryFilter& filter : filters) {
+            double step = telemetryColumnStep(filter.column);
+            if (header.maxValue[filter.column] * step < filter.minValue || header.minValue[filter.column] * step > filter.maxValue) {
+                skip = true;
+            }
+        }
+        if (skip) {
+            blocksSkipped++;
+            continue;
+        }
+
+        for (int column = 0; column < TELEMETRY_COLUMN_COUNT; ++column) {
+            if (!readColumn(b, column, columns[column])) return false;
+        }
+
+        keep.assign(header.sampleCount, true);
+        for (const TelemetryFilter& filter : filters) {
+            double step = telemetryColumnStep(filter.column);
+            const std::vector<int64_t>& values = columns[filter.column];
+            for (uint32_t i = 0; i < header.sampleCount; ++i) {
+                double value = values[i] * step;
+                if (value < filter.minValue || value > filter.maxValue) keep[i] = false;
+            }
+        }
+
+        for (int column = 0; column < TELEMETRY_COLUMN_COUNT; ++column) {
+            double step = telemetryColumnStep(column);
+            TelemetryColumnStats& columnStats = stats[column];
+            for (uint32_t i = 0; i < header.sampleCount; ++i) {
+                if (!keep[i]) continue;
+                double value = columns[column][i] * step;
+                if (columnStats.count == 0) {
+                    columnStats.minValue = value;
+                    columnStats.maxValue = value;
+                }
+                columnStats.minValue = std::min(columnStats.minValue, value);
+                columnStats.maxValue = std::max(columnStats.maxValue, value);
+                columnStats.sum += value;
+                columnStats.count++;
+            }
+        }
+    }
+    return true;
+}
+
+int runTelemetryQuery(const std::string& path, const std::vector<TelemetryFilter>& filters) {
+    auto start = std::chrono::steady_clock::now();
+    TelemetryReader reader;
+    if (!reader.open(path)) return 1;
+
+    TelemetryColumnStats stats[TELEMETRY_COLUMN_COUNT];
+    uint64_t blocksSkipped = 0;
+    if (!reader.query(filters, stats, blocksSkipped)) {
+        std::cout << "Corrupt telemetry block in " << path << std::endl;
+        return 1;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << path << ": " << reader.blockCount() << " blocks, " << blocksSkipped << " skipped by the filters, "
+              << stats[TELEMETRY_TICK].count << " samples match, " << ms << " ms" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::left << std::setw(14) << "column" << std::setw(14) << "min" << std::setw(14) << "max" << std::setw(14) << "mean" << "sum" << std::endl;
+    for (int column = 0; column < TELEMETRY_COLUMN_COUNT; ++column) {
+        const TelemetryColumnStats& columnStats = stats[column];
+        double mean = columnStats.count ? columnStats.sum / columnStats.count : 0.0;
+        std::cout << std::setw(14) << telemetryColumnName(column) << std::setw(14) << columnStats.minValue << std::setw(14)
+                  << columnStats.maxValue << std::setw(14) << mean << columnStats.sum << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef TELEMETRY_READER_H
+#define TELEMETRY_READER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "TelemetryFormat.h"
+
+// keeps samples whose column lies within [minValue, maxValue]
+struct TelemetryFilter {
+    int column;
+    double minValue;
+    double maxValue;
+};
+
+struct TelemetryColumnStats {
+    uint64_t count = 0;
+    double minValue = 0.0;
+    double maxValue = 0.0;
+    double sum = 0.0;
+};
+
+// Reads a telemetry file through a memory mapping. Opening only walks the block headers and a column is
+// decoded on request from its own bytes, so pulling one column out of hours of samples reads little else.
+class TelemetryReader {
+public:
+    bool open(const std::string& path);
+
+    size_t blockCount() const { return blocks.size(); }
+    const TelemetryBlockHeader& blockHeader(size_t block) const { return blocks[block].header; }
+
+    // quantized values, multiply by telemetryColumnStep() for the real ones
+    bool readColumn(size_t block, int column, std::vector<int64_t>& values) const;
+
+    // stats of every column over the samples that pass all filters, blocks the headers rule out are skipped
+    bool query(const std::vector<TelemetryFilter>& filters, TelemetryColumnStats (&stats)[TELEMETRY_COLUMN_COUNT],
+        uint64_t& blocksSkipped) const;
+
+private:
+    struct Block {
+        TelemetryBlockHeader header;
+        size_t columnOffsets[TELEMETRY_COLUMN_COUNT];
+    };
+
+    MappedFile file;
+    std::vector<Block> blocks;
+};
+
+// --telemetry-query: prints the stats of a file, filtered by "--where <column> <min> <max>" options
+int runTelemetryQuery(const std::string& path, const std::vector<TelemetryFilter>& filters);
+
+#endif
@@ -0,0 +1,87 @@
+#include "TelemetryRecorder.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// about a minute at 60 ticks per second, far more than the writer ever lags
+const size_t TELEMETRY_RING_SAMPLES = 1 << 12;
+const int TELEMETRY_WRITER_SLEEP_MS = 20;
+
+TelemetryRecorder::TelemetryRecorder() : ring(TELEMETRY_RING_SAMPLES) {}
+
+TelemetryRecorder::~TelemetryRecorder() {
+    stop();
+}
+
+bool TelemetryRecorder::start(const std::string& path) {
+    if (recording) return true;
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "Failed to open telemetry file " << path << std::endl;
+        return false;
+    }
+    TelemetryFileHeader header;
+    std::copy(TELEMETRY_MAGIC, TELEMETRY_MAGIC + 4, header.magic);
+    header.version = TELEMETRY_VERSION;
+    header.columnCount = TELEMETRY_COLUMN_COUNT;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    dropped = 0;
+    running = true;
+    recording = true;
+    writer = std::thread(&TelemetryRecorder::writerLoop, this);
+    std::cout << "Recording telemetry to " << path << std::endl;
+    return true;
+}
+
+void TelemetryRecorder::stop() {
+    if (!recording) return;
+    running = false;
+    writer.join();
+    file.close();
+    recording = false;
+    if (droppedSamples() > 0) {
+        std::cout << "Telemetry dropped " << droppedSamples() << " samples" << std::endl;
+    }
+}
+
+void TelemetryRecorder::record(const TelemetrySample& sample) {
+    if (!recording) return;
+    if (!ring.push(sample)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TelemetryRecorder::writerLoop() {
+    Profiler::setThreadName("Telemetry writer");
+    std::vector<TelemetrySample> block;
+    block.reserve(TELEMETRY_BLOCK_SAMPLES);
+
+    while (true) {
+        // read the flag before draining, so samples pushed before stop() are always picked up
+        bool keepRunning = running.load();
+        TelemetrySample sample;
+        bool gotAny = false;
+        while (ring.pop(sample)) {
+            gotAny = true;
+            block.push_back(sample);
+            if (block.size() == TELEMETRY_BLOCK_SAMPLES) writeBlock(block);
+        }
+        if (!keepRunning) break;
+        if (!gotAny) std::this_thread::sleep_for(std::chrono::milliseconds(TELEMETRY_WRITER_SLEEP_MS));
+    }
+    writeBlock(block);
+    file.flush();
+}
+
+void TelemetryRecorder::writeBlock(std::vector<TelemetrySample>& block) {
+    if (block.empty()) return;
+    PROFILE_ZONE("Telemetry block write");
+    encoded.clear();
+    encodeTelemetryBlock(block, encoded);
+    file.write(encoded.data(), encoded.size());
+    block.clear();
+}
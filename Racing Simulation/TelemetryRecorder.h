@@ -0,0 +1,47 @@
+#ifndef TELEMETRY_RECORDER_H
+#define TELEMETRY_RECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SpscRing.h"
+#include "TelemetryFormat.h"
+
+// Records car state every simulation tick into a telemetry file, see TelemetryFormat.h.
+// The simulation thread only copies each sample into a lock-free ring and never waits. A writer thread
+// empties the ring, encodes full blocks and writes them, so a session of any length costs the loop the same.
+// If the writer falls a whole ring behind, new samples are dropped and counted rather than blocking the frame.
+class TelemetryRecorder {
+public:
+    TelemetryRecorder();
+    ~TelemetryRecorder();
+
+    bool start(const std::string& path);
+    // writes whatever is still queued and closes the file
+    void stop();
+    bool isRecording() const { return recording; }
+
+    // simulation thread only
+    void record(const TelemetrySample& sample);
+
+    uint64_t droppedSamples() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    void writerLoop();
+    void writeBlock(std::vector<TelemetrySample>& block);
+
+    SpscRing<TelemetrySample> ring;
+    std::thread writer;
+    std::atomic<bool> running{ false };
+    std::atomic<uint64_t> dropped{ 0 };
+    bool recording = false;
+
+    std::ofstream file;
+    std::vector<char> encoded;
+};
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef TEXT_RENDERER_H
+#define TEXT_RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+#include "shader_m.h"
+
+// FreeType glyphs drawn as textured quads with the text shader, in screen pixels from the bottom left
+void initTextRendering(const std::string& fontPath);
+void RenderText(Shader& shader, std::string text, float x, float y, float scale, glm::vec3 color);
+// solid rectangles (x, y, width, height) through the same shader, all in one draw call
+void RenderRects(Shader& shader, const std::vector<glm::vec4>& rects, glm::vec3 color);
+
+#endif
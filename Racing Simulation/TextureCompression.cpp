@@ -0,0 +1,572 @@
+#include "TextureCompression.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+static std::atomic<bool> s3tcSupported(false);
+static std::atomic<bool> bptcSupported(false);
+
+bool isBlockCompressed(TextureFormat format) {
+    return format != TextureFormat::R8 && format != TextureFormat::RGB8 && format != TextureFormat::RGBA8;
+}
+
+size_t textureFormatUnitSize(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::R8: return 1;
+    case TextureFormat::RGB8: return 3;
+    case TextureFormat::RGBA8: return 4;
+    case TextureFormat::BC1:
+    case TextureFormat::BC4: return 8;
+    default: return 16;
+    }
+}
+
+size_t textureLevelSize(TextureFormat format, int width, int height) {
+    if (!isBlockCompressed(format)) {
+        return static_cast<size_t>(width) * height * textureFormatUnitSize(format);
+    }
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * textureFormatUnitSize(format);
+}
+
+const char* textureFormatName(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::R8: return "R8";
+    case TextureFormat::RGB8: return "RGB8";
+    case TextureFormat::RGBA8: return "RGBA8";
+    case TextureFormat::BC1: return "BC1";
+    case TextureFormat::BC3: return "BC3";
+    case TextureFormat::BC4: return "BC4";
+    case TextureFormat::BC5: return "BC5";
+    case TextureFormat::BC7: return "BC7";
+    }
+    return "?";
+}
+
+TextureFormat textureFormatForUsage(TextureUsage usage, bool hasAlpha) {
+    switch (usage) {
+    case TextureUsage::Albedo: return hasAlpha ? TextureFormat::BC3 : TextureFormat::BC1;
+    case TextureUsage::Normal: return TextureFormat::BC5;
+    case TextureUsage::Mask: return TextureFormat::BC4;
+    case TextureUsage::Sky: return TextureFormat::BC7;
+    default: return hasAlpha ? TextureFormat::RGBA8 : TextureFormat::RGB8;
+    }
+}
+
+bool textureUsageHasMips(TextureUsage usage) {
+    return usage != TextureUsage::Sky;
+}
+
+// ---------------------------------------------------------------------------------------------
+// mip chain
+
+static void downsample(const std::vector<unsigned char>& source, int width, int height, int channels, bool normalMap,
+    std::vector<unsigned char>& target, int& targetWidth, int& targetHeight) {
+    targetWidth = std::max(1, width / 2);
+    targetHeight = std::max(1, height / 2);
+    target.resize(static_cast<size_t>(targetWidth) * targetHeight * channels);
+
+    for (int y = 0; y < targetHeight; ++y) {
+        // odd sizes clamp to the last row and column
+        int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+        for (int x = 0; x < targetWidth; ++x) {
+            int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+            unsigned char* out = &target[(static_cast<size_t>(y) * targetWidth + x) * channels];
+            for (int c = 0; c < channels; ++c) {
+                unsigned int sum = source[(static_cast<size_t>(y0) * width + x0) * channels + c] +
+                    source[(static_cast<size_t>(y0) * width + x1) * channels + c] +
+                    source[(static_cast<size_t>(y1) * width + x0) * channels + c] +
+                    source[(static_cast<size_t>(y1) * width + x1) * channels + c];
+                out[c] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+
+            // averaged normals get shorter, push them back onto the unit sphere
+            if (normalMap && channels >= 3) {
+                float n[3];
+                for (int c = 0; c < 3; ++c) n[c] = out[c] / 127.5f - 1.0f;
+                float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                if (length > 1e-4f) {
+                    for (int c = 0; c < 3; ++c)
+                        out[c] = static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, (n[c] / length + 1.0f) * 127.5f + 0.5f)));
+                }
+            }
+        }
+    }
+}
+
+static void expandToRGBA(const std::vector<unsigned char>& source, int pixelCount, int channels, std::vector<unsigned char>& rgba) {
+    rgba.resize(static_cast<size_t>(pixelCount) * 4);
+    for (int i = 0; i < pixelCount; ++i) {
+        const unsigned char* in = &source[static_cast<size_t>(i) * channels];
+        unsigned char* out = &rgba[static_cast<size_t>(i) * 4];
+        if (channels == 1) {
+            out[0] = out[1] = out[2] = in[0];
+            out[3] = 255;
+        }
+        else if (channels == 2) {
+            out[0] = out[1] = out[2] = in[0];
+            out[3] = in[1];
+        }
+        else {
+            out[0] = in[0];
+            out[1] = in[1];
+            out[2] = in[2];
+            out[3] = channels == 4 ? in[3] : 255;
+        }
+    }
+}
+
+void buildMipChain(const unsigned char* pixels, int width, int height, int channels, TextureFormat format,
+    bool normalMap, TextureImage& image, bool mipmaps) {
+    image.format = format;
+    image.data.clear();
+    image.levels.clear();
+
+    std::vector<unsigned char> level(pixels, pixels + static_cast<size_t>(width) * height * channels);
+    std::vector<unsigned char> next, rgba, blocks;
+    while (true) {
+        TextureLevel entry;
+        entry.width = width;
+        entry.height = height;
+        entry.offset = image.data.size();
+
+        if (isBlockCompressed(format)) {
+            const unsigned char* source = level.data();
+            if (channels != 4) {
+                expandToRGBA(level, width * height, channels, rgba);
+                source = rgba.data();
+            }
+            compressLevel(format, source, width, height, blocks);
+            image.data.insert(image.data.end(), blocks.begin(), blocks.end());
+        }
+        else {
+            image.data.insert(image.data.end(), level.begin(), level.end());
+        }
+        entry.size = image.data.size() - entry.offset;
+        image.levels.push_back(entry);
+
+        if (!mipmaps || (width == 1 && height == 1)) break;
+        int nextWidth, nextHeight;
+        downsample(level, width, height, channels, normalMap, next, nextWidth, nextHeight);
+        level.swap(next);
+        width = nextWidth;
+        height = nextHeight;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+// block encoders
+
+// gathers one 4x4 block, edge blocks repeat the last row and column
+static void fetchBlock(const unsigned char* rgba, int width, int height, int bx, int by, unsigned char block[16][4]) {
+    for (int y = 0; y < 4; ++y) {
+        int sy = std::min(by * 4 + y, height - 1);
+        for (int x = 0; x < 4; ++x) {
+            int sx = std::min(bx * 4 + x, width - 1);
+            std::memcpy(block[y * 4 + x], &rgba[(static_cast<size_t>(sy) * width + sx) * 4], 4);
+        }
+    }
+}
+
+// principal axis of the block colors, found with a few power iterations on the covariance matrix
+static void principalEndpoints(const unsigned char block[16][4], int channels, float low[4], float high[4]) {
+    float mean[4] = { 0, 0, 0, 0 };
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < channels; ++c) mean[c] += block[i][c] / 16.0f;
+
+    float covariance[4][4] = {};
+    for (int i = 0; i < 16; ++i)
+        for (int a = 0; a < channels; ++a)
+            for (int b = 0; b < channels; ++b)
+                covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+
+    float axis[4] = { 1, 1, 1, 1 };
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = { 0, 0, 0, 0 };
+        for (int a = 0; a < channels; ++a)
+            for (int b = 0; b < channels; ++b) next[a] += covariance[a][b] * axis[b];
+        float length = 0.0f;
+        for (int c = 0; c < channels; ++c) length += next[c] * next[c];
+        length = std::sqrt(length);
+        if (length < 1e-6f) break;
+        for (int c = 0; c < channels; ++c) axis[c] = next[c] / length;
+    }
+
+    float minProjection = 1e30f, maxProjection = -1e30f;
+    for (int i = 0; i < 16; ++i) {
+        float projection = 0.0f;
+        for (int c = 0; c < channels; ++c) projection += (block[i][c] - mean[c]) * axis[c];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+    for (int c = 0; c < 4; ++c) {
+        float a = c < channels ? axis[c] : 0.0f;
+        low[c] = std::min(255.0f, std::max(0.0f, mean[c] + a * minProjection));
+        high[c] = std::min(255.0f, std::max(0.0f, mean[c] + a * maxProjection));
+    }
+}
+
+static int colorDistance(const unsigned char* a, const int* b, int channels) {
+    int distance = 0;
+    for (int c = 0; c < channels; ++c) {
+        int d = a[c] - b[c];
+        distance += d * d;
+    }
+    return distance;
+}
+
+static uint16_t packRGB565(const float color[3]) {
+    int r = static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f);
+    int g = static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f);
+    int b = static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f);
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static void unpackRGB565(uint16_t packed, int color[3]) {
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+static void encodeBC1Block(const unsigned char block[16][4], unsigned char* out) {
+    float low[4], high[4];
+    principalEndpoints(block, 3, low, high);
+    uint16_t color0 = packRGB565(high), color1 = packRGB565(low);
+    // four color mode needs color0 > color1
+    if (color0 < color1) std::swap(color0, color1);
+
+    uint32_t indices = 0;
+    if (color0 != color1) {
+        int palette[4][3];
+        unpackRGB565(color0, palette[0]);
+        unpackRGB565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, bestDistance = colorDistance(block[i], palette[0], 3);
+            for (int p = 1; p < 4; ++p) {
+                int distance = colorDistance(block[i], palette[p], 3);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint32_t>(best) << (2 * i);
+        }
+    }
+
+    out[0] = color0 & 0xFF;
+    out[1] = color0 >> 8;
+    out[2] = color1 & 0xFF;
+    out[3] = color1 >> 8;
+    for (int b = 0; b < 4; ++b) out[4 + b] = (indices >> (8 * b)) & 0xFF;
+}
+
+// one channel of the block, endpoints at the extremes and six interpolated values between them
+static void encodeBC4Block(const unsigned char block[16][4], int channel, unsigned char* out) {
+    int high = 0, low = 255;
+    for (int i = 0; i < 16; ++i) {
+        high = std::max(high, static_cast<int>(block[i][channel]));
+        low = std::min(low, static_cast<int>(block[i][channel]));
+    }
+
+    uint64_t indices = 0;
+    if (high != low) {
+        int palette[8] = { high, low };
+        for (int p = 1; p < 7; ++p) palette[p + 1] = ((7 - p) * high + p * low) / 7;
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, bestDistance = 256;
+            for (int p = 0; p < 8; ++p) {
+                int distance = std::abs(block[i][channel] - palette[p]);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint64_t>(best) << (3 * i);
+        }
+    }
+
+    out[0] = static_cast<unsigned char>(high);
+    out[1] = static_cast<unsigned char>(low);
+    for (int b = 0; b < 6; ++b) out[2 + b] = (indices >> (8 * b)) & 0xFF;
+}
+
+// writes bits least significant first, as the BC7 layout is specified
+struct BitWriter {
+    unsigned char* out;
+    int position = 0;
+
+    void write(uint32_t value, int bits) {
+        for (int i = 0; i < bits; ++i, ++position) {
+            if (value & (1u << i)) out[position >> 3] |= static_cast<unsigned char>(1 << (position & 7));
+        }
+    }
+};
+
+struct BitReader {
+    const unsigned char* in;
+    int position = 0;
+
+    uint32_t read(int bits) {
+        uint32_t value = 0;
+        for (int i = 0; i < bits; ++i, ++position) {
+            if (in[position >> 3] & (1 << (position & 7))) value |= 1u << i;
+        }
+        return value;
+    }
+};
+
+static const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// 7 bit endpoint plus a shared low bit, picks the p-bit that lands closer to the wanted color
+static void quantizeBC7Endpoint(const float color[4], int quantized[4], int& pbit) {
+    int bestError = -1;
+    for (int p = 0; p < 2; ++p) {
+        int candidate[4], error = 0;
+        for (int c = 0; c < 4; ++c) {
+            candidate[c] = std::min(127, std::max(0, static_cast<int>(std::floor((color[c] - p) / 2.0f + 0.5f))));
+            int expanded = (candidate[c] << 1) | p;
+            error += std::abs(expanded - static_cast<int>(color[c] + 0.5f));
+        }
+        if (bestError < 0 || error < bestError) {
+            bestError = error;
+            pbit = p;
+            std::copy(candidate, candidate + 4, quantized);
+        }
+    }
+}
+
+// mode 6: one subset, RGBA 7.7.7.7 endpoints with a p-bit each, 4 bit indices
+static void encodeBC7Block(const unsigned char block[16][4], unsigned char* out) {
+    float low[4], high[4];
+    principalEndpoints(block, 4, low, high);
+
+    int endpoint[2][4], pbit[2];
+    quantizeBC7Endpoint(low, endpoint[0], pbit[0]);
+    quantizeBC7Endpoint(high, endpoint[1], pbit[1]);
+
+    int expanded[2][4];
+    for (int e = 0; e < 2; ++e)
+        for (int c = 0; c < 4; ++c) expanded[e][c] = (endpoint[e][c] << 1) | pbit[e];
+
+    int palette[16][4];
+    for (int p = 0; p < 16; ++p)
+        for (int c = 0; c < 4; ++c)
+            palette[p][c] = ((64 - BC7_WEIGHTS4[p]) * expanded[0][c] + BC7_WEIGHTS4[p] * expanded[1][c] + 32) >> 6;
+
+    int indices[16];
+    for (int i = 0; i < 16; ++i) {
+        int best = 0, bestDistance = colorDistance(block[i], palette[0], 4);
+        for (int p = 1; p < 16; ++p) {
+            int distance = colorDistance(block[i], palette[p], 4);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = p;
+            }
+        }
+        indices[i] = best;
+    }
+
+    // the first index is stored with its top bit implied zero, swap the endpoints if it is set
+    if (indices[0] & 8) {
+        for (int c = 0; c < 4; ++c) std::swap(endpoint[0][c], endpoint[1][c]);
+        std::swap(pbit[0], pbit[1]);
+        for (int i = 0; i < 16; ++i) indices[i] = 15 - indices[i];
+    }
+
+    std::memset(out, 0, 16);
+    BitWriter writer{ out };
+    writer.write(1 << 6, 7);
+    for (int c = 0; c < 4; ++c) {
+        writer.write(endpoint[0][c], 7);
+        writer.write(endpoint[1][c], 7);
+    }
+    writer.write(pbit[0], 1);
+    writer.write(pbit[1], 1);
+    writer.write(indices[0], 3);
+    for (int i = 1; i < 16; ++i) writer.write(indices[i], 4);
+}
+
+void compressLevel(TextureFormat format, const unsigned char* rgba, int width, int height, std::vector<unsigned char>& blocks) {
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    size_t blockSize = textureFormatUnitSize(format);
+    blocks.assign(static_cast<size_t>(blocksX) * blocksY * blockSize, 0);
+
+    unsigned char block[16][4];
+    for (int by = 0; by < blocksY; ++by) {
+        for (int bx = 0; bx < blocksX; ++bx) {
+            fetchBlock(rgba, width, height, bx, by, block);
+            unsigned char* out = &blocks[(static_cast<size_t>(by) * blocksX + bx) * blockSize];
+            switch (format) {
+            case TextureFormat::BC1:
+                encodeBC1Block(block, out);
+                break;
+            case TextureFormat::BC3:
+                encodeBC4Block(block, 3, out);
+                encodeBC1Block(block, out + 8);
+                break;
+            case TextureFormat::BC4:
+                encodeBC4Block(block, 0, out);
+                break;
+            case TextureFormat::BC5:
+                encodeBC4Block(block, 0, out);
+                encodeBC4Block(block, 1, out + 8);
+                break;
+            case TextureFormat::BC7:
+                encodeBC7Block(block, out);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+// block decoders, only needed when the driver lacks S3TC or BPTC
+
+static void decodeBC1Block(const unsigned char* in, bool forceFourColors, unsigned char block[16][4]) {
+    uint16_t color0 = static_cast<uint16_t>(in[0] | (in[1] << 8));
+    uint16_t color1 = static_cast<uint16_t>(in[2] | (in[3] << 8));
+    int palette[4][4];
+    unpackRGB565(color0, palette[0]);
+    unpackRGB565(color1, palette[1]);
+    palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+    for (int c = 0; c < 3; ++c) {
+        if (color0 > color1 || forceFourColors) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    if (color0 <= color1 && !forceFourColors) palette[3][3] = 0;
+
+    uint32_t indices = in[4] | (in[5] << 8) | (in[6] << 16) | (static_cast<uint32_t>(in[7]) << 24);
+    for (int i = 0; i < 16; ++i) {
+        int index = (indices >> (2 * i)) & 3;
+        for (int c = 0; c < 4; ++c) block[i][c] = static_cast<unsigned char>(palette[index][c]);
+    }
+}
+
+static void decodeBC4Block(const unsigned char* in, int channel, unsigned char block[16][4]) {
+    int palette[8] = { in[0], in[1] };
+    if (palette[0] > palette[1]) {
+        for (int p = 1; p < 7; ++p) palette[p + 1] = ((7 - p) * palette[0] + p * palette[1]) / 7;
+    }
+    else {
+        for (int p = 1; p < 5; ++p) palette[p + 1] = ((5 - p) * palette[0] + p * palette[1]) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int b = 0; b < 6; ++b) indices |= static_cast<uint64_t>(in[2 + b]) << (8 * b);
+    for (int i = 0; i < 16; ++i) {
+        block[i][channel] = static_cast<unsigned char>(palette[(indices >> (3 * i)) & 7]);
+    }
+}
+
+static void decodeBC7Block(const unsigned char* in, unsigned char block[16][4]) {
+    BitReader reader{ in };
+    if (reader.read(7) != (1 << 6)) {
+        // not mode 6, the cooker never writes other modes
+        std::memset(block, 0, 16 * 4);
+        return;
+    }
+    int endpoint[2][4];
+    for (int c = 0; c < 4; ++c) {
+        endpoint[0][c] = reader.read(7) << 1;
+        endpoint[1][c] = reader.read(7) << 1;
+    }
+    int pbit0 = reader.read(1), pbit1 = reader.read(1);
+    for (int c = 0; c < 4; ++c) {
+        endpoint[0][c] |= pbit0;
+        endpoint[1][c] |= pbit1;
+    }
+    for (int i = 0; i < 16; ++i) {
+        int weight = BC7_WEIGHTS4[reader.read(i == 0 ? 3 : 4)];
+        for (int c = 0; c < 4; ++c)
+            block[i][c] = static_cast<unsigned char>(((64 - weight) * endpoint[0][c] + weight * endpoint[1][c] + 32) >> 6);
+    }
+}
+
+void decompressLevel(TextureFormat format, const unsigned char* blocks, int width, int height, std::vector<unsigned char>& rgba) {
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    size_t blockSize = textureFormatUnitSize(format);
+    rgba.resize(static_cast<size_t>(width) * height * 4);
+
+    unsigned char block[16][4];
+    for (int by = 0; by < blocksY; ++by) {
+        for (int bx = 0; bx < blocksX; ++bx) {
+            const unsigned char* in = &blocks[(static_cast<size_t>(by) * blocksX + bx) * blockSize];
+            switch (format) {
+            case TextureFormat::BC1:
+                decodeBC1Block(in, false, block);
+                break;
+            case TextureFormat::BC3:
+                decodeBC1Block(in + 8, true, block);
+                decodeBC4Block(in, 3, block);
+                break;
+            case TextureFormat::BC4:
+                decodeBC4Block(in, 0, block);
+                for (int i = 0; i < 16; ++i) {
+                    block[i][1] = block[i][2] = 0;
+                    block[i][3] = 255;
+                }
+                break;
+            case TextureFormat::BC5:
+                decodeBC4Block(in, 0, block);
+                decodeBC4Block(in + 8, 1, block);
+                for (int i = 0; i < 16; ++i) {
+                    block[i][2] = 0;
+                    block[i][3] = 255;
+                }
+                break;
+            case TextureFormat::BC7:
+                decodeBC7Block(in, block);
+                break;
+            default:
+                std::memset(block, 0, sizeof(block));
+                break;
+            }
+
+            for (int y = 0; y < 4 && by * 4 + y < height; ++y)
+                for (int x = 0; x < 4 && bx * 4 + x < width; ++x)
+                    std::memcpy(&rgba[(static_cast<size_t>(by * 4 + y) * width + bx * 4 + x) * 4], block[y * 4 + x], 4);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+
+void detectTextureFormatSupport() {
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; ++i) {
+        std::string extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension == "GL_EXT_texture_compression_s3tc") s3tcSupported = true;
+        if (extension == "GL_ARB_texture_compression_bptc") bptcSupported = true;
+    }
+    // BPTC is core from 4.2 on
+    if (GLAD_GL_VERSION_4_2) bptcSupported = true;
+}
+
+bool isTextureFormatSupported(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::BC1:
+    case TextureFormat::BC3: return s3tcSupported;
+    case TextureFormat::BC7: return bptcSupported;
+    default: return true;  // RGTC (BC4/BC5) is core since 3.0
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef TEXTURE_COMPRESSION_H
+#define TEXTURE_COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Pixel layout of a texture payload. The BC formats store 4x4 texel blocks.
+enum class TextureFormat : uint32_t {
+    R8,
+    RGB8,
+    RGBA8,
+    BC1,   // RGB, 8 bytes per block
+    BC3,   // RGBA, BC1 color plus a BC4 alpha block
+    BC4,   // single channel
+    BC5,   // two channels, used for tangent space normals
+    BC7    // RGBA, mode 6 only
+};
+
+// What a texture is sampled for, decides the format it is cooked to
+enum class TextureUsage : uint32_t {
+    Color,    // UI and anything unclassified, kept uncompressed
+    Albedo,   // BC1, or BC3 when the image has alpha
+    Normal,   // BC5, z is rebuilt in the shader
+    Mask,     // metallic, roughness, ao: BC4 of the red channel
+    Sky       // BC7, smooth gradients band badly in BC1. Level 0 only, the sky is never minified
+};
+
+struct TextureLevel {
+    int width = 0;
+    int height = 0;
+    size_t offset = 0;   // into TextureImage::data
+    size_t size = 0;
+};
+
+// A texture with its whole mip chain, either decoded from a source image or read from a cooked file
+struct TextureImage {
+    TextureFormat format = TextureFormat::RGBA8;
+    std::vector<unsigned char> data;    // every level back to back
+    std::vector<TextureLevel> levels;   // level 0 is the full size image
+
+    bool empty() const { return levels.empty(); }
+    int width() const { return levels.empty() ? 0 : levels[0].width; }
+    int height() const { return levels.empty() ? 0 : levels[0].height; }
+    const unsigned char* levelData(size_t level) const { return data.data() + levels[level].offset; }
+};
+
+bool isBlockCompressed(TextureFormat format);
+// bytes per 4x4 block for BC formats, per pixel otherwise
+size_t textureFormatUnitSize(TextureFormat format);
+size_t textureLevelSize(TextureFormat format, int width, int height);
+const char* textureFormatName(TextureFormat format);
+TextureFormat textureFormatForUsage(TextureUsage usage, bool hasAlpha);
+bool textureUsageHasMips(TextureUsage usage);
+
+// Appends the whole mip chain of an 8 bit image with the given channel count, each level a 2x2 box filter
+// of the one above. Normal maps are renormalized after filtering. mipmaps = false keeps only level 0.
+void buildMipChain(const unsigned char* pixels, int width, int height, int channels, TextureFormat format,
+    bool normalMap, TextureImage& image, bool mipmaps = true);
+
+// Compresses an RGBA8 level into format (one of the BC formats)
+void compressLevel(TextureFormat format, const unsigned char* rgba, int width, int height, std::vector<unsigned char>& blocks);
+
+// Expands a BC level back to RGBA8, the fallback when the driver cannot sample the format
+void decompressLevel(TextureFormat format, const unsigned char* blocks, int width, int height, std::vector<unsigned char>& rgba);
+
+// Which BC formats the current GL context can sample. Queried once on the GL thread, read from any thread.
+void detectTextureFormatSupport();
+bool isTextureFormatSupported(TextureFormat format);
+
+#endif
@@ -0,0 +1,204 @@
+#include "TextureCooker.h"
+#include "FileUtils.h"
+#include "MappedFile.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Bump whenever the file layout, the encoders or the mip filter change
+const uint32_t TEXTURE_CACHE_VERSION = 2;
+const char TEXTURE_CACHE_MAGIC[4] = { 'R', 'T', 'E', 'X' };
+const uint64_t TEXTURE_CACHE_ALIGNMENT = 16;
+
+struct TextureCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceSize;
+    uint64_t sourceTime;
+    uint32_t format;      // TextureFormat
+    uint32_t usage;       // TextureUsage it was cooked for
+    uint32_t levelCount;
+    uint32_t reserved;
+};
+
+// followed by levelCount of these, level 0 first, then the level data
+struct TextureCacheLevel {
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;
+    uint64_t size;
+};
+
+TextureCooker::TextureCooker(const std::string& cacheDirectory) : cacheDirectory(cacheDirectory) {}
+
+std::string TextureCooker::cachePathFor(const std::string& sourcePath) const {
+    return cacheDirectory + "/" + flattenPath(sourcePath) + ".rtex";
+}
+
+bool TextureCooker::cook(const std::string& sourcePath, TextureUsage usage) const {
+    uint64_t sourceSize, sourceTime;
+    if (!fileStamp(sourcePath, sourceSize, sourceTime)) {
+        std::cout << "Texture to cook not found: " << sourcePath << std::endl;
+        return false;
+    }
+    if (!ensureDirectory(cacheDirectory)) {
+        std::cout << "Failed to create texture cache directory: " << cacheDirectory << std::endl;
+        return false;
+    }
+
+    // always decode to RGBA, the encoders work on 4 channel blocks
+    int width, height, components;
+    unsigned char* pixels = stbi_load(sourcePath.c_str(), &width, &height, &components, 4);
+    if (!pixels) {
+        std::cout << "Failed to decode texture: " << sourcePath << std::endl;
+        return false;
+    }
+
+    bool hasAlpha = false;
+    for (size_t i = 0; i < static_cast<size_t>(width) * height && !hasAlpha; ++i)
+        hasAlpha = pixels[i * 4 + 3] < 255;
+
+    TextureFormat format = textureFormatForUsage(usage, hasAlpha);
+    TextureImage image;
+    if (isBlockCompressed(format)) {
+        buildMipChain(pixels, width, height, 4, format, usage == TextureUsage::Normal, image, textureUsageHasMips(usage));
+    }
+    else {
+        // uncompressed keeps only the channels it needs
+        int channels = format == TextureFormat::RGBA8 ? 4 : 3;
+        std::vector<unsigned char> packed(static_cast<size_t>(width) * height * channels);
+        for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i)
+            std::memcpy(&packed[i * channels], &pixels[i * 4], channels);
+        buildMipChain(packed.data(), width, height, channels, format, false, image, textureUsageHasMips(usage));
+    }
+    stbi_image_free(pixels);
+
+    TextureCacheHeader header = {};
+    std::copy(TEXTURE_CACHE_MAGIC, TEXTURE_CACHE_MAGIC + 4, header.magic);
+    header.version = TEXTURE_CACHE_VERSION;
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+    header.format = static_cast<uint32_t>(format);
+    header.usage = static_cast<uint32_t>(usage);
+    header.levelCount = static_cast<uint32_t>(image.levels.size());
+
+    uint64_t dataOffset = sizeof(header) + image.levels.size() * sizeof(TextureCacheLevel);
+    dataOffset = (dataOffset + TEXTURE_CACHE_ALIGNMENT - 1) & ~(TEXTURE_CACHE_ALIGNMENT - 1);
+    std::vector<TextureCacheLevel> levels(image.levels.size());
+    for (size_t l = 0; l < image.levels.size(); ++l) {
+        levels[l].width = static_cast<uint32_t>(image.levels[l].width);
+        levels[l].height = static_cast<uint32_t>(image.levels[l].height);
+        levels[l].offset = dataOffset + image.levels[l].offset;
+        levels[l].size = image.levels[l].size;
+    }
+
+    std::ofstream file(cachePathFor(sourcePath), std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(levels.data()), levels.size() * sizeof(TextureCacheLevel));
+    static const char zeros[TEXTURE_CACHE_ALIGNMENT] = {};
+    file.write(zeros, dataOffset - sizeof(header) - levels.size() * sizeof(TextureCacheLevel));
+    file.write(reinterpret_cast<const char*>(image.data.data()), image.data.size());
+    if (!file) {
+        std::cout << "Failed to write cooked texture for " << sourcePath << std::endl;
+        return false;
+    }
+
+    size_t uncompressed = 0;
+    for (const TextureLevel& level : image.levels) uncompressed += static_cast<size_t>(level.width) * level.height * 4;
+    std::cout << "Cooked " << sourcePath << ": " << textureFormatName(format) << " " << width << "x" << height
+        << ", " << image.levels.size() << " levels, " << image.data.size() / 1024 << " KB (RGBA8 "
+        << uncompressed / 1024 << " KB)" << std::endl;
+    return true;
+}
+
+bool TextureCooker::load(const std::string& sourcePath, TextureUsage usage, TextureImage& image) const {
+    uint64_t sourceSize, sourceTime;
+    if (!fileStamp(sourcePath, sourceSize, sourceTime)) return false;
+
+    MappedFile file;
+    if (!file.open(cachePathFor(sourcePath))) return false;
+    const char* data = file.data();
+    size_t fileSize = file.size();
+    if (fileSize < sizeof(TextureCacheHeader)) return false;
+
+    TextureCacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (!std::equal(TEXTURE_CACHE_MAGIC, TEXTURE_CACHE_MAGIC + 4, header.magic) || header.version != TEXTURE_CACHE_VERSION ||
+        header.sourceSize != sourceSize || header.sourceTime != sourceTime || header.usage != static_cast<uint32_t>(usage) ||
+        header.format > static_cast<uint32_t>(TextureFormat::BC7)) {
+        std::cout << "Cooked texture stale for " << sourcePath << ", run with --cook-textures" << std::endl;
+        return false;
+    }
+    if (static_cast<uint64_t>(header.levelCount) * sizeof(TextureCacheLevel) > fileSize - sizeof(header)) return false;
+
+    image.format = static_cast<TextureFormat>(header.format);
+    image.levels.resize(header.levelCount);
+    image.data.clear();
+    for (uint32_t l = 0; l < header.levelCount; ++l) {
+        TextureCacheLevel record;
+        std::memcpy(&record, data + sizeof(header) + l * sizeof(TextureCacheLevel), sizeof(record));
+        if (record.offset > fileSize || record.size > fileSize - record.offset ||
+            record.size != textureLevelSize(image.format, record.width, record.height)) {
+            image.levels.clear();
+            return false;
+        }
+        TextureLevel& level = image.levels[l];
+        level.width = static_cast<int>(record.width);
+        level.height = static_cast<int>(record.height);
+        level.offset = image.data.size();
+        level.size = static_cast<size_t>(record.size);
+        image.data.insert(image.data.end(), data + record.offset, data + record.offset + record.size);
+    }
+    return true;
+}
+
+// BC payload the driver cannot sample, expand every level to RGBA8
+static void decompressImage(TextureImage& image) {
+    TextureImage expanded;
+    expanded.format = TextureFormat::RGBA8;
+    std::vector<unsigned char> rgba;
+    for (size_t l = 0; l < image.levels.size(); ++l) {
+        const TextureLevel& level = image.levels[l];
+        decompressLevel(image.format, image.levelData(l), level.width, level.height, rgba);
+        TextureLevel entry = level;
+        entry.offset = expanded.data.size();
+        entry.size = rgba.size();
+        expanded.data.insert(expanded.data.end(), rgba.begin(), rgba.end());
+        expanded.levels.push_back(entry);
+    }
+    image = std::move(expanded);
+}
+
+TextureImage loadTextureImage(const std::string& filename, TextureUsage usage) {
+    TextureImage image;
+    TextureCooker cooker(TEXTURE_CACHE_DIRECTORY);
+    if (cooker.load(filename, usage, image)) {
+        if (!isTextureFormatSupported(image.format)) decompressImage(image);
+        return image;
+    }
+
+    int width, height, components;
+    unsigned char* pixels = stbi_load(filename.c_str(), &width, &height, &components, 0);
+    if (!pixels) return image;
+
+    TextureFormat format = components == 1 ? TextureFormat::R8 : components == 3 ? TextureFormat::RGB8 : TextureFormat::RGBA8;
+    if (components == 2) {
+        // grey + alpha, widen so it has a GL format of its own
+        std::vector<unsigned char> rgba(static_cast<size_t>(width) * height * 4);
+        for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i) {
+            rgba[i * 4] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = pixels[i * 2];
+            rgba[i * 4 + 3] = pixels[i * 2 + 1];
+        }
+        buildMipChain(rgba.data(), width, height, 4, format, false, image, textureUsageHasMips(usage));
+    }
+    else {
+        buildMipChain(pixels, width, height, components, format, usage == TextureUsage::Normal, image, textureUsageHasMips(usage));
+    }
+    stbi_image_free(pixels);
+    return image;
+}
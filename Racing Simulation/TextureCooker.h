@@ -0,0 +1,36 @@
+#ifndef TEXTURE_COOKER_H
+#define TEXTURE_COOKER_H
+
+#include "TextureCompression.h"
+
+#include <string>
+
+// Directory the cooked textures are written to, shared with the model and IBL caches
+const char* const TEXTURE_CACHE_DIRECTORY = "Cache";
+
+// Cooked textures: the whole mip chain (level 0 alone for the sky), block compressed for the usage, stored
+// as Cache/<path>.rtex.
+// Cooking is done offline with --cook-textures. A cooked file is used only while the size and
+// modification time of its source image match the stamp, otherwise the source is decoded at runtime.
+class TextureCooker {
+public:
+    TextureCooker(const std::string& cacheDirectory);
+
+    // Decodes sourcePath, builds and compresses its mip chain and writes the cooked file
+    bool cook(const std::string& sourcePath, TextureUsage usage) const;
+
+    // Reads the cooked file, returns false when it is missing, stale or cooked for another usage
+    bool load(const std::string& sourcePath, TextureUsage usage, TextureImage& image) const;
+
+private:
+    std::string cachePathFor(const std::string& sourcePath) const;
+
+    std::string cacheDirectory;
+};
+
+// Runtime entry point, safe on worker threads: the cooked file when there is one, otherwise the source
+// image decoded with stb_image and mipmapped on the CPU, uncompressed. BC payloads the driver cannot
+// sample are expanded to RGBA8 here.
+TextureImage loadTextureImage(const std::string& filename, TextureUsage usage);
+
+#endif
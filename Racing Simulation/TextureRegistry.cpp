@@ -0,0 +1,117 @@
+#include "TextureRegistry.h"
+#include "FileUtils.h"
+#include "MemoryAccounting.h"
+
+static MemoryCategory memoryCategoryFor(const TextureKey& key) {
+    return key.target == GL_TEXTURE_CUBE_MAP ? MemoryCategory::Cubemaps : MemoryCategory::Textures;
+}
+
+TextureRegistry& TextureRegistry::get() {
+    static TextureRegistry registry;
+    return registry;
+}
+
+uint64_t TextureRegistry::contentHash(const std::string& path) {
+    uint64_t size = 0, modifiedTime = 0;
+    if (!fileStamp(path, size, modifiedTime)) return hashString(path);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = hashedFiles.find(path);
+        if (found != hashedFiles.end() && found->second.size == size && found->second.modifiedTime == modifiedTime)
+            return found->second.hash;
+    }
+
+    // hashed outside the lock, two threads hashing the same new file just do the work twice
+    uint64_t hash = hashFile(path);
+    if (hash == 0) return hashString(path);
+    std::lock_guard<std::mutex> lock(mutex);
+    hashedFiles[path] = { size, modifiedTime, hash };
+    return hash;
+}
+
+TextureKey TextureRegistry::makeKey(const std::string& path, TextureUsage usage, GLenum target, GLenum wrap) {
+    return makeKey(contentHash(path), usage, target, wrap);
+}
+
+TextureKey TextureRegistry::makeKey(uint64_t contentHash, TextureUsage usage, GLenum target, GLenum wrap) {
+    TextureKey key;
+    key.contentHash = contentHash;
+    key.usage = static_cast<uint32_t>(usage);
+    key.target = target;
+    key.wrap = wrap;
+    return key;
+}
+
+bool TextureRegistry::claim(const TextureKey& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // emplace only inserts for the first caller
+    auto inserted = entries.emplace(key, Entry());
+    Entry& entry = inserted.first->second;
+    entry.references++;
+    if (inserted.second) return true;
+    if (!entry.abandoned) return false;
+    entry.abandoned = false;
+    return true;
+}
+
+unsigned int TextureRegistry::acquire(const TextureKey& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = entries.find(key);
+    // only claimed keys have a texture
+    if (found == entries.end()) return 0;
+    if (found->second.texture == 0) glGenTextures(1, &found->second.texture);
+    return found->second.texture;
+}
+
+void TextureRegistry::finishUpload(const TextureKey& key, const std::string& name, size_t gpuBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = entries.find(key);
+    if (found == entries.end()) return;
+    found->second.uploaded = true;
+    // map values keep their address until erased, so the entry itself identifies the texture
+    MemoryAccounting::get().set(&found->second, memoryCategoryFor(key), name, 0, gpuBytes);
+}
+
+bool TextureRegistry::adopt(const TextureKey& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = entries.find(key);
+    if (found == entries.end() || !found->second.abandoned) return false;
+    found->second.abandoned = false;
+    return true;
+}
+
+void TextureRegistry::abandon(const TextureKey& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = entries.find(key);
+    if (found == entries.end()) return;
+    if (!found->second.uploaded) found->second.abandoned = true;
+    dropReference(found);
+}
+
+void TextureRegistry::release(const TextureKey& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = entries.find(key);
+    if (found == entries.end()) return;
+    dropReference(found);
+}
+
+void TextureRegistry::dropReference(EntryMap::iterator found) {
+    if (found->second.references == 0 || --found->second.references > 0) return;
+    if (found->second.texture != 0) {
+        if (textureStreamer) textureStreamer->cancel(found->second.texture);
+        glDeleteTextures(1, &found->second.texture);
+    }
+    MemoryAccounting::get().remove(&found->second, memoryCategoryFor(found->first));
+    entries.erase(found);
+}
+
+size_t TextureRegistry::textureCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+void TextureRegistry::setTextureStreamer(TextureStreamer* streamer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    textureStreamer = streamer;
+}
@@ -0,0 +1,94 @@
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <glad/glad.h>
+
+#include "TextureCompression.h"
+#include "TextureStreamer.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Identifies a texture by what it holds rather than where it came from: the hash of the source file bytes,
+// plus the parameters that make two textures of the same file differ on the GPU
+struct TextureKey {
+    uint64_t contentHash = 0;
+    uint32_t usage = 0;   // TextureUsage, decides the cooked format
+    uint32_t target = 0;  // GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+    uint32_t wrap = 0;
+
+    bool operator==(const TextureKey& other) const {
+        return contentHash == other.contentHash && usage == other.usage && target == other.target && wrap == other.wrap;
+    }
+};
+
+struct TextureKeyHash {
+    size_t operator()(const TextureKey& key) const {
+        return static_cast<size_t>(key.contentHash ^ (static_cast<uint64_t>(key.usage) << 40) ^
+            (static_cast<uint64_t>(key.target) << 20) ^ key.wrap);
+    }
+};
+
+// Process-wide table of every texture the game has loaded, so a file used by several models, the UI or
+// the skybox is decoded and uploaded once. Loading happens in steps to fit AssetLoader:
+//   claim()        on any thread, counts a reference and returns true for exactly one caller per key, the
+//                  owner, which decodes the pixels
+//   acquire()      on the GL thread, hands out the texture name, created on first use
+//   finishUpload() the owner has handed the pixels to GL
+// Every claim is given back with release(), which deletes the texture with the last reference. An owner that
+// goes away before its upload calls abandon() instead, the entry stays for the other claimers and the next
+// one to claim() or adopt() the key uploads in its place.
+class TextureRegistry {
+public:
+    static TextureRegistry& get();
+
+    // Hash of the file contents, remembered per path while the file's size and modification time stay the same.
+    // An unreadable file hashes its path instead, so two missing files do not end up as one texture.
+    uint64_t contentHash(const std::string& path);
+    TextureKey makeKey(const std::string& path, TextureUsage usage, GLenum target = GL_TEXTURE_2D, GLenum wrap = GL_REPEAT);
+    // for textures built from several files, such as the six faces of a cubemap
+    TextureKey makeKey(uint64_t contentHash, TextureUsage usage, GLenum target, GLenum wrap);
+
+    bool claim(const TextureKey& key);
+    unsigned int acquire(const TextureKey& key);
+    // gpuBytes is forwarded to the MemoryAccounting until the last release
+    void finishUpload(const TextureKey& key, const std::string& name, size_t gpuBytes);
+    // for a claimer that is not the owner, true when the owner abandoned the key and this caller now uploads
+    bool adopt(const TextureKey& key);
+    void abandon(const TextureKey& key);
+    void release(const TextureKey& key);
+
+    size_t textureCount() const;
+
+    // textures still streaming in are cancelled there before they are deleted, null to detach
+    void setTextureStreamer(TextureStreamer* streamer);
+
+private:
+    TextureRegistry() = default;
+
+    struct Entry {
+        unsigned int texture = 0;   // GL name, 0 until the first acquire
+        unsigned int references = 0;
+        bool uploaded = false;
+        bool abandoned = false;     // the owner left before uploading, waiting for another claimer to take over
+    };
+
+    typedef std::unordered_map<TextureKey, Entry, TextureKeyHash> EntryMap;
+    // expects the lock held
+    void dropReference(EntryMap::iterator found);
+
+    struct HashedFile {
+        uint64_t size;
+        uint64_t modifiedTime;
+        uint64_t hash;
+    };
+
+    mutable std::mutex mutex;
+    EntryMap entries;
+    TextureStreamer* textureStreamer = nullptr;
+    std::unordered_map<std::string, HashedFile> hashedFiles;
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "TextureStreamer.h"
+#include "Profiler.h"
+#include "MemoryAccounting.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// S3TC is an extension, glad only carries the core enums
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+void textureFormatToGL(TextureFormat format, GLenum& internalFormat, GLenum& pixelFormat) {
+    pixelFormat = 0;
+    switch (format) {
+    case TextureFormat::R8: internalFormat = GL_R8; pixelFormat = GL_RED; break;
+    case TextureFormat::RGB8: internalFormat = GL_RGB8; pixelFormat = GL_RGB; break;
+    case TextureFormat::RGBA8: internalFormat = GL_RGBA8; pixelFormat = GL_RGBA; break;
+    case TextureFormat::BC1: internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; break;
+    case TextureFormat::BC3: internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+    case TextureFormat::BC4: internalFormat = GL_COMPRESSED_RED_RGTC1; break;
+    case TextureFormat::BC5: internalFormat = GL_COMPRESSED_RG_RGTC2; break;
+    case TextureFormat::BC7: internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM; break;
+    }
+}
+
+size_t textureGpuBytes(const TextureImage& image, size_t levelCount) {
+    if (image.empty()) return 0;
+    levelCount = std::min(levelCount, image.levels.size());
+    if (isBlockCompressed(image.format)) {
+        size_t bytes = 0;
+        for (size_t l = 0; l < levelCount; ++l)
+            bytes += textureLevelSize(image.format, image.levels[l].width, image.levels[l].height);
+        return bytes;
+    }
+    // uncompressed levels are stored padded, see gpuTextureBytes
+    GLenum internalFormat, pixelFormat;
+    textureFormatToGL(image.format, internalFormat, pixelFormat);
+    return gpuTextureBytes(internalFormat, image.width(), image.height(), static_cast<int>(levelCount));
+}
+
+// defines a level, pixels may be null to only allocate it
+static void defineLevel(GLenum target, int level, TextureFormat format, int width, int height, const void* pixels) {
+    GLenum internalFormat, pixelFormat;
+    textureFormatToGL(format, internalFormat, pixelFormat);
+    if (pixelFormat) {
+        glTexImage2D(target, level, internalFormat, width, height, 0, pixelFormat, GL_UNSIGNED_BYTE, pixels);
+    }
+    else {
+        glCompressedTexImage2D(target, level, internalFormat, width, height, 0,
+            static_cast<GLsizei>(textureLevelSize(format, width, height)), pixels);
+    }
+}
+
+void uploadTextureLevel(GLenum target, int level, const TextureImage& image, size_t levelIndex) {
+    const TextureLevel& entry = image.levels[levelIndex];
+    // rows are tightly packed, the caller's alignment is put back afterwards
+    GLint alignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    defineLevel(target, level, image.format, entry.width, entry.height, image.levelData(levelIndex));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+}
+
+static void setSamplerParameters(GLenum wrap) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+void uploadTextureImmediately(unsigned int texture, const TextureImage& image, GLenum wrap) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    setSamplerParameters(wrap);
+    for (size_t l = 0; l < image.levels.size(); ++l) {
+        uploadTextureLevel(GL_TEXTURE_2D, static_cast<int>(l), image, l);
+    }
+    if (!image.empty()) glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levels.size()) - 1);
+}
+
+TextureStreamer::TextureStreamer(size_t slotBytes, unsigned int slotCount) : slots(slotCount), slotBytes(slotBytes) {
+    detectTextureFormatSupport();
+    for (Slot& slot : slots) {
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, slotBytes, nullptr, GL_STREAM_DRAW);
+        slot.capacity = slotBytes;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    reportMemory();
+}
+
+TextureStreamer::~TextureStreamer() {
+    MemoryAccounting::get().remove(this, MemoryCategory::Staging);
+    for (Slot& slot : slots) {
+        if (slot.fence) glDeleteSync(slot.fence);
+        glDeleteBuffers(1, &slot.buffer);
+    }
+}
+
+void TextureStreamer::stream(unsigned int texture, TextureImage& image, GLenum wrap) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    setSamplerParameters(wrap);
+    if (image.empty()) return;
+
+    // the first level small enough to go up right away, every level from there on is uploaded now
+    int levelCount = static_cast<int>(image.levels.size());
+    int placeholder = 0;
+    while (placeholder < levelCount - 1 &&
+        std::max(image.levels[placeholder].width, image.levels[placeholder].height) > TEXTURE_PLACEHOLDER_SIZE) {
+        ++placeholder;
+    }
+
+    for (int level = 0; level < levelCount; ++level) {
+        if (level < placeholder) {
+            defineLevel(GL_TEXTURE_2D, level, image.format, image.levels[level].width, image.levels[level].height, nullptr);
+        }
+        else {
+            uploadTextureLevel(GL_TEXTURE_2D, level, image, level);
+        }
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, placeholder);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+
+    if (placeholder > 0) {
+        uploads.push_back({ texture, std::move(image), placeholder - 1, 0 });
+        reportMemory();
+    }
+    image = TextureImage();
+}
+
+void TextureStreamer::update(size_t budgetBytes) {
+    if (uploads.empty()) return;
+    PROFILE_ZONE("Texture streaming");
+
+    GLint alignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    size_t copied = 0;
+    while (!uploads.empty() && copied < budgetBytes) {
+        Slot& slot = slots[nextSlot];
+        if (slot.fence) {
+            // the GPU is still reading this buffer, try again next frame instead of waiting
+            if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED) break;
+            glDeleteSync(slot.fence);
+            slot.fence = 0;
+        }
+
+        Upload& upload = uploads.front();
+        const TextureLevel& level = upload.image.levels[upload.level];
+        bool compressed = isBlockCompressed(upload.image.format);
+
+        // a strip is whole rows of pixels, or of 4x4 blocks for compressed levels
+        int rowHeight = compressed ? 4 : 1;
+        size_t rowBytes = textureLevelSize(upload.image.format, level.width, rowHeight);
+        int rowsLeft = (level.height - upload.nextRow + rowHeight - 1) / rowHeight;
+        int rows = std::min(rowsLeft, std::max(1, static_cast<int>(slotBytes / rowBytes)));
+        int stripHeight = std::min(rows * rowHeight, level.height - upload.nextRow);
+        size_t size = rowBytes * rows;
+        size_t sourceOffset = rowBytes * (upload.nextRow / rowHeight);
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        if (size > slot.capacity) {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+            slot.capacity = size;
+        }
+        void* target = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!target) {
+            std::cout << "TextureStreamer: failed to map upload buffer" << std::endl;
+            break;
+        }
+        std::memcpy(target, upload.image.levelData(upload.level) + sourceOffset, size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        // sources from the bound buffer, returns without waiting for the transfer
+        GLenum internalFormat, pixelFormat;
+        textureFormatToGL(upload.image.format, internalFormat, pixelFormat);
+        glBindTexture(GL_TEXTURE_2D, upload.texture);
+        if (compressed) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, upload.level, 0, upload.nextRow, level.width, stripHeight,
+                internalFormat, static_cast<GLsizei>(size), nullptr);
+        }
+        else {
+            glTexSubImage2D(GL_TEXTURE_2D, upload.level, 0, upload.nextRow, level.width, stripHeight,
+                pixelFormat, GL_UNSIGNED_BYTE, nullptr);
+        }
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        nextSlot = (nextSlot + 1) % slots.size();
+
+        upload.nextRow += stripHeight;
+        copied += size;
+        if (upload.nextRow == level.height) {
+            // the level is complete, sample from it from now on
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, upload.level);
+            upload.nextRow = 0;
+            if (--upload.level < 0) uploads.pop_front();
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    reportMemory();
+}
+
+void TextureStreamer::cancel(unsigned int texture) {
+    size_t queued = uploads.size();
+    uploads.erase(std::remove_if(uploads.begin(), uploads.end(), [texture](const Upload& upload) {
+        return upload.texture == texture;
+    }), uploads.end());
+    if (uploads.size() != queued) reportMemory();
+}
+
+bool TextureStreamer::isIdle() const {
+    return uploads.empty();
+}
+
+void TextureStreamer::reportMemory() const {
+    size_t queuedBytes = 0, bufferBytes = 0;
+    for (const Upload& upload : uploads) queuedBytes += upload.image.data.size();
+    for (const Slot& slot : slots) bufferBytes += slot.capacity;
+    MemoryAccounting::get().set(this, MemoryCategory::Staging, "texture streamer", queuedBytes, bufferBytes);
+}
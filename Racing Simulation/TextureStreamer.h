@@ -0,0 +1,75 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <glad/glad.h>
+
+#include "TextureCompression.h"
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+// Levels no larger than this on either side are uploaded at once and shown while the rest streams in
+const int TEXTURE_PLACEHOLDER_SIZE = 32;
+
+// GL internal and pixel transfer formats, pixelFormat is 0 for the block compressed ones
+void textureFormatToGL(TextureFormat format, GLenum& internalFormat, GLenum& pixelFormat);
+
+// Allocates and fills one mip level of target straight from client memory
+void uploadTextureLevel(GLenum target, int level, const TextureImage& image, size_t levelIndex);
+
+// GPU bytes of the first levelCount levels of image in the internal format it is uploaded as
+size_t textureGpuBytes(const TextureImage& image, size_t levelCount = SIZE_MAX);
+
+// Uploads every level of image into texture right away, for callers that cannot wait
+void uploadTextureImmediately(unsigned int texture, const TextureImage& image, GLenum wrap = GL_REPEAT);
+
+// Uploads mip chains without stalling the render thread. stream() allocates every level but fills only
+// the small ones, which become the base level. The larger levels are then copied into a ring of reused
+// pixel buffer objects a few strips per frame, smallest first, and transferred from there by the GPU.
+// The base level steps down as each level completes. A fence per buffer tells when it may be written again.
+class TextureStreamer {
+public:
+    // needs a current GL context
+    TextureStreamer(size_t slotBytes = 4 * 1024 * 1024, unsigned int slotCount = 3);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Defines texture from image and queues its large levels. Takes over the image data.
+    void stream(unsigned int texture, TextureImage& image, GLenum wrap = GL_REPEAT);
+
+    // Once per frame: copies up to budgetBytes of queued levels into buffers the GPU is done with
+    void update(size_t budgetBytes);
+
+    // Drops the queued levels of texture, must be called before the texture is deleted since GL hands a
+    // deleted name straight back to the next glGenTextures
+    void cancel(unsigned int texture);
+
+    bool isIdle() const;
+
+private:
+    // the mip chains waiting in the queue and the pixel buffers
+    void reportMemory() const;
+
+    struct Slot {
+        GLuint buffer = 0;
+        size_t capacity = 0;
+        GLsync fence = 0;   // set after the upload from this buffer was issued
+    };
+
+    struct Upload {
+        unsigned int texture;
+        TextureImage image;
+        int level;     // level being filled, counts down to 0
+        int nextRow;   // in pixels, a multiple of 4 for block compressed levels
+    };
+
+    std::vector<Slot> slots;
+    unsigned int nextSlot = 0;
+    size_t slotBytes;
+    std::deque<Upload> uploads;
+};
+
+#endif
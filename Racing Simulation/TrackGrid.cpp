@@ -0,0 +1,133 @@
+#include "TrackGrid.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+int getGridIndex(int x, int z, int gridWidth) {
+    return z * gridWidth + x;
+}
+
+float calculateOptimalGridSize(const std::vector<CollisionMesh>& trackMeshes, int desiredGridCount) {
+
+    // Initialize min and max bounds
+    glm::vec3 minBounds(FLT_MAX, FLT_MAX, FLT_MAX);
+    glm::vec3 maxBounds(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    for (const CollisionMesh& mesh : trackMeshes) {
+        for (unsigned int i = 0; i < mesh.indices.size(); i++) {
+
+            glm::vec3 vertex = mesh.positions[mesh.indices[i]];
+
+            minBounds = glm::min(minBounds, vertex);
+            maxBounds = glm::max(maxBounds, vertex);
+
+        }
+    }
+
+    // Calculate the dimensions of the bounding box for the entire track
+    glm::vec3 trackSize = maxBounds - minBounds;
+
+    // Find the maximum extent along the X and Z axes (for 2D grid division)
+    float maxDimension = glm::max(trackSize.x, trackSize.z);
+
+    // Calculate the optimal grid size based on the desired number of grids
+    float gridSize = maxDimension / desiredGridCount;
+
+    return gridSize;
+}
+
+void assignTrianglesToGrid(const std::vector<CollisionMesh>& trackMeshes, float gridSize, int gridWidth, int gridHeight, std::vector<std::vector<Triangle>>& gridCells) {
+    PROFILE_ZONE("Grid construction");
+
+    // Resize gridCells
+    gridCells.resize(gridWidth * gridHeight);
+
+    for (const CollisionMesh& mesh : trackMeshes) {
+        for (unsigned int i = 0; i < mesh.indices.size(); i += 3) {
+
+            glm::vec3 v0 = mesh.positions[mesh.indices[i]];
+            glm::vec3 v1 = mesh.positions[mesh.indices[i + 1]];
+            glm::vec3 v2 = mesh.positions[mesh.indices[i + 2]];
+
+            // min and maxx and z coordinates of the triangle
+            float minX = std::min({ v0.x, v1.x, v2.x });
+            float maxX = std::max({ v0.x, v1.x, v2.x });
+            float minZ = std::min({ v0.z, v1.z, v2.z });
+            float maxZ = std::max({ v0.z, v1.z, v2.z });
+
+            //grid cells that the triangle overlaps (how far way the point is from the origin in terms of grid cells)
+            int minGridX = static_cast<int>(floor(minX / gridSize));
+            int maxGridX = static_cast<int>(floor(maxX / gridSize));
+            int minGridZ = static_cast<int>(floor(minZ / gridSize));
+            int maxGridZ = static_cast<int>(floor(maxZ / gridSize));
+
+            // Clamp grid coordinates to ensure they stay within the grid boundaries
+            minGridX = std::max(0, std::min(gridWidth - 1, minGridX));
+            maxGridX = std::max(0, std::min(gridWidth - 1, maxGridX));
+            minGridZ = std::max(0, std::min(gridHeight - 1, minGridZ));
+            maxGridZ = std::max(0, std::min(gridHeight - 1, maxGridZ));
+
+            Triangle tri = { v0, v1, v2 };
+
+            // Assign the triangle to the relevant grid cells
+            for (int x = minGridX; x <= maxGridX; ++x) {
+                for (int z = minGridZ; z <= maxGridZ; ++z) {
+                    int index = getGridIndex(x, z, gridWidth);
+                    gridCells[index].push_back(tri);
+                }
+            }
+        }
+    }
+}
+
+void checkTrackSize(const std::vector<CollisionMesh>& trackMeshes) {
+
+    int minX = 0;
+    int maxX = 0;
+
+    for (const CollisionMesh& mesh : trackMeshes) {
+        for (unsigned int i = 0; i < mesh.indices.size(); i += 3) {
+
+            glm::vec3 v0 = mesh.positions[mesh.indices[i]];
+            glm::vec3 v1 = mesh.positions[mesh.indices[i + 1]];
+            glm::vec3 v2 = mesh.positions[mesh.indices[i + 2]];
+
+            if (v0.x < minX) minX = v0.x;
+            if (v1.x < minX) minX = v1.x;
+            if (v2.x < minX) minX = v2.x;
+
+            if (v0.x > maxX) maxX = v0.x;
+            if (v1.x > maxX) maxX = v1.x;
+            if (v2.x > maxX) maxX = v2.x;
+
+        }
+    }
+
+    std::cout << "Minimum X: " << minX << "Maximum Y" << maxX << std::endl;
+
+}
+
+std::string describeGridOccupancy(const std::vector<std::vector<Triangle>>& gridCells) {
+    size_t total = 0, most = 0, empty = 0;
+    for (const std::vector<Triangle>& cell : gridCells) {
+        total += cell.size();
+        most = std::max(most, cell.size());
+        if (cell.empty()) empty++;
+    }
+    std::ostringstream text;
+    text << gridCells.size() << " cells, " << total << " triangle references, " << (gridCells.empty() ? 0 : total / gridCells.size())
+         << " per cell on average, " << most << " in the fullest, " << empty << " empty";
+    return text.str();
+}
+
+size_t gridMemoryBytes(const std::vector<std::vector<Triangle>>& gridCells) {
+    size_t bytes = gridCells.capacity() * sizeof(std::vector<Triangle>);
+    for (const std::vector<Triangle>& cell : gridCells) {
+        bytes += cell.capacity() * sizeof(Triangle);
+    }
+    return bytes;
+}
@@ -0,0 +1,20 @@
+#ifndef TRACK_GRID_H
+#define TRACK_GRID_H
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#include "CollisionChecker.h"
+
+// Uniform XZ grid over the track triangles, built once at startup and handed to the CollisionChecker.
+int getGridIndex(int x, int z, int gridWidth);
+float calculateOptimalGridSize(const std::vector<CollisionMesh>& trackMeshes, int desiredGridCount);
+void assignTrianglesToGrid(const std::vector<CollisionMesh>& trackMeshes, float gridSize, int gridWidth, int gridHeight, std::vector<std::vector<Triangle>>& gridCells);
+void checkTrackSize(const std::vector<CollisionMesh>& trackMeshes);
+// one line summary of how evenly the triangles spread over the cells
+std::string describeGridOccupancy(const std::vector<std::vector<Triangle>>& gridCells);
+// heap bytes of the cell vectors and the triangles they hold
+size_t gridMemoryBytes(const std::vector<std::vector<Triangle>>& gridCells);
+
+#endif
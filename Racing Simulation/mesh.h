@@ -7,7 +7,11 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "shader.h"
+#include "RenderStats.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <string>
 #include <vector>
 using namespace std;
@@ -31,10 +35,53 @@ struct Vertex {
     float m_Weights[MAX_BONE_INFLUENCE];
 };
 
+// Compact layout used for static (unskinned) meshes, 20 bytes instead of the 136 of Vertex.
+// Position: xyz quantized to 16 bits inside the mesh bounds (see Mesh::positionScale/positionOffset),
+//           w holds the bitangent sign (0 = -1, 65535 = +1)
+// Normal, Tangent: octahedral encoded into two 16 bit snorms, the bitangent is cross(N, T) * sign
+// TexCoords: quantized to 16 bits inside the mesh's UV bounds (see Mesh::uvScale/uvOffset)
+struct PackedVertex {
+    uint16_t Position[4];
+    int16_t Normal[2];
+    int16_t Tangent[2];
+    uint16_t TexCoords[2];
+};
+
+// Vertex layout a mesh is uploaded with, chosen per mesh at import time
+enum class VertexFormat {
+    Full,   // Vertex as is, only needed when the mesh carries bone weights
+    Packed  // PackedVertex
+};
+
 struct Texture {
     unsigned int id;
     string type;
     string path;
+    int twoChannel = -1;   // normal maps: 1 when only x and y are stored (BC5), -1 until asked, see Mesh::Draw
+};
+
+// meshes with at most this many vertices upload 16 bit indices
+const size_t MAX_SHORT_INDEX_VERTICES = 65536;
+
+// CPU side mesh produced by the importer, optimized (see MeshOptimizer.h) before it becomes a Mesh
+struct MeshData {
+    vector<Vertex>       vertices;
+    vector<unsigned int> indices;
+    vector<Texture>      textures;
+    unsigned int         materialIndex = 0;
+    VertexFormat         format = VertexFormat::Packed;
+};
+
+// How the GPU buffers of a mesh are laid out and how the vertex shaders decode them
+struct MeshLayout {
+    VertexFormat format = VertexFormat::Full;
+    // GL_UNSIGNED_SHORT when the vertex count allows it, the CPU side indices stay 32 bit
+    GLenum indexType = GL_UNSIGNED_INT;
+    // decode of the quantized packed attributes in the vertex shaders: value * scale + offset
+    glm::vec3 positionScale = glm::vec3(1.0f);
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec2 uvScale = glm::vec2(1.0f);
+    glm::vec2 uvOffset = glm::vec2(0.0f);
 };
 
 class Mesh {
@@ -44,16 +91,77 @@ public:
     vector<unsigned int> indices;
     vector<Texture>      textures;
     unsigned int VAO;
+    unsigned int indexCount = 0;  // in the EBO, indices above may be empty once uploaded
+    size_t gpuBytes = 0;          // VBO plus EBO
+
+    // GPU buffer layout, the CPU side vertices above keep full precision
+    MeshLayout layout;
 
     // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, VertexFormat format = VertexFormat::Full)
     {
         this->vertices = vertices;
         this->indices = indices;
         this->textures = textures;
+        this->indexCount = static_cast<unsigned int>(this->indices.size());
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        vector<char> vertexBytes, indexBytes;
+        layout = buildBuffers(this->vertices, this->indices, format, vertexBytes, indexBytes);
+        setupMesh(vertexBytes.data(), vertexBytes.size(), indexBytes.data(), indexBytes.size());
+    }
+
+    // uploads vertex and index data that is already in GPU layout, e.g. straight out of a mapped model cache file.
+    // vertices/indices are only kept for CPU side queries and may be left empty.
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, const MeshLayout& layout,
+        const void* vertexBytes, size_t vertexSize, const void* indexBytes, size_t indexSize)
+    {
+        this->vertices = vertices;
+        this->indices = indices;
+        this->textures = textures;
+        this->layout = layout;
+        this->indexCount = static_cast<unsigned int>(indexSize / (layout.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int)));
+        setupMesh(vertexBytes, vertexSize, indexBytes, indexSize);
+    }
+
+    // deletes the GL objects, the mesh must not be drawn afterwards
+    void release()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        VAO = VBO = EBO = 0;
+        gpuBytes = 0;
+    }
+
+    // converts CPU side vertices and indices into the bytes uploaded to the VBO and EBO
+    static MeshLayout buildBuffers(const vector<Vertex>& vertices, const vector<unsigned int>& indices, VertexFormat format,
+        vector<char>& vertexBytes, vector<char>& indexBytes)
+    {
+        MeshLayout layout;
+        layout.format = format;
+
+        if (vertices.size() <= MAX_SHORT_INDEX_VERTICES) {
+            layout.indexType = GL_UNSIGNED_SHORT;
+            indexBytes.resize(indices.size() * sizeof(uint16_t));
+            uint16_t* shortIndices = reinterpret_cast<uint16_t*>(indexBytes.data());
+            for (size_t i = 0; i < indices.size(); i++)
+                shortIndices[i] = static_cast<uint16_t>(indices[i]);
+        }
+        else {
+            layout.indexType = GL_UNSIGNED_INT;
+            indexBytes.resize(indices.size() * sizeof(unsigned int));
+            std::copy(indices.begin(), indices.end(), reinterpret_cast<unsigned int*>(indexBytes.data()));
+        }
+
+        if (format == VertexFormat::Packed) {
+            packVertices(vertices, layout, vertexBytes);
+        }
+        else {
+            const char* begin = reinterpret_cast<const char*>(vertices.data());
+            vertexBytes.assign(begin, begin + vertices.size() * sizeof(Vertex));
+        }
+        return layout;
     }
 
     // render the mesh
@@ -98,6 +206,7 @@ public:
 
     void Draw(Shader& shader) {
         unsigned int albedoNr = 1, normalNr = 1, metallicNr = 1, roughnessNr = 1, aoNr = 1;
+        bool twoChannelNormals = false;
 
         for (unsigned int i = 0; i < textures.size(); i++) {
             glActiveTexture(GL_TEXTURE0 + i + 3);
@@ -117,10 +226,20 @@ public:
 
             shader.setInt(name + number, i + 3);
             glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            if (name == "texture_normal")
+                twoChannelNormals = isTwoChannel(textures[i]);
         }
+        shader.setBool("normalMapTwoChannel", twoChannelNormals);
+
+        shader.setBool("packedVertex", layout.format == VertexFormat::Packed);
+        shader.setVec3("positionScale", layout.positionScale);
+        shader.setVec3("positionOffset", layout.positionOffset);
+        shader.setVec2("uvScale", layout.uvScale);
+        shader.setVec2("uvOffset", layout.uvOffset);
 
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, indexCount, layout.indexType, 0);
+        renderStats.addDraw(indexCount / 3);
         glBindVertexArray(0);
         glActiveTexture(GL_TEXTURE0);
     }
@@ -130,8 +249,23 @@ private:
     // render data 
     unsigned int VBO, EBO;
 
+    // Cooked normal maps are BC5, sources without a cooked copy come in as RGB. Shared textures may be
+    // uploaded by another model after this mesh was built, so GL is asked once the bound texture has a level 0.
+    static bool isTwoChannel(Texture& texture)
+    {
+        if (texture.twoChannel < 0) {
+            GLint width = 0, internalFormat = 0;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+            if (width == 0)
+                return false;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+            texture.twoChannel = internalFormat == GL_COMPRESSED_RG_RGTC2 ? 1 : 0;
+        }
+        return texture.twoChannel == 1;
+    }
+
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    void setupMesh(const void* vertexBytes, size_t vertexSize, const void* indexBytes, size_t indexSize)
     {
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
@@ -141,14 +275,29 @@ private:
         glBindVertexArray(VAO);
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, vertexSize, vertexBytes, GL_STATIC_DRAW);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize, indexBytes, GL_STATIC_DRAW);
+        gpuBytes = vertexSize + indexSize;
+
+        if (layout.format == VertexFormat::Packed) {
+            // all attributes are normalized integers, the shaders decode them with the scale/offset uniforms
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Position));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Normal));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, TexCoords));
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Tangent));
+            glBindVertexArray(0);
+            return;
+        }
 
+        // A great thing about structs is that their memory layout is sequential for all its items.
+        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
+        // again translates to 3/2 floats which translates to a byte array.
         // set the vertex attribute pointers
         // vertex Positions
         glEnableVertexAttribArray(0);
@@ -174,5 +323,78 @@ private:
         glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
         glBindVertexArray(0);
     }
+
+    // packs the vertices into PackedVertex bytes and fills in the decode parameters of the layout
+    static void packVertices(const vector<Vertex>& vertices, MeshLayout& layout, vector<char>& vertexBytes)
+    {
+        glm::vec3 minPosition(0.0f), maxPosition(0.0f);
+        glm::vec2 minUV(0.0f), maxUV(0.0f);
+        if (!vertices.empty()) {
+            minPosition = maxPosition = vertices[0].Position;
+            minUV = maxUV = vertices[0].TexCoords;
+        }
+        for (const Vertex& vertex : vertices) {
+            minPosition = glm::min(minPosition, vertex.Position);
+            maxPosition = glm::max(maxPosition, vertex.Position);
+            minUV = glm::min(minUV, vertex.TexCoords);
+            maxUV = glm::max(maxUV, vertex.TexCoords);
+        }
+        layout.positionOffset = minPosition;
+        layout.positionScale = maxPosition - minPosition;
+        layout.uvOffset = minUV;
+        layout.uvScale = maxUV - minUV;
+
+        vertexBytes.resize(vertices.size() * sizeof(PackedVertex));
+        PackedVertex* packed = reinterpret_cast<PackedVertex*>(vertexBytes.data());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            const Vertex& vertex = vertices[i];
+            PackedVertex& out = packed[i];
+
+            glm::vec3 normal = safeNormalize(vertex.Normal, glm::vec3(0.0f, 1.0f, 0.0f));
+            glm::vec3 tangent = safeNormalize(vertex.Tangent, glm::vec3(1.0f, 0.0f, 0.0f));
+            bool positiveBitangent = glm::dot(glm::cross(normal, tangent), vertex.Bitangent) >= 0.0f;
+
+            for (int c = 0; c < 3; c++)
+                out.Position[c] = quantizeUnorm16(vertex.Position[c], layout.positionOffset[c], layout.positionScale[c]);
+            out.Position[3] = positiveBitangent ? 65535 : 0;
+            octEncode(normal, out.Normal);
+            octEncode(tangent, out.Tangent);
+            for (int c = 0; c < 2; c++)
+                out.TexCoords[c] = quantizeUnorm16(vertex.TexCoords[c], layout.uvOffset[c], layout.uvScale[c]);
+        }
+    }
+
+    static glm::vec3 safeNormalize(const glm::vec3& v, const glm::vec3& fallback)
+    {
+        float length = glm::length(v);
+        // meshes without normals or UVs leave these uninitialized, so also reject NaN
+        return length > 1e-6f ? v / length : fallback;
+    }
+
+    static uint16_t quantizeUnorm16(float value, float offset, float scale)
+    {
+        if (scale <= 0.0f)
+            return 0;
+        float t = std::min(std::max((value - offset) / scale, 0.0f), 1.0f);
+        return static_cast<uint16_t>(std::lround(t * 65535.0f));
+    }
+
+    static int16_t toSnorm16(float value)
+    {
+        return static_cast<int16_t>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+    }
+
+    // octahedral encoding, maps the unit sphere onto the [-1, 1] square
+    static void octEncode(const glm::vec3& n, int16_t out[2])
+    {
+        glm::vec3 v = n / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+        glm::vec2 e(v.x, v.y);
+        if (v.z < 0.0f) {
+            e = glm::vec2((1.0f - std::abs(v.y)) * (v.x >= 0.0f ? 1.0f : -1.0f),
+                          (1.0f - std::abs(v.x)) * (v.y >= 0.0f ? 1.0f : -1.0f));
+        }
+        out[0] = toSnorm16(e.x);
+        out[1] = toSnorm16(e.y);
+    }
 };
 #endif
\ No newline at end of file
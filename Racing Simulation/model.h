@@ -11,24 +11,48 @@
 #include <assimp/postprocess.h>
 
 #include "mesh.h"
+#include "CollisionChecker.h"
 #include "shader.h"
+#include "MeshOptimizer.h"
+#include "ModelCache.h"
+#include "FileUtils.h"
+#include "TextureStreamer.h"
+#include "TextureCooker.h"
+#include "TextureRegistry.h"
+#include "MemoryAccounting.h"
+#include "Profiler.h"
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 using namespace std;
 
 unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false);
 
+TextureImage decodeTextureFile(const char* path, const string& directory, TextureUsage usage = TextureUsage::Color);
+TextureUsage textureUsageForType(const string& type);
+
+// What a model is loaded for. Render meshes drop their CPU copies once uploaded, collision meshes never
+// touch GL and keep only welded positions and triangle indices.
+enum class ModelLoadMode {
+    Full,           // drawn and queried on the CPU
+    RenderOnly,
+    CollisionOnly
+};
+
 class Model
 {
 public:
     // model data 
     vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    unordered_map<string, size_t> textureIndices;  // path -> index into textures_loaded
     vector<Mesh>    meshes;
+    vector<CollisionMesh> collisionMeshes;  // empty for RenderOnly
     string directory;
     bool gammaCorrection;
     glm::vec3 startPosition;
@@ -37,6 +61,53 @@ public:
     Model(string const& path, bool gamma = false) : gammaCorrection(gamma)
     {
         loadModel(path);
+        while (!uploadStep()) {}
+    }
+
+    // empty model, filled in two stages: loadModel on any thread, then uploadStep on the GL thread (see AssetLoader)
+    explicit Model(ModelLoadMode mode = ModelLoadMode::Full) : gammaCorrection(false), loadMode(mode) {}
+
+    // the textures are shared through the registry, give back this model's references
+    ~Model()
+    {
+        releaseTextures();
+        forgetMemory();
+    }
+
+    // GL thread: frees everything loadModel and uploadStep created, the model can be loaded again afterwards
+    void unload()
+    {
+        for (Mesh& mesh : meshes)
+            mesh.release();
+        releaseTextures();
+        meshes.clear();
+        collisionMeshes.clear();
+        textures_loaded.clear();
+        textureIndices.clear();
+        pendingMeshes.clear();
+        uploadedMeshes = 0;
+        cacheFile.close();
+        ownedTextureBytes = 0;
+        ready = false;
+        forgetMemory();
+    }
+
+    // bytes held in RAM and on the GPU, textures count for the model that uploaded them
+    void memoryUsage(size_t& cpuBytes, size_t& gpuBytes) const
+    {
+        cpuBytes = 0;
+        gpuBytes = ownedTextureBytes;
+        for (const CollisionMesh& mesh : collisionMeshes)
+            cpuBytes += mesh.positions.size() * sizeof(glm::vec3) + mesh.indices.size() * sizeof(unsigned int);
+        for (const Mesh& mesh : meshes) {
+            cpuBytes += mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(unsigned int);
+            gpuBytes += mesh.gpuBytes;
+        }
+    }
+
+    // hands the textures to streamer instead of uploading them whole in uploadStep
+    void setTextureStreamer(TextureStreamer* streamer) {
+        textureStreamer = streamer;
     }
 
     glm::vec3 getStartPosition() const {
@@ -50,28 +121,312 @@ public:
             meshes[i].Draw(shader);
     }
 
+    // CPU stage: reads the cooked cache or imports the file with ASSIMP, and decodes all textures.
+    // Makes no GL calls, so it can run on a worker thread.
+    // decodeTextures = false only gathers the texture references, see textureReferences
+    void loadModel(string const& path, bool decodeTextures = true)
+    {
+        PROFILE_ZONE("Model load");
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+        sourcePath = path;
+
+        // a cooked copy skips Assimp and the optimizer entirely
+        ModelCache cache(MODEL_CACHE_DIRECTORY);
+        vector<CachedMesh> cachedMeshes;
+        if (cache.load(path, cacheFile, cachedMeshes)) {
+            prepareCachedMeshes(cachedMeshes);
+            // collision data is copied out, nothing left to read from the mapping
+            if (loadMode == ModelLoadMode::CollisionOnly)
+                cacheFile.close();
+        }
+        else {
+            // read file via ASSIMP
+            Assimp::Importer importer;
+            const aiScene* scene;
+            {
+                PROFILE_ZONE("Assimp import");
+                scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+            }
+            // check for errors
+            if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+            {
+                cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
+                return;
+            }
+
+            // process ASSIMP's root node recursively
+            vector<MeshData> meshData;
+            processNode(scene->mRootNode, scene, meshData);
+
+            // weld, merge and reorder before anything is uploaded
+            MeshOptimizationStats stats;
+            optimizeMeshes(meshData, stats);
+            stats.print(fileNameFromPath(path));
+            cache.save(path, meshData);
+
+            prepareImportedMeshes(meshData);
+        }
+
+        // every path once, the first mesh referencing a path decides its type and usage. Only textures
+        // no other model (or this one) has claimed yet are decoded, the rest share the registry's copy.
+        unordered_set<string> seen;
+        for (const PendingMesh& pending : pendingMeshes) {
+            for (const CachedTextureRef& ref : pending.textures) {
+                if (!seen.insert(ref.path).second)
+                    continue;
+
+                PendingTexture texture;
+                texture.path = ref.path;
+                texture.type = ref.type;
+                if (decodeTextures) {
+                    TextureUsage usage = textureUsageForType(ref.type);
+                    texture.key = TextureRegistry::get().makeKey(directory + '/' + ref.path, usage);
+                    texture.owner = TextureRegistry::get().claim(texture.key);
+                    texture.claimed = true;
+                    if (texture.owner)
+                        texture.image = decodeTextureFile(ref.path.c_str(), directory, usage);
+                }
+                pendingTextures.push_back(std::move(texture));
+            }
+        }
+    }
+
+    // GL stage: uploads one texture or one mesh per call, returns true once the model is complete
+    bool uploadStep()
+    {
+        if (uploadedTextures < pendingTextures.size()) {
+            PendingTexture& pending = pendingTextures[uploadedTextures++];
+            if (pending.claimed && !pending.owner && TextureRegistry::get().adopt(pending.key)) {
+                // the model that claimed it first went away before uploading, decode it here instead
+                pending.owner = true;
+                pending.image = decodeTextureFile(pending.path.c_str(), directory, textureUsageForType(pending.type));
+            }
+            Texture texture;
+            texture.id = pending.claimed ? TextureRegistry::get().acquire(pending.key) : 0;
+            texture.type = pending.type;
+            texture.path = pending.path;
+            if (pending.claimed)
+                textureKeys.push_back(pending.key);
+
+            if (pending.owner) {
+                // before the streamer takes over the pixels
+                size_t gpuBytes = textureGpuBytes(pending.image);
+                ownedTextureBytes += gpuBytes;
+                TextureRegistry::get().finishUpload(pending.key, directory + '/' + pending.path, gpuBytes);
+                if (pending.image.empty())
+                    std::cout << "Texture failed to load at path: " << pending.path << std::endl;
+                else if (textureStreamer)
+                    textureStreamer->stream(texture.id, pending.image);
+                else
+                    uploadTextureImmediately(texture.id, pending.image);
+
+                // Debugging: Notify that this texture was successfully loaded
+                std::cout << "Loaded texture: " << texture.path << " as type: " << texture.type << std::endl;
+            }
+            textureIndices[texture.path] = textures_loaded.size();
+            textures_loaded.push_back(texture);
+            return false;
+        }
+
+        if (uploadedMeshes < pendingMeshes.size()) {
+            PendingMesh& pending = pendingMeshes[uploadedMeshes++];
+            vector<Texture> textures;
+            for (const CachedTextureRef& ref : pending.textures) {
+                auto found = textureIndices.find(ref.path);
+                if (found != textureIndices.end())
+                    textures.push_back(textures_loaded[found->second]);
+            }
+
+            // imported meshes own their bytes, cached ones point into the mapped file
+            const char* vertexData = pending.vertexBytes.empty() ? pending.mappedVertexData : pending.vertexBytes.data();
+            const char* indexData = pending.indexBytes.empty() ? pending.mappedIndexData : pending.indexBytes.data();
+            meshes.push_back(Mesh(vector<Vertex>(), vector<unsigned int>(), textures, pending.layout,
+                vertexData, pending.vertexSize, indexData, pending.indexSize));
+            return false;
+        }
+
+        // everything is on the GPU, drop the staging data and the mapping
+        pendingMeshes.clear();
+        pendingTextures.clear();
+        uploadedMeshes = uploadedTextures = 0;
+        cacheFile.close();
+        ready = true;
+        reportMemory();
+        return true;
+    }
+
+    bool isReady() const {
+        return ready;
+    }
+
+    // distinct textures found by loadModel, paths relative to directory
+    vector<CachedTextureRef> textureReferences() const {
+        vector<CachedTextureRef> references;
+        for (const PendingTexture& texture : pendingTextures)
+            references.push_back({ texture.type, texture.path });
+        return references;
+    }
+
 private:
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel(string const& path)
+    // a mesh whose CPU side work is done and only needs its GL buffers
+    struct PendingMesh {
+        vector<CachedTextureRef> textures;
+        MeshLayout layout;
+        vector<char> vertexBytes;                 // GPU layout, filled for imported meshes
+        vector<char> indexBytes;
+        const char* mappedVertexData = nullptr;   // GPU layout inside cacheFile, for cached meshes
+        const char* mappedIndexData = nullptr;
+        size_t vertexSize = 0;
+        size_t indexSize = 0;
+    };
+
+    struct PendingTexture {
+        string path;
+        string type;
+        TextureKey key;
+        bool claimed = false; // holds a registry reference, only when loadModel decoded textures
+        bool owner = false;   // this model claimed the key first and uploads the pixels
+        TextureImage image;
+    };
+
+    // gives back the registry references, owners that have not uploaded yet let another model take over
+    void releaseTextures()
     {
-        // read file via ASSIMP
-        Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
-        // check for errors
-        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+        for (const TextureKey& key : textureKeys)
+            TextureRegistry::get().release(key);
+        for (size_t i = uploadedTextures; i < pendingTextures.size(); ++i) {
+            const PendingTexture& pending = pendingTextures[i];
+            if (!pending.claimed)
+                continue;
+            if (pending.owner)
+                TextureRegistry::get().abandon(pending.key);
+            else
+                TextureRegistry::get().release(pending.key);
+        }
+        textureKeys.clear();
+        pendingTextures.clear();
+        uploadedTextures = 0;
+    }
+
+    // meshes and collision meshes for the MemoryAccounting, the textures are reported through the registry
+    void reportMemory() const
+    {
+        size_t meshCpu = 0, meshGpu = 0, collisionCpu = 0;
+        for (const CollisionMesh& mesh : collisionMeshes)
+            collisionCpu += mesh.positions.size() * sizeof(glm::vec3) + mesh.indices.size() * sizeof(unsigned int);
+        for (const Mesh& mesh : meshes) {
+            meshCpu += mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(unsigned int);
+            meshGpu += mesh.gpuBytes;
+        }
+        MemoryAccounting::get().set(this, MemoryCategory::Meshes, sourcePath, meshCpu, meshGpu);
+        MemoryAccounting::get().set(this, MemoryCategory::CollisionMeshes, sourcePath, collisionCpu, 0);
+    }
+
+    void forgetMemory() const
+    {
+        MemoryAccounting::get().remove(this, MemoryCategory::Meshes);
+        MemoryAccounting::get().remove(this, MemoryCategory::CollisionMeshes);
+    }
+
+    string sourcePath;
+    vector<TextureKey> textureKeys;  // one registry reference per uploaded texture, pending ones hold theirs in pendingTextures
+    size_t ownedTextureBytes = 0;    // GPU bytes of the textures this model claimed and uploaded
+
+    ModelLoadMode loadMode = ModelLoadMode::Full;
+    TextureStreamer* textureStreamer = nullptr;
+    MappedFile cacheFile;  // stays mapped until the cached blobs are uploaded
+    vector<PendingMesh> pendingMeshes;
+    vector<PendingTexture> pendingTextures;
+    size_t uploadedMeshes = 0;
+    size_t uploadedTextures = 0;
+    bool ready = false;
+
+    // the CPU side vertices of cached meshes only carry positions
+    void prepareCachedMeshes(const vector<CachedMesh>& cachedMeshes)
+    {
+        for (const CachedMesh& cached : cachedMeshes)
         {
-            cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-            return;
+            if (loadMode != ModelLoadMode::RenderOnly) {
+                vector<unsigned int> indices(cached.indexCount);
+                if (cached.layout.indexType == GL_UNSIGNED_SHORT) {
+                    const uint16_t* shortIndices = reinterpret_cast<const uint16_t*>(cached.indexData);
+                    std::copy(shortIndices, shortIndices + cached.indexCount, indices.begin());
+                }
+                else {
+                    const unsigned int* longIndices = reinterpret_cast<const unsigned int*>(cached.indexData);
+                    std::copy(longIndices, longIndices + cached.indexCount, indices.begin());
+                }
+                collisionMeshes.push_back(makeCollisionMesh(cached.positions, cached.vertexCount, indices));
+            }
+            if (loadMode == ModelLoadMode::CollisionOnly)
+                continue;
+
+            PendingMesh pending;
+            pending.textures = cached.textures;
+            pending.layout = cached.layout;
+            pending.mappedVertexData = cached.vertexData;
+            pending.mappedIndexData = cached.indexData;
+            pending.vertexSize = cached.vertexSize;
+            pending.indexSize = cached.indexSize;
+            pendingMeshes.push_back(std::move(pending));
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
+    }
 
-        // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+    // welds the positions alone, render vertices that only differ in normal or uv collapse into one
+    static CollisionMesh makeCollisionMesh(const glm::vec3* positions, size_t positionCount, const vector<unsigned int>& indices)
+    {
+        CollisionMesh mesh;
+        vector<unsigned int> remap(positionCount);
+        unordered_map<uint64_t, vector<unsigned int>> buckets;
+        for (size_t i = 0; i < positionCount; i++) {
+            uint64_t hash = hashBytes(&positions[i], sizeof(glm::vec3));
+            vector<unsigned int>& bucket = buckets[hash];
+            unsigned int match = static_cast<unsigned int>(mesh.positions.size());
+            for (unsigned int candidate : bucket) {
+                if (mesh.positions[candidate] == positions[i]) {
+                    match = candidate;
+                    break;
+                }
+            }
+            if (match == mesh.positions.size()) {
+                bucket.push_back(match);
+                mesh.positions.push_back(positions[i]);
+            }
+            remap[i] = match;
+        }
+
+        mesh.indices.resize(indices.size());
+        for (size_t i = 0; i < indices.size(); i++)
+            mesh.indices[i] = remap[indices[i]];
+        return mesh;
+    }
+
+    void prepareImportedMeshes(vector<MeshData>& meshData)
+    {
+        for (MeshData& data : meshData)
+        {
+            if (loadMode != ModelLoadMode::RenderOnly) {
+                vector<glm::vec3> positions(data.vertices.size());
+                for (size_t i = 0; i < data.vertices.size(); i++)
+                    positions[i] = data.vertices[i].Position;
+                collisionMeshes.push_back(makeCollisionMesh(positions.data(), positions.size(), data.indices));
+            }
+            if (loadMode == ModelLoadMode::CollisionOnly)
+                continue;
+
+            PendingMesh pending;
+            pending.layout = Mesh::buildBuffers(data.vertices, data.indices, data.format, pending.vertexBytes, pending.indexBytes);
+            pending.vertexSize = pending.vertexBytes.size();
+            pending.indexSize = pending.indexBytes.size();
+            for (const Texture& texture : data.textures)
+                pending.textures.push_back({ texture.type, texture.path });
+            pendingMeshes.push_back(std::move(pending));
+        }
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode* node, const aiScene* scene)
+    void processNode(aiNode* node, const aiScene* scene, vector<MeshData>& meshData)
     {
         // process each mesh located at the current node
         for (unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -79,17 +434,17 @@ private:
             // the node object only contains indices to index the actual objects in the scene. 
             // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            meshData.push_back(processMesh(mesh, scene));
         }
         // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for (unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, meshData);
         }
 
     }
 
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene)
+    MeshData processMesh(aiMesh* mesh, const aiScene* scene)
     {
         // data to fill
         vector<Vertex> vertices;
@@ -99,7 +454,7 @@ private:
         // walk through each of the mesh's vertices
         for (unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex;
+            Vertex vertex = {}; // zeroed so unused attributes don't stop identical vertices from welding
             glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
             // positions
             vector.x = mesh->mVertices[i].x;
@@ -184,13 +539,20 @@ private:
         vector<Texture> aoMaps = loadMaterialTextures(material, aiTextureType_AMBIENT_OCCLUSION, "texture_ao");
         textures.insert(textures.end(), aoMaps.begin(), aoMaps.end());
 
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        // return the extracted mesh data, it becomes a Mesh once the whole model is optimized
+        MeshData data;
+        data.vertices = std::move(vertices);
+        data.indices = std::move(indices);
+        data.textures = std::move(textures);
+        data.materialIndex = mesh->mMaterialIndex;
+        // none of our meshes are skinned, so only meshes that actually carry bones need the full vertex layout
+        data.format = mesh->HasBones() ? VertexFormat::Full : VertexFormat::Packed;
+        return data;
 
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
+    // collects the material textures of a given type, they are decoded once per path after all meshes are processed.
+    // the required info is returned as a Texture struct without a GL id yet.
     vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName) {
         vector<Texture> textures;
         for (unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
@@ -200,29 +562,11 @@ private:
             // Debugging: Output the texture type and path
             std::cout << "Checking texture: " << str.C_Str() << " for type: " << typeName << std::endl;
 
-            bool skip = false;
-            for (unsigned int j = 0; j < textures_loaded.size(); j++) {
-                if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0) {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true;
-
-                    // Debugging: Notify that this texture was skipped because it was already loaded
-                    std::cout << "Skipping texture (already loaded): " << str.C_Str() << std::endl;
-                    break;
-                }
-            }
-            if (!skip) {
-                // If texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);  // Assuming TextureFromFile is your custom function
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);
-
-                // Debugging: Notify that this texture was successfully loaded
-                std::cout << "Loaded texture: " << str.C_Str() << " as type: " << typeName << std::endl;
-            }
+            Texture texture;
+            texture.id = 0;
+            texture.type = typeName;
+            texture.path = str.C_Str();
+            textures.push_back(texture);
         }
         return textures;
     }
@@ -230,42 +574,41 @@ private:
 
 
 unsigned int TextureFromFile(const char* path, const string& directory, bool gamma)
+{
+    string filename = directory + '/' + string(path);
+    TextureKey key = TextureRegistry::get().makeKey(filename, TextureUsage::Color);
+    bool owner = TextureRegistry::get().claim(key);
+    unsigned int textureID = TextureRegistry::get().acquire(key);
+    if (owner)
+    {
+        TextureImage image = decodeTextureFile(path, directory);
+        TextureRegistry::get().finishUpload(key, filename, textureGpuBytes(image));
+        if (!image.empty())
+            uploadTextureImmediately(textureID, image);
+        else
+            std::cout << "Texture failed to load at path: " << path << std::endl;
+    }
+    return textureID;
+}
+
+// cooked mip chain when there is one, otherwise stb_image, safe to call from worker threads
+TextureImage decodeTextureFile(const char* path, const string& directory, TextureUsage usage)
 {
     string filename = string(path);
     filename = directory + '/' + filename;
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
+    return loadTextureImage(filename, usage);
+}
 
-    return textureID;
+// the sampler names used by the PBR materials, see processMesh
+TextureUsage textureUsageForType(const string& type)
+{
+    if (type == "texture_albedo")
+        return TextureUsage::Albedo;
+    if (type == "texture_normal")
+        return TextureUsage::Normal;
+    if (type == "texture_metallic" || type == "texture_roughness" || type == "texture_ao")
+        return TextureUsage::Mask;
+    return TextureUsage::Color;
 }
 #endif
\ No newline at end of file
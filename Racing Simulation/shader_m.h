@@ -4,6 +4,9 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "Profiler.h"
+#include "ShaderCache.h"
+
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -17,6 +20,7 @@ public:
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath)
     {
+        PROFILE_ZONE("Shader compile");
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -69,6 +73,10 @@ public:
         glDeleteShader(vertex);
         glDeleteShader(fragment);
 
+    }
+    // takes the program from the binary cache, it may still be compiling until cache.finishPending()
+    Shader(const char* vertexPath, const char* fragmentPath, ShaderCache& cache) : ID(cache.createProgram(vertexPath, fragmentPath))
+    {
     }
     // activate the shader
     // ------------------------------------------------------------------------